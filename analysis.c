@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "structs.h"
+#include "analysis.h"
+
+void analysis_init(struct AnalysisSet *p_set)
+{
+    memset(p_set, 0, sizeof(*p_set));
+}
+
+bool analysis_add(struct AnalysisSet *p_set, const struct Analysis *p_analysis)
+{
+    if (p_set->num >= ANALYSIS_NUM_MAX)
+    {
+        fprintf(stderr, "Warning: analysis %s not registered, at most %d analyses\n", p_analysis->name, ANALYSIS_NUM_MAX);
+        if (p_analysis->free)
+            p_analysis->free(p_analysis->state);
+        return false;
+    }
+    struct Analysis *p_new = &p_set->analyses[p_set->num++];
+    *p_new = *p_analysis;
+    p_new->num_samples = 0;
+    p_set->fields |= p_analysis->fields;
+    p_set->contacts = p_set->contacts || p_analysis->contacts;
+    return true;
+}
+
+static bool analysis_due_one(const struct Analysis *p_analysis, size_t step)
+{
+    return p_analysis->num_dt > 0 && step % p_analysis->num_dt == 0;
+}
+
+bool analysis_due(const struct AnalysisSet *p_set, size_t step)
+{
+    for (size_t k = 0; k < p_set->num; ++k)
+        if (analysis_due_one(&p_set->analyses[k], step))
+            return true;
+    return false;
+}
+
+unsigned int analysis_mask_due(const struct AnalysisSet *p_set, size_t step)
+{
+    unsigned int mask = 0u;
+    for (size_t k = 0; k < p_set->num; ++k)
+        if (analysis_due_one(&p_set->analyses[k], step))
+            mask |= 1u << k;
+    return mask;
+}
+
+unsigned int analysis_fields_due(const struct AnalysisSet *p_set, size_t step)
+{
+    unsigned int fields = 0u;
+    for (size_t k = 0; k < p_set->num; ++k)
+        if (analysis_due_one(&p_set->analyses[k], step))
+            fields |= p_set->analyses[k].fields;
+    return fields;
+}
+
+void analysis_sample(struct AnalysisSet *p_set, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    for (size_t k = 0; k < p_set->num; ++k)
+    {
+        struct Analysis *p_analysis = &p_set->analyses[k];
+        if (p_snap->analyses & (1u << k))
+        {
+            p_analysis->sample(p_analysis, p_parameters, p_snap);
+            p_analysis->num_samples++;
+        }
+    }
+}
+
+bool analysis_merge(struct AnalysisSet *p_set, const struct AnalysisSet *p_other)
+{
+    if (p_set->num != p_other->num)
+        return false;
+    for (size_t k = 0; k < p_set->num; ++k)
+        if (p_set->analyses[k].merge == NULL || strcmp(p_set->analyses[k].name, p_other->analyses[k].name) != 0)
+            return false;
+    for (size_t k = 0; k < p_set->num; ++k)
+    {
+        p_set->analyses[k].merge(&p_set->analyses[k], &p_other->analyses[k]);
+        p_set->analyses[k].num_samples += p_other->analyses[k].num_samples;
+    }
+    return true;
+}
+
+void analysis_finish(struct AnalysisSet *p_set, struct Parameters *p_parameters, struct Vectors *p_vectors,
+                     struct Colllist *p_colllist, size_t step, size_t phase)
+{
+    // read-only view of the final state; its contact stress and neighbor list pairs are not included
+    struct Snapshot snap = {.step = step, .phase = phase, .time = p_vectors->time, .num_contacts = p_colllist->num_nbrs,
+                            .tasks = OUTPUT_TASK_ANALYSIS, .num_part = p_parameters->num_part, .radius = p_vectors->radius,
+                            .r = p_vectors->r, .v = p_vectors->v, .omega = p_vectors->omega, .f = p_vectors->f,
+                            .image = p_vectors->image, .type = p_vectors->type, .contacts = p_colllist->nbr,
+                            .fn_sq = p_colllist->fn_sq, .ft_sq = p_colllist->ft_sq, .fij = p_colllist->fij,
+                            .num_contacts_max = p_colllist->num_nbrs};
+    for (size_t k = 0; k < p_set->num; ++k)
+    {
+        struct Analysis *p_analysis = &p_set->analyses[k];
+        if (p_analysis->final)
+        {
+            p_analysis->sample(p_analysis, p_parameters, &snap);
+            p_analysis->num_samples++;
+        }
+        if (p_analysis->num_samples == 0)
+            fprintf(stderr, "No samples for analysis %s\n", p_analysis->name);
+        else
+            p_analysis->finish(p_analysis, p_parameters);
+    }
+    analysis_free(p_set);
+}
+
+void analysis_free(struct AnalysisSet *p_set)
+{
+    for (size_t k = 0; k < p_set->num; ++k)
+        if (p_set->analyses[k].free)
+            p_set->analyses[k].free(p_set->analyses[k].state);
+    p_set->num = 0;
+}
@@ -0,0 +1,94 @@
+#ifndef ANALYSIS_H_
+#define ANALYSIS_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Start with an empty set of analyses
+ * 
+ * @param[out] p_set 
+ */
+void analysis_init(struct AnalysisSet *p_set);
+
+/**
+ * @brief Register an analysis. Its state must be allocated already; the set takes ownership of it.
+ * It samples from the next snapshot on; snapshot buffers get the fields it needs on first use.
+ * 
+ * @param[in,out] p_set 
+ * @param[in] p_analysis copied into the set
+ * @return bool false (and the state is freed) if ANALYSIS_NUM_MAX analyses are registered
+ */
+bool analysis_add(struct AnalysisSet *p_set, const struct Analysis *p_analysis);
+
+/**
+ * @brief Whether any analysis samples this time step
+ * 
+ * @param[in] p_set 
+ * @param[in] step time step
+ * @return bool 
+ */
+bool analysis_due(const struct AnalysisSet *p_set, size_t step);
+
+/**
+ * @brief Analyses that sample this time step, to be stored in Snapshot::analyses
+ * 
+ * @param[in] p_set 
+ * @param[in] step time step
+ * @return unsigned int bit k is set if analysis k samples the time step
+ */
+unsigned int analysis_mask_due(const struct AnalysisSet *p_set, size_t step);
+
+/**
+ * @brief Snapshot fields needed by the analyses that sample this time step, e.g. to compute the contact
+ * stress only when it is sampled
+ * 
+ * @param[in] p_set 
+ * @param[in] step time step
+ * @return unsigned int union of their fields
+ */
+unsigned int analysis_fields_due(const struct AnalysisSet *p_set, size_t step);
+
+/**
+ * @brief Let the analyses in p_snap->analyses sample the snapshot. Called by the output pipeline,
+ * i.e. on the writer thread if output_async. Analyses registered after the snapshot was published skip it.
+ * 
+ * @param[in,out] p_set 
+ * @param[in] p_parameters 
+ * @param[in] p_snap snapshot with OUTPUT_TASK_ANALYSIS
+ */
+void analysis_sample(struct AnalysisSet *p_set, struct Parameters *p_parameters, const struct Snapshot *p_snap);
+
+/**
+ * @brief Add the samples of another set, registered with the same parameters, analysis by analysis. Used to
+ * split the snapshots of an offline re-analysis into blocks; merging the blocks in a fixed order makes the
+ * result independent of which thread sampled which block.
+ * 
+ * @param[in,out] p_set 
+ * @param[in] p_other not changed, free it with @ref analysis_free
+ * @return bool false (and nothing is merged) if the sets differ or an analysis has no merge function
+ */
+bool analysis_merge(struct AnalysisSet *p_set, const struct AnalysisSet *p_other);
+
+/**
+ * @brief Let the analyses with the final flag sample the final state, then let all analyses write their
+ * results and free their state. Call after the output pipeline has finished.
+ * 
+ * @param[in,out] p_set 
+ * @param[in] p_parameters 
+ * @param[in] p_vectors used members: time, radius, r, v, omega, f, image, type; the snapshot has no stress and no neighbor list pairs
+ * @param[in] p_colllist used members: num_nbrs, nbr, fn_sq, ft_sq, fij
+ * @param[in] step last time step
+ * @param[in] phase index of the last phase
+ */
+void analysis_finish(struct AnalysisSet *p_set, struct Parameters *p_parameters, struct Vectors *p_vectors,
+                     struct Colllist *p_colllist, size_t step, size_t phase);
+
+/**
+ * @brief Free the state of all analyses without writing results
+ * 
+ * @param[in,out] p_set 
+ */
+void analysis_free(struct AnalysisSet *p_set);
+
+#endif /* ANALYSIS_H_ */
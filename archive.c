@@ -0,0 +1,447 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "checksum.h"
+#include "codec.h"
+#include "archive.h"
+
+#define ARCHIVE_MAGIC "PBSARCH"
+#define ARCHIVE_VERSION 1u
+#define ARCHIVE_ENDIAN_TAG 0x01020304u
+
+// Field of block 1, 2, ... of a chunk (block 0 holds the particle indices) and the number of components of each field
+static const unsigned int archive_field_order[ARCHIVE_NUM_FIELDS] = {TRAJ_FIELD_POSITION, TRAJ_FIELD_RADIUS, TRAJ_FIELD_VELOCITY,
+                                                                     TRAJ_FIELD_OMEGA, TRAJ_FIELD_FORCE};
+static const size_t archive_field_ncomp[ARCHIVE_NUM_FIELDS] = {3, 1, 3, 3, 3};
+
+static uint64_t archive_zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t archive_unzigzag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// Encode num quantized values into out (at least 8*num bytes). scratch holds 16*num bytes.
+static struct ArchiveBlock archive_encode(const int64_t *values, size_t num, uint8_t *out, uint8_t *scratch)
+{
+    struct ArchiveBlock block;
+    memset(&block, 0, sizeof(block));
+
+    // delta and zigzag encoding turn slowly varying values into small unsigned integers
+    uint64_t *zigzag = (uint64_t *)scratch;
+    uint64_t max = 0;
+    for (size_t k = 0; k < num; ++k)
+    {
+        uint64_t delta = (uint64_t)values[k] - (k > 0 ? (uint64_t)values[k - 1] : 0);
+        zigzag[k] = archive_zigzag((int64_t)delta);
+        max = (zigzag[k] > max ? zigzag[k] : max);
+    }
+    block.width = (max <= UINT16_MAX ? 2 : (max <= UINT32_MAX ? 4 : 8));
+    uint8_t *packed = scratch + 8 * num;
+    for (size_t k = 0; k < num; ++k)
+    {
+        uint16_t value16 = (uint16_t)zigzag[k];
+        uint32_t value32 = (uint32_t)zigzag[k];
+        if (block.width == 2)
+            memcpy(packed + 2 * k, &value16, 2);
+        else if (block.width == 4)
+            memcpy(packed + 4 * k, &value32, 4);
+        else
+            memcpy(packed + 8 * k, &zigzag[k], 8);
+    }
+    block.size_raw = (uint32_t)(block.width * num);
+    codec_shuffle(packed, scratch, num, block.width);
+
+    // blocks that do not shrink are stored uncompressed
+    block.size = (uint32_t)codec_compress(scratch, block.size_raw, out, block.size_raw);
+    block.codec = (block.size > 0);
+    if (!block.codec)
+    {
+        memcpy(out, scratch, block.size_raw);
+        block.size = block.size_raw;
+    }
+    block.checksum = fnv1a_64(FNV1A_64_OFFSET, out, block.size);
+    return block;
+}
+
+// Decode a block read from the file into num quantized values. scratch holds 16*num bytes.
+static bool archive_decode(const struct ArchiveBlock *p_block, const uint8_t *in, size_t num, int64_t *values, uint8_t *scratch)
+{
+    if ((p_block->width != 2 && p_block->width != 4 && p_block->width != 8) || p_block->size_raw != p_block->width * num ||
+        fnv1a_64(FNV1A_64_OFFSET, in, p_block->size) != p_block->checksum)
+        return false;
+    if (p_block->codec)
+    {
+        if (!codec_decompress(in, p_block->size, scratch, p_block->size_raw))
+            return false;
+    }
+    else if (p_block->size == p_block->size_raw)
+        memcpy(scratch, in, p_block->size_raw);
+    else
+        return false;
+
+    uint8_t *packed = scratch + 8 * num;
+    codec_unshuffle(scratch, packed, num, p_block->width);
+    uint64_t sum = 0;
+    for (size_t k = 0; k < num; ++k)
+    {
+        uint64_t zigzag = 0;
+        if (p_block->width == 2)
+        {
+            uint16_t value16;
+            memcpy(&value16, packed + 2 * k, 2);
+            zigzag = value16;
+        }
+        else if (p_block->width == 4)
+        {
+            uint32_t value32;
+            memcpy(&value32, packed + 4 * k, 4);
+            zigzag = value32;
+        }
+        else
+            memcpy(&zigzag, packed + 8 * k, 8);
+        sum += (uint64_t)archive_unzigzag(zigzag);
+        values[k] = (int64_t)sum;
+    }
+    return true;
+}
+
+// Quantum of every field; a stored value is off by at most half a quantum, i.e. by the tolerance of the field
+static void archive_quanta(struct Parameters *p_parameters, double *quantum)
+{
+    quantum[0] = 2.0 * p_parameters->archive_tol_r;
+    quantum[1] = 2.0 * p_parameters->archive_tol_r;
+    quantum[2] = 2.0 * p_parameters->archive_tol_v;
+    quantum[3] = 2.0 * p_parameters->archive_tol_omega;
+    quantum[4] = 2.0 * p_parameters->archive_tol_f;
+}
+
+static double archive_component(const struct Vec3D *p_vec, size_t icomp)
+{
+    return (icomp == 0 ? p_vec->x : (icomp == 1 ? p_vec->y : p_vec->z));
+}
+
+bool archive_write(const char *filename, struct Parameters *p_parameters, struct Vectors *p_vectors, size_t step)
+{
+    size_t num_part = p_parameters->num_part;
+    unsigned int fields = p_parameters->archive_fields & TRAJ_FIELD_ALL;
+    struct ArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    archive_quanta(p_parameters, header.quantum);
+    for (size_t ifield = 0; ifield < ARCHIVE_NUM_FIELDS; ++ifield)
+        if ((fields & archive_field_order[ifield]) && !(header.quantum[ifield] > 0.0))
+        {
+            fprintf(stderr, "Error: the archive tolerances of all selected fields must be positive\n");
+            return false;
+        }
+    if (!(p_parameters->archive_cell > 0.0))
+    {
+        fprintf(stderr, "Error: archive_cell must be positive\n");
+        return false;
+    }
+
+    // chunk grid covering the particles
+    struct Vec3D *r = p_vectors->r;
+    struct Vec3D lo = r[0], hi = r[0];
+    for (size_t i = 1; i < num_part; ++i)
+    {
+        lo = (struct Vec3D){fmin(lo.x, r[i].x), fmin(lo.y, r[i].y), fmin(lo.z, r[i].z)};
+        hi = (struct Vec3D){fmax(hi.x, r[i].x), fmax(hi.y, r[i].y), fmax(hi.z, r[i].z)};
+    }
+    double cell = p_parameters->archive_cell;
+    size_t num_cells[3];
+    for (size_t icomp = 0; icomp < 3; ++icomp)
+    {
+        num_cells[icomp] = (size_t)((archive_component(&hi, icomp) - archive_component(&lo, icomp)) / cell) + 1;
+        header.num_cells[icomp] = (uint32_t)num_cells[icomp];
+    }
+    size_t num_cells_total = num_cells[0] * num_cells[1] * num_cells[2];
+
+    // counting sort by cell keeps the particles of a chunk in the order of their index
+    size_t *cell_of = (size_t *)malloc(num_part * sizeof(size_t));
+    size_t *start = (size_t *)calloc(num_cells_total + 1, sizeof(size_t));
+    size_t *order = (size_t *)malloc(num_part * sizeof(size_t));
+    for (size_t i = 0; i < num_part; ++i)
+    {
+        size_t c[3];
+        for (size_t icomp = 0; icomp < 3; ++icomp)
+        {
+            c[icomp] = (size_t)((archive_component(&r[i], icomp) - archive_component(&lo, icomp)) / cell);
+            c[icomp] = (c[icomp] < num_cells[icomp] ? c[icomp] : num_cells[icomp] - 1);
+        }
+        cell_of[i] = (c[2] * num_cells[1] + c[1]) * num_cells[0] + c[0];
+        start[cell_of[i] + 1]++;
+    }
+    size_t num_chunks = 0;
+    for (size_t c = 0; c < num_cells_total; ++c)
+    {
+        num_chunks += (start[c + 1] > 0);
+        start[c + 1] += start[c];
+    }
+    size_t *fill = (size_t *)malloc(num_cells_total * sizeof(size_t));
+    memcpy(fill, start, num_cells_total * sizeof(size_t));
+    for (size_t i = 0; i < num_part; ++i)
+        order[fill[cell_of[i]]++] = i;
+
+    // header, chunk table, then the blocks; a block is at most 8 bytes per value
+    size_t size_table = num_chunks * sizeof(struct ArchiveChunk);
+    size_t capacity = sizeof(header) + size_table + 8 * num_part * 14;
+    uint8_t *buffer = (uint8_t *)malloc(capacity);
+    struct ArchiveChunk *chunks = (struct ArchiveChunk *)calloc(num_chunks > 0 ? num_chunks : 1, sizeof(struct ArchiveChunk));
+    int64_t *values = (int64_t *)malloc(3 * num_part * sizeof(int64_t));
+    uint8_t *scratch = (uint8_t *)malloc(16 * 3 * num_part);
+    const double *data[ARCHIVE_NUM_FIELDS] = {(const double *)p_vectors->r, p_vectors->radius, (const double *)p_vectors->v,
+                                              (const double *)p_vectors->omega, (const double *)p_vectors->f};
+    size_t offset = sizeof(header) + size_table;
+    size_t ichunk = 0;
+    for (size_t c = 0; c < num_cells_total; ++c)
+    {
+        size_t num = start[c + 1] - start[c];
+        if (num == 0)
+            continue;
+        struct ArchiveChunk *p_chunk = &chunks[ichunk++];
+        size_t cell_index[3] = {c % num_cells[0], (c / num_cells[0]) % num_cells[1], c / (num_cells[0] * num_cells[1])};
+        for (size_t icomp = 0; icomp < 3; ++icomp)
+            p_chunk->cell[icomp] = (uint32_t)cell_index[icomp];
+        p_chunk->num_part = (uint32_t)num;
+        const size_t *ids = order + start[c];
+
+        for (size_t k = 0; k < num; ++k)
+            values[k] = (int64_t)ids[k];
+        p_chunk->block[0] = archive_encode(values, num, buffer + offset, scratch);
+        p_chunk->block[0].offset = offset;
+        offset += p_chunk->block[0].size;
+
+        for (size_t ifield = 0; ifield < ARCHIVE_NUM_FIELDS; ++ifield)
+        {
+            if (!(fields & archive_field_order[ifield]))
+                continue;
+            // one column per component; positions relative to the origin of the cell
+            size_t ncomp = archive_field_ncomp[ifield];
+            for (size_t icomp = 0; icomp < ncomp; ++icomp)
+            {
+                double origin = 0.0;
+                if (archive_field_order[ifield] == TRAJ_FIELD_POSITION)
+                    origin = archive_component(&lo, icomp) + cell_index[icomp] * cell;
+                for (size_t k = 0; k < num; ++k)
+                    values[icomp * num + k] = llrint((data[ifield][ncomp * ids[k] + icomp] - origin) / header.quantum[ifield]);
+            }
+            struct ArchiveBlock *p_block = &p_chunk->block[ifield + 1];
+            *p_block = archive_encode(values, ncomp * num, buffer + offset, scratch);
+            p_block->offset = offset;
+            offset += p_block->size;
+        }
+    }
+
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = ARCHIVE_VERSION;
+    header.size_header = sizeof(header);
+    header.endian_tag = ARCHIVE_ENDIAN_TAG;
+    header.fields = fields;
+    header.num_part = num_part;
+    header.step = step;
+    header.time = p_vectors->time;
+    header.origin = lo;
+    header.cell = cell;
+    header.num_chunks = num_chunks;
+    header.checksum = fnv1a_64(FNV1A_64_OFFSET, chunks, size_table);
+    memcpy(buffer, &header, sizeof(header));
+    memcpy(buffer + sizeof(header), chunks, size_table);
+
+    bool success = false;
+    FILE *p_file = fopen(filename, "wb");
+    if (p_file == NULL)
+        fprintf(stderr, "Error: cannot open %s for writing\n", filename);
+    else
+    {
+        success = (fwrite(buffer, 1, offset, p_file) == offset);
+        success = (fclose(p_file) == 0) && success;
+        if (!success)
+            fprintf(stderr, "Error: writing %s failed\n", filename);
+    }
+    free(cell_of);
+    free(start);
+    free(order);
+    free(fill);
+    free(buffer);
+    free(chunks);
+    free(values);
+    free(scratch);
+    return success;
+}
+
+// Read and decode block ifield+1 of a chunk (ifield = -1: particle indices)
+static bool archive_read_block(FILE *p_file, const struct ArchiveChunk *p_chunk, int ifield, int64_t *values,
+                               uint8_t **p_in, size_t *p_capacity_in, uint8_t *scratch)
+{
+    const struct ArchiveBlock *p_block = &p_chunk->block[ifield + 1];
+    size_t num = p_chunk->num_part * (ifield < 0 ? 1 : archive_field_ncomp[ifield]);
+    if (p_block->size > *p_capacity_in)
+    {
+        *p_capacity_in = p_block->size;
+        *p_in = (uint8_t *)realloc(*p_in, *p_capacity_in);
+    }
+    if (fseek(p_file, (long)p_block->offset, SEEK_SET) != 0 || fread(*p_in, 1, p_block->size, p_file) != p_block->size)
+        return false;
+    return archive_decode(p_block, *p_in, num, values, scratch);
+}
+
+long archive_read(const char *filename, unsigned int fields, const struct Vec3D *p_lo, const struct Vec3D *p_hi,
+                  struct ArchiveData *p_data)
+{
+    memset(p_data, 0, sizeof(*p_data));
+    FILE *p_file = fopen(filename, "rb");
+    if (p_file == NULL)
+    {
+        fprintf(stderr, "Error: cannot open %s\n", filename);
+        return -1;
+    }
+    struct ArchiveHeader header;
+    if (fread(&header, sizeof(header), 1, p_file) != 1 || memcmp(header.magic, ARCHIVE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != ARCHIVE_VERSION || header.endian_tag != ARCHIVE_ENDIAN_TAG || header.size_header != sizeof(header))
+    {
+        fprintf(stderr, "Error: %s is not an archive of this version and byte order\n", filename);
+        fclose(p_file);
+        return -1;
+    }
+    struct ArchiveChunk *chunks = (struct ArchiveChunk *)calloc(header.num_chunks > 0 ? header.num_chunks : 1, sizeof(struct ArchiveChunk));
+    size_t size_table = header.num_chunks * sizeof(struct ArchiveChunk);
+    if (fread(chunks, 1, size_table, p_file) != size_table || fnv1a_64(FNV1A_64_OFFSET, chunks, size_table) != header.checksum)
+    {
+        fprintf(stderr, "Error: chunk table of %s is corrupt\n", filename);
+        free(chunks);
+        fclose(p_file);
+        return -1;
+    }
+    fields &= header.fields;
+    bool region = (p_lo != NULL && p_hi != NULL);
+    if (region && !(header.fields & TRAJ_FIELD_POSITION))
+    {
+        fprintf(stderr, "Error: %s has no positions to select a region\n", filename);
+        free(chunks);
+        fclose(p_file);
+        return -1;
+    }
+    unsigned int fields_read = fields | (region ? TRAJ_FIELD_POSITION : 0u);
+
+    // chunks overlapping the region
+    size_t num_max = 0, num_chunk_max = 0;
+    bool *selected = (bool *)malloc((header.num_chunks > 0 ? header.num_chunks : 1) * sizeof(bool));
+    for (size_t ichunk = 0; ichunk < header.num_chunks; ++ichunk)
+    {
+        selected[ichunk] = true;
+        for (size_t icomp = 0; icomp < 3 && region; ++icomp)
+        {
+            double lo = archive_component(&header.origin, icomp) + chunks[ichunk].cell[icomp] * header.cell;
+            if (lo > archive_component(p_hi, icomp) || lo + header.cell < archive_component(p_lo, icomp))
+                selected[ichunk] = false;
+        }
+        if (selected[ichunk])
+        {
+            num_max += chunks[ichunk].num_part;
+            num_chunk_max = (chunks[ichunk].num_part > num_chunk_max ? chunks[ichunk].num_part : num_chunk_max);
+        }
+    }
+
+    p_data->step = header.step;
+    p_data->time = header.time;
+    p_data->id = (size_t *)malloc((num_max > 0 ? num_max : 1) * sizeof(size_t));
+    double *data[ARCHIVE_NUM_FIELDS] = {NULL};
+    for (size_t ifield = 0; ifield < ARCHIVE_NUM_FIELDS; ++ifield)
+        if (fields & archive_field_order[ifield])
+            data[ifield] = (double *)malloc((num_max > 0 ? num_max : 1) * archive_field_ncomp[ifield] * sizeof(double));
+    p_data->r = (struct Vec3D *)data[0];
+    p_data->radius = data[1];
+    p_data->v = (struct Vec3D *)data[2];
+    p_data->omega = (struct Vec3D *)data[3];
+    p_data->f = (struct Vec3D *)data[4];
+
+    int64_t *ids = (int64_t *)malloc((num_chunk_max + 1) * sizeof(int64_t));
+    int64_t *values = (int64_t *)malloc((3 * num_chunk_max + 1) * sizeof(int64_t));
+    size_t *slot = (size_t *)malloc((num_chunk_max + 1) * sizeof(size_t));
+    uint8_t *scratch = (uint8_t *)malloc(16 * 3 * num_chunk_max + 16);
+    uint8_t *in = NULL;
+    size_t capacity_in = 0;
+    long num_read = 0;
+    bool error = false;
+    for (size_t ichunk = 0; ichunk < header.num_chunks && !error; ++ichunk)
+    {
+        if (!selected[ichunk])
+            continue;
+        const struct ArchiveChunk *p_chunk = &chunks[ichunk];
+        size_t num = p_chunk->num_part;
+        error = !archive_read_block(p_file, p_chunk, -1, ids, &in, &capacity_in, scratch);
+        // output slot of every particle of the chunk, SIZE_MAX if outside the region
+        for (size_t k = 0; k < num; ++k)
+            slot[k] = num_read + k;
+        size_t num_inside = num_read;
+        for (size_t ifield = 0; ifield < ARCHIVE_NUM_FIELDS && !error; ++ifield)
+        {
+            if (!(fields_read & archive_field_order[ifield]))
+                continue;
+            error = !archive_read_block(p_file, p_chunk, (int)ifield, values, &in, &capacity_in, scratch);
+            size_t ncomp = archive_field_ncomp[ifield];
+            for (size_t k = 0; k < num && !error; ++k)
+            {
+                double value[3];
+                for (size_t icomp = 0; icomp < ncomp; ++icomp)
+                {
+                    double origin = 0.0;
+                    if (archive_field_order[ifield] == TRAJ_FIELD_POSITION)
+                        origin = archive_component(&header.origin, icomp) + p_chunk->cell[icomp] * header.cell;
+                    value[icomp] = origin + values[icomp * num + k] * header.quantum[ifield];
+                }
+                // position is the first field, so the slots are known before the other fields are stored
+                if (archive_field_order[ifield] == TRAJ_FIELD_POSITION && region)
+                {
+                    bool inside = value[0] >= p_lo->x && value[0] <= p_hi->x && value[1] >= p_lo->y &&
+                                  value[1] <= p_hi->y && value[2] >= p_lo->z && value[2] <= p_hi->z;
+                    slot[k] = (inside ? num_inside++ : SIZE_MAX);
+                }
+                if (data[ifield] != NULL && slot[k] != SIZE_MAX)
+                    for (size_t icomp = 0; icomp < ncomp; ++icomp)
+                        data[ifield][ncomp * slot[k] + icomp] = value[icomp];
+            }
+        }
+        for (size_t k = 0; k < num && !error; ++k)
+            if (slot[k] != SIZE_MAX)
+                p_data->id[num_read++] = (size_t)ids[k];
+    }
+    if (error)
+        fprintf(stderr, "Error: corrupt block in %s\n", filename);
+    p_data->num_part = (error ? 0 : (size_t)num_read);
+
+    free(chunks);
+    free(selected);
+    free(ids);
+    free(values);
+    free(slot);
+    free(scratch);
+    free(in);
+    fclose(p_file);
+    if (error)
+    {
+        archive_data_free(p_data);
+        return -1;
+    }
+    return num_read;
+}
+
+void archive_data_free(struct ArchiveData *p_data)
+{
+    free(p_data->id);
+    free(p_data->radius);
+    free(p_data->r);
+    free(p_data->v);
+    free(p_data->omega);
+    free(p_data->f);
+    memset(p_data, 0, sizeof(*p_data));
+}
@@ -0,0 +1,44 @@
+#ifndef ARCHIVE_H_
+#define ARCHIVE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Write a compressed columnar snapshot (archive) of the particles. The particles are grouped into chunks,
+ * one per cell of edge archive_cell, so regions can be read without decoding the whole file. Every selected
+ * field of a chunk is a separate block: its values are quantized with the field's tolerance (positions relative
+ * to the cell origin), delta and zigzag encoded along the particle order, stored as 16, 32 or 64 bit integers,
+ * byte-shuffled and compressed with @ref codec_compress. A reader gets every value to within its tolerance.
+ * 
+ * @param[in] filename 
+ * @param[in] p_parameters used members: num_part, archive_fields, archive_cell, archive_tol_r, archive_tol_v,
+ * archive_tol_omega, archive_tol_f
+ * @param[in] p_vectors used members: time, r, radius, v, omega, f
+ * @param[in] step time step of the snapshot
+ * @return bool true if successful
+ */
+bool archive_write(const char *filename, struct Parameters *p_parameters, struct Vectors *p_vectors, size_t step);
+
+/**
+ * @brief Read selected fields of the particles inside a region from an archive written by @ref archive_write.
+ * Only the blocks of the chunks that overlap the region are read and decompressed; their checksums are verified.
+ * 
+ * @param[in] filename 
+ * @param[in] fields fields to read, see TRAJ_FIELD_POSITION etc.; fields missing in the archive stay NULL
+ * @param[in] p_lo lower corner of the region, NULL for all particles
+ * @param[in] p_hi upper corner of the region, NULL for all particles
+ * @param[out] p_data particle indices and fields of the particles read, free with @ref archive_data_free
+ * @return long number of particles read, -1 on error
+ */
+long archive_read(const char *filename, unsigned int fields, const struct Vec3D *p_lo, const struct Vec3D *p_hi,
+                  struct ArchiveData *p_data);
+
+/**
+ * @brief Free the arrays allocated by @ref archive_read
+ * 
+ * @param[in,out] p_data 
+ */
+void archive_data_free(struct ArchiveData *p_data);
+
+#endif /* ARCHIVE_H_ */
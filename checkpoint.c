@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "constants.h"
+#include "structs.h"
+#include "restart.h"
+#include "checkpoint.h"
+
+// Writer thread: takes the pending buffer, seals and writes it, until asked to stop
+static void *checkpoint_writer(void *arg)
+{
+    struct Checkpoint *p_checkpoint = (struct Checkpoint *)arg;
+    pthread_mutex_lock(&p_checkpoint->mutex);
+    while (true)
+    {
+        while (p_checkpoint->pending < 0 && !p_checkpoint->stop)
+            pthread_cond_wait(&p_checkpoint->cond, &p_checkpoint->mutex);
+        if (p_checkpoint->pending < 0) // stop requested and nothing left to write
+            break;
+        int ibuf = p_checkpoint->pending;
+        p_checkpoint->writing = ibuf;
+        p_checkpoint->pending = -1;
+        pthread_cond_broadcast(&p_checkpoint->cond);
+        pthread_mutex_unlock(&p_checkpoint->mutex);
+
+        restart_seal(p_checkpoint->buffer[ibuf]);
+        bool ok = restart_write_file(p_checkpoint->filename, p_checkpoint->buffer[ibuf], p_checkpoint->size[ibuf]);
+
+        pthread_mutex_lock(&p_checkpoint->mutex);
+        p_checkpoint->writing = -1;
+        p_checkpoint->num_written += ok;
+        pthread_cond_broadcast(&p_checkpoint->cond);
+    }
+    pthread_mutex_unlock(&p_checkpoint->mutex);
+    return NULL;
+}
+
+bool checkpoint_init(struct Parameters *p_parameters, struct Checkpoint *p_checkpoint)
+{
+    memset(p_checkpoint, 0, sizeof(*p_checkpoint));
+    p_checkpoint->pending = -1;
+    p_checkpoint->writing = -1;
+    snprintf(p_checkpoint->filename, sizeof(p_checkpoint->filename), "%s", p_parameters->restart_out_filename);
+    pthread_mutex_init(&p_checkpoint->mutex, NULL);
+    pthread_cond_init(&p_checkpoint->cond, NULL);
+    if (pthread_create(&p_checkpoint->thread, NULL, checkpoint_writer, p_checkpoint) != 0)
+    {
+        fprintf(stderr, "Warning: cannot start the checkpoint thread, restart files are written synchronously\n");
+        pthread_mutex_destroy(&p_checkpoint->mutex);
+        pthread_cond_destroy(&p_checkpoint->cond);
+        return false;
+    }
+    return true;
+}
+
+void checkpoint_save(struct Checkpoint *p_checkpoint, struct Parameters *p_parameters, struct Vectors *p_vectors,
+                     struct Nbrlist *p_nbrlist, struct Colllist *p_colllist, size_t step,
+                     struct PhaseState *p_phase_state, struct FireState *p_fire, struct SteadyState *p_steady)
+{
+    // wait until the previous checkpoint has been picked up by the writer
+    pthread_mutex_lock(&p_checkpoint->mutex);
+    while (p_checkpoint->pending >= 0)
+        pthread_cond_wait(&p_checkpoint->cond, &p_checkpoint->mutex);
+    int ibuf = (p_checkpoint->writing == 0 ? 1 : 0);
+    pthread_mutex_unlock(&p_checkpoint->mutex);
+
+    // the buffer is neither pending nor being written, so it is filled without holding the lock
+    p_checkpoint->size[ibuf] = restart_serialize(p_parameters, p_vectors, p_nbrlist, p_colllist, step, p_phase_state,
+                                                 p_fire, p_steady, 0, &p_checkpoint->buffer[ibuf],
+                                                 &p_checkpoint->capacity[ibuf]);
+
+    pthread_mutex_lock(&p_checkpoint->mutex);
+    p_checkpoint->pending = ibuf;
+    pthread_cond_broadcast(&p_checkpoint->cond);
+    pthread_mutex_unlock(&p_checkpoint->mutex);
+}
+
+void checkpoint_finish(struct Checkpoint *p_checkpoint)
+{
+    pthread_mutex_lock(&p_checkpoint->mutex);
+    p_checkpoint->stop = true;
+    pthread_cond_broadcast(&p_checkpoint->cond);
+    pthread_mutex_unlock(&p_checkpoint->mutex);
+    pthread_join(p_checkpoint->thread, NULL);
+    pthread_mutex_destroy(&p_checkpoint->mutex);
+    pthread_cond_destroy(&p_checkpoint->cond);
+    free(p_checkpoint->buffer[0]);
+    free(p_checkpoint->buffer[1]);
+    p_checkpoint->buffer[0] = p_checkpoint->buffer[1] = NULL;
+}
@@ -0,0 +1,34 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <stdbool.h>
+
+/**
+ * @brief Start the background thread that writes restart files to p_parameters->restart_out_filename
+ * 
+ * @param[in] p_parameters used members: restart_out_filename
+ * @param[out] p_checkpoint 
+ * @return bool false if the thread cannot be started; the caller then writes restart files with save_restart
+ */
+bool checkpoint_init(struct Parameters *p_parameters, struct Checkpoint *p_checkpoint);
+
+/**
+ * @brief Copy the state of the run into a free buffer and hand it to the writer thread, which seals it,
+ * writes it and atomically replaces the restart file. Only blocks when two earlier checkpoints are still
+ * waiting for the disk.
+ * 
+ * @param[in,out] p_checkpoint 
+ * @see restart_serialize for the other parameters
+ */
+void checkpoint_save(struct Checkpoint *p_checkpoint, struct Parameters *p_parameters, struct Vectors *p_vectors,
+                     struct Nbrlist *p_nbrlist, struct Colllist *p_colllist, size_t step,
+                     struct PhaseState *p_phase_state, struct FireState *p_fire, struct SteadyState *p_steady);
+
+/**
+ * @brief Wait until all checkpoints are on disk, stop the writer thread and free the buffers
+ * 
+ * @param[in,out] p_checkpoint 
+ */
+void checkpoint_finish(struct Checkpoint *p_checkpoint);
+
+#endif /* CHECKPOINT_H_ */
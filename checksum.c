@@ -0,0 +1,27 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "constants.h"
+#include "checksum.h"
+
+uint64_t fnv1a_64(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV1A_64_PRIME;
+    }
+    return hash;
+}
+
+uint64_t fnv1a_64_double(uint64_t hash, double value)
+{
+    if (value == 0.0)
+        value = 0.0; // -0.0 and 0.0 describe the same setting
+    return fnv1a_64(hash, &value, sizeof(double));
+}
+
+uint64_t fnv1a_64_uint(uint64_t hash, uint64_t value)
+{
+    return fnv1a_64(hash, &value, sizeof(uint64_t));
+}
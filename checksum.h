@@ -0,0 +1,36 @@
+#ifndef CHECKSUM_H_
+#define CHECKSUM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Extend a 64-bit FNV-1a hash with a block of bytes.
+ * Start with hash = FNV1A_64_OFFSET; feeding blocks one after the other gives the hash of their concatenation.
+ * 
+ * @param[in] hash hash of the preceding data
+ * @param[in] data bytes to add
+ * @param[in] size number of bytes
+ * @return uint64_t updated hash
+ */
+uint64_t fnv1a_64(uint64_t hash, const void *data, size_t size);
+
+/**
+ * @brief Extend a 64-bit FNV-1a hash with a double, with -0.0 hashed as 0.0
+ * 
+ * @param[in] hash hash of the preceding data
+ * @param[in] value value to add
+ * @return uint64_t updated hash
+ */
+uint64_t fnv1a_64_double(uint64_t hash, double value);
+
+/**
+ * @brief Extend a 64-bit FNV-1a hash with an unsigned integer, hashed as 8 bytes
+ * 
+ * @param[in] hash hash of the preceding data
+ * @param[in] value value to add
+ * @return uint64_t updated hash
+ */
+uint64_t fnv1a_64_uint(uint64_t hash, uint64_t value);
+
+#endif /* CHECKSUM_H_ */
@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "analysis.h"
+#include "coarsegrain.h"
+
+// sums per node: solid volume, mass, momentum, m v v (xx, yy, zz, xy, xz, yz), contact f r (same order)
+enum {CG_VOL, CG_MASS, CG_MOM, CG_MVV = CG_MOM + 3, CG_FR = CG_MVV + 6};
+
+// Lucy kernel with cutoff c: 3D and 2D (for RZ grids) normalizations
+static double cg_lucy(double s)
+{
+    double t = 1.0 - s;
+    return (1.0 + 3.0 * s) * t * t * t;
+}
+
+// Node index range [*p_lo, *p_hi] within distance c of coordinate x; false if empty
+static bool cg_range(double x, double lo, double h, size_t num, double c, long *p_lo, long *p_hi)
+{
+    long i_lo = (long)ceil((x - c - lo) / h - 0.5);
+    long i_hi = (long)floor((x + c - lo) / h - 0.5);
+    *p_lo = (i_lo < 0 ? 0 : i_lo);
+    *p_hi = (i_hi > (long)num - 1 ? (long)num - 1 : i_hi);
+    return *p_lo <= *p_hi;
+}
+
+// Add values[0..num) times the kernel weight to the sums first.. of the nodes near p_pos
+static void cg_scatter(struct CoarseGrainState *p_state, const struct Vec3D *p_pos, const double *values, size_t first, size_t num)
+{
+    const double c = p_state->width;
+    const double c_sq = c * c;
+    long i_lo, i_hi, j_lo, j_hi, k_lo, k_hi;
+    if (p_state->grid == CG_GRID_RZ)
+    {
+        double dx = p_pos->x - p_state->axis.x;
+        double dy = p_pos->y - p_state->axis.y;
+        double rho = sqrt(dx * dx + dy * dy);
+        const double norm = 5.0 / (PI * c_sq) / (2.0 * PI); // 2D Lucy kernel spread over the ring 2 pi r
+        if (!cg_range(rho, 0.0, p_state->h.x, p_state->size.i, c, &i_lo, &i_hi) ||
+            !cg_range(p_pos->z, p_state->lo.z, p_state->h.z, p_state->size.k, c, &k_lo, &k_hi))
+            return;
+        for (long k = k_lo; k <= k_hi; ++k)
+        {
+            double dz = p_pos->z - (p_state->lo.z + (k + 0.5) * p_state->h.z);
+            for (long i = i_lo; i <= i_hi; ++i)
+            {
+                double r_node = (i + 0.5) * p_state->h.x;
+                double d_sq = (rho - r_node) * (rho - r_node) + dz * dz;
+                double d_sq_mirror = (rho + r_node) * (rho + r_node) + dz * dz; // image across the axis
+                if (d_sq >= c_sq)
+                    continue;
+                double w = cg_lucy(sqrt(d_sq) / c);
+                if (d_sq_mirror < c_sq)
+                    w += cg_lucy(sqrt(d_sq_mirror) / c);
+                w *= norm / r_node;
+                double *sum = &p_state->sum[((size_t)k * p_state->size.i + (size_t)i) * CG_NUM_SUMS + first];
+                for (size_t q = 0; q < num; ++q)
+                    sum[q] += w * values[q];
+            }
+        }
+        return;
+    }
+    const double norm = 105.0 / (16.0 * PI * c_sq * c);
+    if (!cg_range(p_pos->x, p_state->lo.x, p_state->h.x, p_state->size.i, c, &i_lo, &i_hi) ||
+        !cg_range(p_pos->y, p_state->lo.y, p_state->h.y, p_state->size.j, c, &j_lo, &j_hi) ||
+        !cg_range(p_pos->z, p_state->lo.z, p_state->h.z, p_state->size.k, c, &k_lo, &k_hi))
+        return;
+    for (long k = k_lo; k <= k_hi; ++k)
+    {
+        double dz = p_pos->z - (p_state->lo.z + (k + 0.5) * p_state->h.z);
+        for (long j = j_lo; j <= j_hi; ++j)
+        {
+            double dy = p_pos->y - (p_state->lo.y + (j + 0.5) * p_state->h.y);
+            for (long i = i_lo; i <= i_hi; ++i)
+            {
+                double dx = p_pos->x - (p_state->lo.x + (i + 0.5) * p_state->h.x);
+                double d_sq = dx * dx + dy * dy + dz * dz;
+                if (d_sq >= c_sq)
+                    continue;
+                double w = norm * cg_lucy(sqrt(d_sq) / c);
+                double *sum = &p_state->sum[(((size_t)k * p_state->size.j + (size_t)j) * p_state->size.i + (size_t)i) * CG_NUM_SUMS + first];
+                for (size_t q = 0; q < num; ++q)
+                    sum[q] += w * values[q];
+            }
+        }
+    }
+}
+
+// Components of a vector in the basis of the grid at position p_pos: (r, theta, z) for RZ grids
+static struct Vec3D cg_components(const struct CoarseGrainState *p_state, const struct Vec3D *p_pos, struct Vec3D a)
+{
+    if (p_state->grid != CG_GRID_RZ)
+        return a;
+    double dx = p_pos->x - p_state->axis.x;
+    double dy = p_pos->y - p_state->axis.y;
+    double rho = sqrt(dx * dx + dy * dy);
+    double cos_t = (rho > 0.0 ? dx / rho : 1.0);
+    double sin_t = (rho > 0.0 ? dy / rho : 0.0);
+    return (struct Vec3D){cos_t * a.x + sin_t * a.y, -sin_t * a.x + cos_t * a.y, a.z};
+}
+
+// Symmetric part of the outer product a b times factor: xx, yy, zz, xy, xz, yz
+static void cg_outer(struct Vec3D a, struct Vec3D b, double factor, double *out)
+{
+    out[0] = factor * a.x * b.x;
+    out[1] = factor * a.y * b.y;
+    out[2] = factor * a.z * b.z;
+    out[3] = factor * 0.5 * (a.x * b.y + a.y * b.x);
+    out[4] = factor * 0.5 * (a.x * b.z + a.z * b.x);
+    out[5] = factor * 0.5 * (a.y * b.z + a.z * b.y);
+}
+
+// Position of node n
+static struct Vec3D cg_node(const struct CoarseGrainState *p_state, size_t n)
+{
+    size_t i = n % p_state->size.i;
+    size_t j = (n / p_state->size.i) % p_state->size.j;
+    size_t k = n / (p_state->size.i * p_state->size.j);
+    return (struct Vec3D){p_state->lo.x + (i + 0.5) * p_state->h.x, p_state->lo.y + (j + 0.5) * p_state->h.y,
+                          p_state->lo.z + (k + 0.5) * p_state->h.z};
+}
+
+static void cg_write_header(const struct CoarseGrainState *p_state, FILE *fp, bool with_step)
+{
+    if (with_step)
+        fprintf(fp, "step,time,");
+    if (p_state->grid == CG_GRID_RZ)
+        fprintf(fp, "r,z,phi,rho,u_r,u_t,u_z,T,sk_rr,sk_tt,sk_zz,sk_rt,sk_rz,sk_tz,sc_rr,sc_tt,sc_zz,sc_rt,sc_rz,sc_tz\n");
+    else
+        fprintf(fp, "x,y,z,phi,rho,u_x,u_y,u_z,T,sk_xx,sk_yy,sk_zz,sk_xy,sk_xz,sk_yz,sc_xx,sc_yy,sc_zz,sc_xy,sc_xz,sc_yz\n");
+}
+
+// Write the fields of all nodes from sums over num_samples snapshots
+static void cg_write_fields(const struct CoarseGrainState *p_state, FILE *fp, const double *sums, double num_samples,
+                            const char *prefix)
+{
+    for (size_t n = 0; n < p_state->num_nodes; ++n)
+    {
+        const double *s = &sums[n * CG_NUM_SUMS];
+        double phi = s[CG_VOL] / num_samples;
+        double rho = s[CG_MASS] / num_samples;
+        struct Vec3D u = {0.0, 0.0, 0.0};
+        if (rho > 0.0)
+            u = (struct Vec3D){s[CG_MOM] / num_samples / rho, s[CG_MOM + 1] / num_samples / rho, s[CG_MOM + 2] / num_samples / rho};
+        double sk[6], uu[6];
+        cg_outer(u, u, rho, uu);
+        for (int q = 0; q < 6; ++q)
+            sk[q] = s[CG_MVV + q] / num_samples - uu[q]; // velocity fluctuations relative to the local mean
+        double T = (rho > 0.0 ? (sk[0] + sk[1] + sk[2]) / (3.0 * rho) : 0.0);
+        struct Vec3D x = cg_node(p_state, n);
+        fprintf(fp, "%s", prefix);
+        if (p_state->grid == CG_GRID_RZ)
+            fprintf(fp, "%g,%g,", x.x, x.z);
+        else
+            fprintf(fp, "%g,%g,%g,", x.x, x.y, x.z);
+        fprintf(fp, "%g,%g,%g,%g,%g,%g", phi, rho, u.x, u.y, u.z, T);
+        for (int q = 0; q < 6; ++q)
+            fprintf(fp, ",%g", sk[q]);
+        for (int q = 0; q < 6; ++q)
+            fprintf(fp, ",%g", s[CG_FR + q] / num_samples);
+        fprintf(fp, "\n");
+    }
+}
+
+static void cg_sample(struct Analysis *p_analysis, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    struct CoarseGrainState *p_state = (struct CoarseGrainState *)p_analysis->state;
+    memset(p_state->sum, 0, p_state->num_nodes * CG_NUM_SUMS * sizeof(double));
+
+    double values[CG_NUM_SUMS];
+    for (size_t i = 0; i < p_snap->num_part; ++i)
+    {
+        double R = p_snap->radius[i];
+        double vol = (4.0 / 3.0) * PI * R * R * R;
+        double m = p_state->density * vol;
+        struct Vec3D v = cg_components(p_state, &p_snap->r[i], p_snap->v[i]);
+        values[CG_VOL] = vol;
+        values[CG_MASS] = m;
+        values[CG_MOM] = m * v.x;
+        values[CG_MOM + 1] = m * v.y;
+        values[CG_MOM + 2] = m * v.z;
+        cg_outer(v, v, m, &values[CG_MVV]);
+        cg_scatter(p_state, &p_snap->r[i], values, 0, CG_FR);
+    }
+    for (size_t k = 0; k < p_snap->num_contacts; ++k)
+    {
+        const struct Pair *p_pair = &p_snap->contacts[k];
+        const struct DeltaR *p_rij = &p_pair->rij;
+        const struct Vec3D *r_i = &p_snap->r[p_pair->i];
+        struct Vec3D contact = {r_i->x - 0.5 * p_rij->x, r_i->y - 0.5 * p_rij->y, r_i->z - 0.5 * p_rij->z};
+        struct Vec3D f = cg_components(p_state, &contact, p_snap->fij[k]);
+        struct Vec3D b = cg_components(p_state, &contact, (struct Vec3D){p_rij->x, p_rij->y, p_rij->z});
+        cg_outer(f, b, 1.0, &values[CG_FR]);
+        cg_scatter(p_state, &contact, &values[CG_FR], CG_FR, 6);
+    }
+
+    for (size_t q = 0; q < p_state->num_nodes * CG_NUM_SUMS; ++q)
+        p_state->sum_total[q] += p_state->sum[q];
+    if (p_state->fp)
+    {
+        char prefix[64];
+        snprintf(prefix, sizeof(prefix), "%lu,%g,", (long unsigned)p_snap->step, p_snap->time);
+        cg_write_fields(p_state, p_state->fp, p_state->sum, 1.0, prefix);
+        fflush(p_state->fp);
+    }
+}
+
+static void cg_finish(struct Analysis *p_analysis, struct Parameters *p_parameters)
+{
+    struct CoarseGrainState *p_state = (struct CoarseGrainState *)p_analysis->state;
+    FILE *fp = fopen("data/cg_fields_avg.csv", "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Error: cannot open data/cg_fields_avg.csv for writing\n");
+        return;
+    }
+    cg_write_header(p_state, fp, false);
+    cg_write_fields(p_state, fp, p_state->sum_total, (double)p_analysis->num_samples, "");
+    fclose(fp);
+}
+
+static void cg_free(void *state)
+{
+    struct CoarseGrainState *p_state = (struct CoarseGrainState *)state;
+    if (p_state == NULL)
+        return;
+    if (p_state->fp)
+        fclose(p_state->fp);
+    free(p_state->sum);
+    free(p_state->sum_total);
+    free(p_state);
+}
+
+void coarsegrain_register(struct Parameters *p_parameters, struct AnalysisSet *p_set)
+{
+    if (p_parameters->num_dt_cg == 0)
+        return;
+    struct CoarseGrainState *p_state = (struct CoarseGrainState *)calloc(1, sizeof(struct CoarseGrainState));
+    if (p_state == NULL)
+        return;
+    p_state->grid = p_parameters->cg_grid;
+    p_state->size = p_parameters->cg_size;
+    p_state->lo = p_parameters->cg_lo;
+    struct Vec3D hi = p_parameters->cg_hi;
+    if (p_state->grid == CG_GRID_RZ)
+    {
+        p_state->size.j = 1;
+        p_state->lo.x = p_state->lo.y = 0.0;
+        hi.x = hi.y = p_parameters->cg_r_max;
+    }
+    if (p_state->size.i == 0 || p_state->size.j == 0 || p_state->size.k == 0)
+    {
+        fprintf(stderr, "Warning: coarse-grained fields off, grid without nodes\n");
+        free(p_state);
+        return;
+    }
+    p_state->h = (struct Vec3D){(hi.x - p_state->lo.x) / p_state->size.i, (hi.y - p_state->lo.y) / p_state->size.j,
+                                (hi.z - p_state->lo.z) / p_state->size.k};
+    p_state->axis = (struct Vec3D){0.5 * p_parameters->L.x, 0.5 * p_parameters->L.y, 0.0};
+    p_state->width = p_parameters->cg_width;
+    p_state->density = p_parameters->density;
+    p_state->num_nodes = p_state->size.i * p_state->size.j * p_state->size.k;
+    p_state->sum = (double *)malloc(p_state->num_nodes * CG_NUM_SUMS * sizeof(double));
+    p_state->sum_total = (double *)calloc(p_state->num_nodes * CG_NUM_SUMS, sizeof(double));
+    p_state->fp = fopen("data/cg_fields.csv", "w");
+    if (p_state->sum == NULL || p_state->sum_total == NULL)
+    {
+        fprintf(stderr, "Error: failed to allocate the coarse-grained fields\n");
+        cg_free(p_state);
+        return;
+    }
+    if (p_state->fp)
+        cg_write_header(p_state, p_state->fp, true);
+    else
+        fprintf(stderr, "Error: cannot open data/cg_fields.csv for writing\n");
+
+    struct Analysis analysis = {.name = "coarse-grained fields", .num_dt = p_parameters->num_dt_cg, .final = false,
+                                .fields = 0u, .contacts = true, .state = p_state,
+                                .sample = cg_sample, .finish = cg_finish, .free = cg_free, .merge = NULL};
+    analysis_add(p_set, &analysis);
+}
@@ -0,0 +1,22 @@
+#ifndef COARSEGRAIN_H_
+#define COARSEGRAIN_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Register the coarse-grained continuum fields as an analysis (if num_dt_cg > 0). Every num_dt_cg steps
+ * the particles and contacts are smoothed onto the nodes of an axisymmetric (r, z) or a 3D grid with a compact
+ * Lucy kernel of cutoff cg_width: solid fraction, mass density, velocity, granular temperature (per unit mass),
+ * kinetic stress and contact stress (symmetric part of the sum of f_ij r_ij, with f_ij the contact force on i and
+ * r_ij = r_i - r_j, smoothed at the contact point). Stresses are positive in compression; wall contacts are not
+ * included. RZ fields are azimuthal averages with vectors and tensors in (r, theta, z) components; the kernel
+ * is mirrored at the axis. Each snapshot is appended to data/cg_fields.csv, the fields of the summed snapshots are
+ * written to data/cg_fields_avg.csv at the end of the run.
+ * 
+ * @param[in] p_parameters used members: num_dt_cg, cg_grid, cg_size, cg_lo, cg_hi, cg_r_max, cg_width, density, L
+ * @param[in,out] p_set 
+ */
+void coarsegrain_register(struct Parameters *p_parameters, struct AnalysisSet *p_set);
+
+#endif /* COARSEGRAIN_H_ */
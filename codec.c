@@ -0,0 +1,145 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "codec.h"
+
+#define CODEC_MIN_MATCH 4
+#define CODEC_MAX_OFFSET 65535
+#define CODEC_HASH_BITS 14
+
+/* Block format: a sequence of tokens. The high nibble of a token is the number of literals, the low nibble the
+ * match length minus CODEC_MIN_MATCH; a nibble of 15 is continued by bytes of 255 and a final byte < 255.
+ * The literals follow the token, then the 2-byte offset of the match. The last token has no match. */
+
+static uint32_t codec_read32(const uint8_t *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Append a token with its literals and (if length >= CODEC_MIN_MATCH) its match; false if out is full
+static bool codec_emit(uint8_t *out, size_t *p_pos, size_t capacity, const uint8_t *literals, size_t num_literals,
+                       size_t offset, size_t length)
+{
+    size_t pos = *p_pos;
+    size_t nibble_lit = (num_literals < 15 ? num_literals : 15);
+    size_t nibble_match = (length < CODEC_MIN_MATCH ? 0 : (length - CODEC_MIN_MATCH < 15 ? length - CODEC_MIN_MATCH : 15));
+    // worst case: token, length bytes, literals, offset
+    if (pos + 1 + num_literals / 255 + 1 + num_literals + 2 + length / 255 + 1 > capacity)
+        return false;
+    out[pos++] = (uint8_t)(nibble_lit << 4 | nibble_match);
+    if (nibble_lit == 15)
+    {
+        size_t rest = num_literals - 15;
+        for (; rest >= 255; rest -= 255)
+            out[pos++] = 255;
+        out[pos++] = (uint8_t)rest;
+    }
+    memcpy(out + pos, literals, num_literals);
+    pos += num_literals;
+    if (length >= CODEC_MIN_MATCH)
+    {
+        out[pos++] = (uint8_t)(offset & 0xff);
+        out[pos++] = (uint8_t)(offset >> 8);
+        if (nibble_match == 15)
+        {
+            size_t rest = length - CODEC_MIN_MATCH - 15;
+            for (; rest >= 255; rest -= 255)
+                out[pos++] = 255;
+            out[pos++] = (uint8_t)rest;
+        }
+    }
+    *p_pos = pos;
+    return true;
+}
+
+size_t codec_compress(const uint8_t *in, size_t size, uint8_t *out, size_t capacity)
+{
+    uint32_t table[1u << CODEC_HASH_BITS]; // last position + 1 of every hashed 4-byte sequence
+    memset(table, 0, sizeof(table));
+    size_t pos_out = 0, anchor = 0, ip = 0;
+    while (ip + CODEC_MIN_MATCH <= size)
+    {
+        uint32_t sequence = codec_read32(in + ip);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - CODEC_HASH_BITS);
+        size_t ref = table[hash];
+        table[hash] = (uint32_t)(ip + 1);
+        if (ref == 0 || ip - (ref - 1) > CODEC_MAX_OFFSET || codec_read32(in + ref - 1) != sequence)
+        {
+            ip++;
+            continue;
+        }
+        ref--;
+        size_t length = CODEC_MIN_MATCH;
+        while (ip + length < size && in[ref + length] == in[ip + length])
+            length++;
+        if (!codec_emit(out, &pos_out, capacity, in + anchor, ip - anchor, ip - ref, length))
+            return 0;
+        ip += length;
+        anchor = ip;
+    }
+    if (!codec_emit(out, &pos_out, capacity, in + anchor, size - anchor, 0, 0))
+        return 0;
+    return pos_out;
+}
+
+// Read the continuation bytes of a length nibble of 15
+static bool codec_read_length(const uint8_t *in, size_t size, size_t *p_pos, size_t *p_length)
+{
+    uint8_t byte;
+    do
+    {
+        if (*p_pos >= size)
+            return false;
+        byte = in[(*p_pos)++];
+        *p_length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool codec_decompress(const uint8_t *in, size_t size, uint8_t *out, size_t size_out)
+{
+    size_t ip = 0, op = 0;
+    while (ip < size)
+    {
+        uint8_t token = in[ip++];
+        size_t num_literals = token >> 4;
+        if (num_literals == 15 && !codec_read_length(in, size, &ip, &num_literals))
+            return false;
+        if (num_literals > size - ip || num_literals > size_out - op)
+            return false;
+        memcpy(out + op, in + ip, num_literals);
+        ip += num_literals;
+        op += num_literals;
+        if (ip == size)
+            break; // last token
+        if (size - ip < 2)
+            return false;
+        size_t offset = (size_t)in[ip] | (size_t)in[ip + 1] << 8;
+        ip += 2;
+        size_t length = (token & 15u);
+        if (length == 15 && !codec_read_length(in, size, &ip, &length))
+            return false;
+        length += CODEC_MIN_MATCH;
+        if (offset == 0 || offset > op || length > size_out - op)
+            return false;
+        for (size_t k = 0; k < length; ++k, ++op) // byte by byte, matches may overlap their own output
+            out[op] = out[op - offset];
+    }
+    return op == size_out;
+}
+
+void codec_shuffle(const uint8_t *in, uint8_t *out, size_t num, size_t size_elem)
+{
+    for (size_t i = 0; i < num; ++i)
+        for (size_t b = 0; b < size_elem; ++b)
+            out[b * num + i] = in[i * size_elem + b];
+}
+
+void codec_unshuffle(const uint8_t *in, uint8_t *out, size_t num, size_t size_elem)
+{
+    for (size_t i = 0; i < num; ++i)
+        for (size_t b = 0; b < size_elem; ++b)
+            out[i * size_elem + b] = in[b * num + i];
+}
@@ -0,0 +1,52 @@
+#ifndef CODEC_H_
+#define CODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Compress a block of bytes with the bundled LZ77 codec. The output is a sequence of literal runs and
+ * back-references within the last 64 kB; long runs of equal bytes, as produced by @ref codec_shuffle, compress well.
+ * 
+ * @param[in] in data to compress
+ * @param[in] size number of bytes
+ * @param[out] out compressed data
+ * @param[in] capacity size of out in bytes
+ * @return size_t size of the compressed data, 0 if it does not fit into capacity bytes
+ */
+size_t codec_compress(const uint8_t *in, size_t size, uint8_t *out, size_t capacity);
+
+/**
+ * @brief Decompress a block written by @ref codec_compress
+ * 
+ * @param[in] in compressed data
+ * @param[in] size number of compressed bytes
+ * @param[out] out decompressed data
+ * @param[in] size_out expected size of the decompressed data
+ * @return bool true if the block is valid and decompresses to exactly size_out bytes
+ */
+bool codec_decompress(const uint8_t *in, size_t size, uint8_t *out, size_t size_out);
+
+/**
+ * @brief Byte shuffle: store byte 0 of all elements, then byte 1 of all elements, etc.
+ * The high bytes of small integers become long runs of zeros.
+ * 
+ * @param[in] in num elements of size_elem bytes
+ * @param[out] out shuffled bytes, must not overlap in
+ * @param[in] num number of elements
+ * @param[in] size_elem bytes per element
+ */
+void codec_shuffle(const uint8_t *in, uint8_t *out, size_t num, size_t size_elem);
+
+/**
+ * @brief Undo @ref codec_shuffle
+ * 
+ * @param[in] in shuffled bytes
+ * @param[out] out num elements of size_elem bytes, must not overlap in
+ * @param[in] num number of elements
+ * @param[in] size_elem bytes per element
+ */
+void codec_unshuffle(const uint8_t *in, uint8_t *out, size_t num, size_t size_elem);
+
+#endif /* CODEC_H_ */
@@ -5,6 +5,64 @@
 
 #define PI 3.141592653589
 #define NUM_WALLS_MAX 10
+#define NUM_PHASES_MAX 8
+
+/// Bit mask selecting wall i in Parameters::wall_mask and Phase::wall_mask
+#define WALL_BIT(i) (1u << (i))
+#define WALL_MASK_ALL (~0u)
+
+/// Offset basis and prime of the 64-bit FNV-1a hash, see @ref fnv1a_64
+#define FNV1A_64_OFFSET 0xcbf29ce484222325ull
+#define FNV1A_64_PRIME 0x100000001b3ull
+
+/// Fields that can be stored in binary trajectory frames, see Parameters::traj_fields
+#define TRAJ_FIELD_POSITION 0x01u
+#define TRAJ_FIELD_RADIUS 0x02u
+#define TRAJ_FIELD_VELOCITY 0x04u
+#define TRAJ_FIELD_OMEGA 0x08u
+#define TRAJ_FIELD_FORCE 0x10u
+#define TRAJ_FIELD_ALL 0x1fu
+/// Snapshot field not stored in trajectories: contact stress per particle, see Analysis::fields
+#define SNAPSHOT_FIELD_STRESS 0x20u
+/// Snapshot field not stored in trajectories: pairs of the neighbor list, see Analysis::fields
+#define SNAPSHOT_FIELD_NBRS 0x40u
+/// Snapshot field not stored in trajectories: periodic images of the particles, see Analysis::fields
+#define SNAPSHOT_FIELD_IMAGE 0x80u
+
+/// Output tasks carried out for a snapshot, see Snapshot::tasks
+#define OUTPUT_TASK_STATUS 0x01u
+#define OUTPUT_TASK_FRAME 0x02u
+#define OUTPUT_TASK_ANALYSIS 0x04u
+#define OUTPUT_TASK_ARCHIVE 0x08u
+
+/// Maximum number of analyses registered with an AnalysisSet
+#define ANALYSIS_NUM_MAX 16
+
+/// Largest number of contacts per particle in the coordination distribution, see @ref contactnet_register
+#define CONTACTNET_Z_MAX 16
+
+/// Number of sums per node of the coarse-grained fields, see @ref coarsegrain_register
+#define CG_NUM_SUMS 17
+
+/// Number of fields that can be stored in archives (the TRAJ_FIELD_* fields) and blocks per archive chunk
+#define ARCHIVE_NUM_FIELDS 5
+#define ARCHIVE_NUM_BLOCKS (ARCHIVE_NUM_FIELDS + 1)
+
+/// Magic strings, version and byte order tag of binary trajectory files, see @ref trajectory_open
+#define TRAJ_MAGIC "PBSTRAJ"
+#define TRAJ_FRAME_MAGIC "FRM"
+#define TRAJ_DELTA_MAGIC "DLT"
+#define TRAJ_END_MAGIC "PBSTEND"
+#define TRAJ_VERSION 2u
+#define TRAJ_ENDIAN_TAG 0x01020304u
+
+/// Magic string, version and byte order tag of restart files, see @ref restart_serialize
+#define RESTART_MAGIC "PBSRST"
+#define RESTART_VERSION 3u
+#define RESTART_ENDIAN_TAG 0x01020304u
+
+/// Alignment in bytes of the sections in restart files
+#define RESTART_ALIGN 64
 
 /// Seed used for reproducible random initialization (can be changed for variability)
 #define SEED 12345u
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "analysis.h"
+#include "contactnet.h"
+
+// Root of the tree of particle i, halving the path on the way
+static size_t cn_find(size_t *parent, size_t i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Merge the trees of particles i and j, the smaller one below the larger one
+static void cn_union(size_t *parent, size_t *size, size_t i, size_t j)
+{
+    size_t a = cn_find(parent, i);
+    size_t b = cn_find(parent, j);
+    if (a == b)
+        return;
+    if (size[a] < size[b])
+    {
+        size_t t = a;
+        a = b;
+        b = t;
+    }
+    parent[b] = a;
+    size[a] += size[b];
+}
+
+static void cn_sample(struct Analysis *p_analysis, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    struct ContactNetState *p_state = (struct ContactNetState *)p_analysis->state;
+    size_t num_part = p_state->num_part;
+    size_t num_contacts = p_snap->num_contacts;
+    double fric_sq = p_parameters->fric_pp * p_parameters->fric_pp;
+
+    for (size_t i = 0; i < num_part; ++i)
+    {
+        p_state->z[i] = 0;
+        p_state->parent[i] = i;
+        p_state->size[i] = 1;
+    }
+
+    // per-contact pass: coordination, sliding, mean normal force and fabric
+    size_t num_sliding = 0;
+    double fn_sum = 0.0;
+    struct SymTensor fabric = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    for (size_t k = 0; k < num_contacts; ++k)
+    {
+        const struct Pair *p_pair = &p_snap->contacts[k];
+        p_state->z[p_pair->i]++;
+        p_state->z[p_pair->j]++;
+        if (p_snap->ft_sq[k] >= (1.0 - 1e-9) * fric_sq * p_snap->fn_sq[k])
+            num_sliding++;
+        fn_sum += sqrt(p_snap->fn_sq[k]);
+        const struct DeltaR *p_rij = &p_pair->rij;
+        double inv_sq = 1.0 / p_rij->sq;
+        fabric.xx += p_rij->x * p_rij->x * inv_sq;
+        fabric.yy += p_rij->y * p_rij->y * inv_sq;
+        fabric.zz += p_rij->z * p_rij->z * inv_sq;
+        fabric.xy += p_rij->x * p_rij->y * inv_sq;
+        fabric.xz += p_rij->x * p_rij->z * inv_sq;
+        fabric.yz += p_rij->y * p_rij->z * inv_sq;
+    }
+    double inv_contacts = num_contacts > 0 ? 1.0 / (double)num_contacts : 0.0;
+    double fn_mean = fn_sum * inv_contacts;
+
+    // normal force distribution and force chains: union-find over the strong contacts
+    size_t num_strong = 0;
+    double fn_bin = p_state->fn_max / (double)p_state->fn_num_bins;
+    double fn_strong = p_parameters->chain_fn_ratio * fn_mean;
+    for (size_t k = 0; k < num_contacts; ++k)
+    {
+        double fn = sqrt(p_snap->fn_sq[k]);
+        if (fn_mean > 0.0)
+        {
+            size_t b = (size_t)(fn / fn_mean / fn_bin);
+            if (b < p_state->fn_num_bins)
+                p_state->fn_sum[b] += inv_contacts / fn_bin;
+        }
+        if (fn > fn_strong)
+        {
+            num_strong++;
+            cn_union(p_state->parent, p_state->size, p_snap->contacts[k].i, p_snap->contacts[k].j);
+        }
+    }
+    size_t num_chains = 0, chain_max = 0, num_rattlers = 0;
+    for (size_t i = 0; i < num_part; ++i)
+    {
+        unsigned int z = p_state->z[i] < CONTACTNET_Z_MAX ? p_state->z[i] : CONTACTNET_Z_MAX;
+        p_state->z_sum[z] += 1.0 / (double)num_part;
+        if (z < 2)
+            num_rattlers++;
+        if (p_state->parent[i] == i && p_state->size[i] >= p_parameters->chain_min_size)
+        {
+            num_chains++;
+            if (p_state->size[i] > chain_max)
+                chain_max = p_state->size[i];
+        }
+    }
+
+    if (p_state->fp)
+    {
+        fprintf(p_state->fp, "%lu,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%lu,%lu\n", (long unsigned)p_snap->step, p_snap->time,
+                2.0 * (double)num_contacts / (double)num_part, (double)num_rattlers / (double)num_part,
+                (double)num_sliding * inv_contacts, fn_mean, fabric.xx * inv_contacts, fabric.yy * inv_contacts,
+                fabric.zz * inv_contacts, fabric.xy * inv_contacts, fabric.xz * inv_contacts, fabric.yz * inv_contacts,
+                (double)num_strong * inv_contacts, (long unsigned)num_chains, (long unsigned)chain_max);
+        fflush(p_state->fp);
+    }
+}
+
+static void cn_finish(struct Analysis *p_analysis, struct Parameters *p_parameters)
+{
+    struct ContactNetState *p_state = (struct ContactNetState *)p_analysis->state;
+    double num_samples = (double)p_analysis->num_samples;
+
+    FILE *fz = fopen("data/coordination_pdf.csv", "w");
+    if (fz)
+    {
+        fprintf(fz, "contacts,fraction\n");
+        for (size_t z = 0; z <= CONTACTNET_Z_MAX; ++z)
+            fprintf(fz, "%lu,%g\n", (long unsigned)z, p_state->z_sum[z] / num_samples);
+        fclose(fz);
+    }
+    else
+        fprintf(stderr, "Error: cannot open data/coordination_pdf.csv for writing\n");
+
+    FILE *ff = fopen("data/fn_pdf.csv", "w");
+    if (ff)
+    {
+        double fn_bin = p_state->fn_max / (double)p_state->fn_num_bins;
+        fprintf(ff, "fn_over_mean,pdf\n");
+        for (size_t b = 0; b < p_state->fn_num_bins; ++b)
+            fprintf(ff, "%g,%g\n", (b + 0.5) * fn_bin, p_state->fn_sum[b] / num_samples);
+        fclose(ff);
+    }
+    else
+        fprintf(stderr, "Error: cannot open data/fn_pdf.csv for writing\n");
+}
+
+static void cn_free(void *state)
+{
+    struct ContactNetState *p_state = (struct ContactNetState *)state;
+    if (p_state == NULL)
+        return;
+    if (p_state->fp)
+        fclose(p_state->fp);
+    free(p_state->z);
+    free(p_state->parent);
+    free(p_state->size);
+    free(p_state->z_sum);
+    free(p_state->fn_sum);
+    free(p_state);
+}
+
+void contactnet_register(struct Parameters *p_parameters, struct AnalysisSet *p_set)
+{
+    if (p_parameters->num_dt_contacts == 0 || p_parameters->contact_fn_num_bins == 0)
+        return;
+    struct ContactNetState *p_state = (struct ContactNetState *)calloc(1, sizeof(struct ContactNetState));
+    if (p_state == NULL)
+        return;
+    size_t num_part = p_parameters->num_part;
+    p_state->num_part = num_part;
+    p_state->fn_num_bins = p_parameters->contact_fn_num_bins;
+    p_state->fn_max = p_parameters->contact_fn_max;
+    p_state->z = (unsigned int *)malloc(num_part * sizeof(unsigned int));
+    p_state->parent = (size_t *)malloc(num_part * sizeof(size_t));
+    p_state->size = (size_t *)malloc(num_part * sizeof(size_t));
+    p_state->z_sum = (double *)calloc(CONTACTNET_Z_MAX + 1, sizeof(double));
+    p_state->fn_sum = (double *)calloc(p_state->fn_num_bins, sizeof(double));
+    if (!p_state->z || !p_state->parent || !p_state->size || !p_state->z_sum || !p_state->fn_sum)
+    {
+        fprintf(stderr, "Error: failed to allocate the contact network statistics\n");
+        cn_free(p_state);
+        return;
+    }
+    p_state->fp = fopen("data/contact_network.csv", "w");
+    if (p_state->fp)
+        fprintf(p_state->fp, "step,time,Z,rattler_frac,sliding_frac,fn_mean,Fxx,Fyy,Fzz,Fxy,Fxz,Fyz,strong_frac,num_chains,chain_max\n");
+    else
+        fprintf(stderr, "Error: cannot open data/contact_network.csv for writing\n");
+
+    struct Analysis analysis = {.name = "contact network", .num_dt = p_parameters->num_dt_contacts, .final = false,
+                                .fields = 0u, .contacts = true, .state = p_state,
+                                .sample = cn_sample, .finish = cn_finish, .free = cn_free, .merge = NULL};
+    analysis_add(p_set, &analysis);
+}
@@ -0,0 +1,28 @@
+#ifndef CONTACTNET_H_
+#define CONTACTNET_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Register the contact network statistics as an analysis (if num_dt_contacts > 0). They are computed in
+ * place from the particle-particle contacts of the collision list, without a copy of the network as a graph.
+ * Each sample appends to data/contact_network.csv:
+ * - Z: coordination number, rattler_frac: fraction of particles with less than two contacts
+ * - sliding_frac: fraction of contacts at the Coulomb limit
+ * - fn_mean: mean normal force
+ * - Fxx..Fyz: fabric tensor, the mean of n n over the contacts with normal n
+ * - strong_frac: fraction of contacts with a normal force above chain_fn_ratio times the mean
+ * - num_chains, chain_max: number of force chains and particles in the largest one, from a union-find pass over
+ *   the strong contacts; a chain is a cluster of at least chain_min_size particles
+ * 
+ * The coordination distribution and the distribution of the normal force over its mean, averaged over the samples,
+ * are written to data/coordination_pdf.csv and data/fn_pdf.csv at the end of the run. Wall contacts are not included.
+ * 
+ * @param[in] p_parameters used members: num_dt_contacts, contact_fn_num_bins, contact_fn_max, chain_fn_ratio,
+ * chain_min_size, fric_pp, num_part
+ * @param[in,out] p_set 
+ */
+void contactnet_register(struct Parameters *p_parameters, struct AnalysisSet *p_set);
+
+#endif /* CONTACTNET_H_ */
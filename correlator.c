@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "analysis.h"
+#include "correlator.h"
+
+static size_t correlator_group(const struct CorrelatorState *p_state, int type)
+{
+    if (type <= 0)
+        return 0;
+    return (size_t)type < p_state->num_groups ? (size_t)type : p_state->num_groups - 1;
+}
+
+static void correlator_sample(struct Analysis *p_analysis, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    struct CorrelatorState *p_state = (struct CorrelatorState *)p_analysis->state;
+    size_t num_part = p_state->num_part, p = p_state->p, m = p_state->m, num_levels = p_state->num_levels;
+    struct Vec3D L = p_parameters->L;
+
+    // the latest unwrapped position is the decimated sample of every level
+    for (size_t i = 0; i < num_part; ++i)
+    {
+        p_state->unwrapped[i].x = p_snap->r[i].x + p_snap->image[i].x * L.x;
+        p_state->unwrapped[i].y = p_snap->r[i].y + p_snap->image[i].y * L.y;
+        p_state->unwrapped[i].z = p_snap->r[i].z + p_snap->image[i].z * L.z;
+    }
+
+    const struct Vec3D *vel_in = p_snap->v;
+    for (size_t l = 0; l < num_levels; ++l)
+    {
+        size_t n = p_state->num_inserted[l];
+        size_t slot = n % p;
+        size_t k_min = (l == 0) ? 0 : p / m; // shorter lags are resolved by the level below
+        size_t k_max = (n < p - 1) ? n : p - 1;
+        bool pass = ((n + 1) % m == 0) && (l + 1 < num_levels);
+        double *slot_time = &p_state->slot_time[l * p];
+        slot_time[slot] = p_snap->time;
+        for (size_t k = k_min; k <= k_max; ++k)
+        {
+            p_state->lag_time[l * p + k] += p_snap->time - slot_time[(slot + p - k) % p];
+            p_state->lag_count[l * p + k] += 1.0;
+        }
+
+        for (size_t i = 0; i < num_part; ++i)
+        {
+            struct Vec3D *pos = &p_state->pos[(l * num_part + i) * p];
+            struct Vec3D *vel = &p_state->vel[(l * num_part + i) * p];
+            struct Vec3D *p_acc = &p_state->vel_acc[l * num_part + i];
+            struct Vec3D ri = p_state->unwrapped[i], vi = vel_in[i];
+            pos[slot] = ri;
+            vel[slot] = vi;
+
+            size_t g = correlator_group(p_state, p_snap->type[i]);
+            double *msd = &p_state->msd[(g * num_levels + l) * p];
+            double *vacf = &p_state->vacf[(g * num_levels + l) * p];
+            double *num_corr = &p_state->num_corr[(g * num_levels + l) * p];
+            for (size_t k = k_min; k <= k_max; ++k)
+            {
+                size_t j = (slot + p - k) % p;
+                double dx = ri.x - pos[j].x, dy = ri.y - pos[j].y, dz = ri.z - pos[j].z;
+                msd[k] += dx * dx + dy * dy + dz * dz;
+                vacf[k] += vi.x * vel[j].x + vi.y * vel[j].y + vi.z * vel[j].z;
+                num_corr[k] += 1.0;
+            }
+
+            p_acc->x += vi.x;
+            p_acc->y += vi.y;
+            p_acc->z += vi.z;
+            if (pass)
+            {
+                // vel_in may be vel_next: element i has been used above
+                p_state->vel_next[i] = (struct Vec3D){p_acc->x / m, p_acc->y / m, p_acc->z / m};
+                *p_acc = (struct Vec3D){0.0, 0.0, 0.0};
+            }
+        }
+        p_state->num_inserted[l]++;
+        if (!pass)
+            break;
+        vel_in = p_state->vel_next;
+    }
+}
+
+static void correlator_finish(struct Analysis *p_analysis, struct Parameters *p_parameters)
+{
+    struct CorrelatorState *p_state = (struct CorrelatorState *)p_analysis->state;
+    size_t p = p_state->p, num_levels = p_state->num_levels;
+    FILE *fp = fopen("data/msd_vacf.csv", "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Error: cannot open data/msd_vacf.csv for writing\n");
+        return;
+    }
+    fprintf(fp, "group,lag_steps,lag_time,msd,vacf,num\n");
+    for (size_t g = 0; g < p_state->num_groups; ++g)
+    {
+        size_t spacing = p_parameters->num_dt_corr; // time steps between the samples of a level
+        for (size_t l = 0; l < num_levels; ++l, spacing *= p_state->m)
+            for (size_t k = 0; k < p; ++k)
+            {
+                size_t idx = (g * num_levels + l) * p + k;
+                if (p_state->num_corr[idx] == 0.0)
+                    continue;
+                fprintf(fp, "%lu,%lu,%g,%g,%g,%g\n", (long unsigned)g, (long unsigned)(k * spacing),
+                        p_state->lag_time[l * p + k] / p_state->lag_count[l * p + k], p_state->msd[idx] / p_state->num_corr[idx],
+                        p_state->vacf[idx] / p_state->num_corr[idx], p_state->num_corr[idx]);
+            }
+    }
+    fclose(fp);
+}
+
+static void correlator_free(void *state)
+{
+    struct CorrelatorState *p_state = (struct CorrelatorState *)state;
+    if (p_state == NULL)
+        return;
+    free(p_state->pos);
+    free(p_state->vel);
+    free(p_state->vel_acc);
+    free(p_state->unwrapped);
+    free(p_state->vel_next);
+    free(p_state->num_inserted);
+    free(p_state->slot_time);
+    free(p_state->lag_time);
+    free(p_state->lag_count);
+    free(p_state->msd);
+    free(p_state->vacf);
+    free(p_state->num_corr);
+    free(p_state);
+}
+
+void correlator_register(struct Parameters *p_parameters, struct AnalysisSet *p_set)
+{
+    if (p_parameters->num_dt_corr == 0 || p_parameters->corr_num_levels == 0 || p_parameters->corr_num_groups == 0)
+        return;
+    size_t p = p_parameters->corr_p, m = p_parameters->corr_m;
+    if (m < 2 || p < m || p % m != 0)
+    {
+        fprintf(stderr, "Warning: MSD and VACF correlators off, corr_p must be a multiple of corr_m >= 2\n");
+        return;
+    }
+    struct CorrelatorState *p_state = (struct CorrelatorState *)calloc(1, sizeof(struct CorrelatorState));
+    if (p_state == NULL)
+        return;
+    size_t num_part = p_parameters->num_part, num_levels = p_parameters->corr_num_levels;
+    size_t num_sums = p_parameters->corr_num_groups * num_levels * p;
+    p_state->num_part = num_part;
+    p_state->num_groups = p_parameters->corr_num_groups;
+    p_state->num_levels = num_levels;
+    p_state->p = p;
+    p_state->m = m;
+    p_state->pos = (struct Vec3D *)malloc(num_levels * num_part * p * sizeof(struct Vec3D));
+    p_state->vel = (struct Vec3D *)malloc(num_levels * num_part * p * sizeof(struct Vec3D));
+    p_state->vel_acc = (struct Vec3D *)calloc(num_levels * num_part, sizeof(struct Vec3D));
+    p_state->unwrapped = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
+    p_state->vel_next = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
+    p_state->num_inserted = (size_t *)calloc(num_levels, sizeof(size_t));
+    p_state->slot_time = (double *)calloc(num_levels * p, sizeof(double));
+    p_state->lag_time = (double *)calloc(num_levels * p, sizeof(double));
+    p_state->lag_count = (double *)calloc(num_levels * p, sizeof(double));
+    p_state->msd = (double *)calloc(num_sums, sizeof(double));
+    p_state->vacf = (double *)calloc(num_sums, sizeof(double));
+    p_state->num_corr = (double *)calloc(num_sums, sizeof(double));
+    if (p_state->pos == NULL || p_state->vel == NULL || p_state->vel_acc == NULL || p_state->unwrapped == NULL ||
+        p_state->vel_next == NULL || p_state->num_inserted == NULL || p_state->slot_time == NULL ||
+        p_state->lag_time == NULL || p_state->lag_count == NULL || p_state->msd == NULL || p_state->vacf == NULL ||
+        p_state->num_corr == NULL)
+    {
+        fprintf(stderr, "Error: failed to allocate the MSD and VACF correlators\n");
+        correlator_free(p_state);
+        return;
+    }
+
+    struct Analysis analysis = {.name = "MSD and VACF correlators", .num_dt = p_parameters->num_dt_corr, .final = false,
+                                .fields = SNAPSHOT_FIELD_IMAGE, .contacts = false, .state = p_state,
+                                .sample = correlator_sample, .finish = correlator_finish, .free = correlator_free, .merge = NULL};
+    analysis_add(p_set, &analysis);
+}
@@ -0,0 +1,21 @@
+#ifndef CORRELATOR_H_
+#define CORRELATOR_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Register streaming multi-tau correlators of the mean-squared displacement and the velocity autocorrelation
+ * as an analysis (if num_dt_corr > 0). Positions are unwrapped with the periodic images of @ref boundary_conditions.
+ * Level l keeps the last corr_p samples of every particle, spaced corr_m^l samples apart: positions are decimated,
+ * velocities averaged over blocks of corr_m samples of the level below. Each new sample is correlated with the
+ * buffered ones, so lags up to corr_p * corr_m^(corr_num_levels - 1) samples need O(corr_p * corr_num_levels)
+ * memory per particle, independent of the run length. The MSD includes the mean drift of the group. The averages
+ * per group (particle type) and lag are written to data/msd_vacf.csv at the end of the run.
+ * 
+ * @param[in] p_parameters used members: num_dt_corr, corr_num_levels, corr_p, corr_m, corr_num_groups, num_part
+ * @param[in,out] p_set
+ */
+void correlator_register(struct Parameters *p_parameters, struct AnalysisSet *p_set);
+
+#endif /* CORRELATOR_H_ */
@@ -152,6 +152,7 @@ void boundary_conditions(struct Parameters *p_parameters, struct Vectors *p_vect
 {
     struct Vec3D invL;  // Inverse of the box size
     struct Vec3D *r = p_vectors->r;  // Particle positions
+    struct Image3D *image = p_vectors->image;  // Periodic images of the particles
     struct Vec3D L = p_parameters->L;  // Box dimensions
     size_t num_part = p_parameters->num_part;  // Number of particles
 
@@ -159,11 +160,17 @@ void boundary_conditions(struct Parameters *p_parameters, struct Vectors *p_vect
     invL.y = 1.0 / L.y;
     invL.z = 1.0 / L.z;
 
-    // Loop over all particles and apply periodic boundary conditions
+    // Loop over all particles, apply periodic boundary conditions and count the images
     for (size_t i = 0; i < num_part; i++)
     {
-        r[i].x -= L.x * floor(r[i].x * invL.x);  // Apply periodic boundary in x-direction
-        r[i].y -= L.y * floor(r[i].y * invL.y);  // Apply periodic boundary in y-direction
-        r[i].z -= L.z * floor(r[i].z * invL.z);  // Apply periodic boundary in z-direction
+        double sx = floor(r[i].x * invL.x);
+        double sy = floor(r[i].y * invL.y);
+        double sz = floor(r[i].z * invL.z);
+        r[i].x -= L.x * sx;  // Apply periodic boundary in x-direction
+        r[i].y -= L.y * sy;  // Apply periodic boundary in y-direction
+        r[i].z -= L.z * sz;  // Apply periodic boundary in z-direction
+        image[i].x += (int32_t)sx;
+        image[i].y += (int32_t)sy;
+        image[i].z += (int32_t)sz;
     }
 }
@@ -36,4 +36,4 @@ void boundary_conditions(struct Parameters *p_parameters, struct Vectors *p_vect
 
 
 
-#endif /* DYNAMICS_H_ */
\ No newline at end of file
+#endif /* DYNAMICS_H_ */
\ No newline at end of file
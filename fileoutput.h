@@ -1,14 +1,16 @@
 #ifndef FILEOUTPUT_H_
 #define FILEOUTPUT_H_
-void profile_accumulators_init(struct Parameters *p_parameters);
-void profile_accumulators_add_sample(struct Parameters *p_parameters, struct Vectors *p_vectors);
-void profile_accumulators_write_average(struct Parameters *p_parameters);
-void characterize_final_pile(struct Parameters *parameters, struct Vectors *vectors);
-
-
-void compute_profiles(struct Parameters *p_parameters, struct Vectors *p_vectors);
-void compute_profiles_center_based(struct Parameters *p_parameters, struct Vectors *p_vectors);
 
+/**
+ * @brief Print and store h_max, R_base and slope of the final pile in data/final_pile_surface.csv
+ * 
+ * @param parameters used members: R_cyl, num_part, reset_final_pile
+ * @param h_max peak height of the surface
+ * @param R_base runout radius
+ * @param slope_rad slope angle of the surface
+ * @param step number of time steps that were run
+ */
+void record_final_pile(struct Parameters *parameters, double h_max, double R_base, double slope_rad, size_t step);
 
 /**
  * @brief Output particle positions to xyz file
@@ -19,20 +21,4 @@ void compute_profiles_center_based(struct Parameters *p_parameters, struct Vecto
  */
 void record_trajectories_xyz(int reset, struct Parameters * p_parameters, struct Vectors * p_vectors);
 
-/**
- * @brief Save a restart file
- * 
- * @param p_parameters 
- * @param p_vectors 
- */
-void save_restart(struct Parameters *p_parameters, struct Vectors *p_vectors);
-
-/**
- * @brief Load a restart file
- * 
- * @param p_parameters 
- * @param p_vectors 
- */
-void load_restart(struct Parameters *p_parameters, struct Vectors *p_vectors);
-
 #endif /* FILEOUTPUT_H_ */
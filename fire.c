@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "fire.h"
+
+void fire_init(struct Parameters *p_parameters, struct FireState *p_fire)
+{
+    p_fire->dt_md = p_parameters->dt;
+    fire_reset(p_parameters, p_fire);
+}
+
+void fire_reset(struct Parameters *p_parameters, struct FireState *p_fire)
+{
+    p_parameters->dt = p_fire->dt_md;
+    p_fire->alpha = p_parameters->fire_alpha_start;
+    p_fire->n_pos = 0;
+    p_fire->Ekin_max = 0.0;
+    p_fire->active = false;
+}
+
+// FIRE (Bitzek et al., PRL 97, 170201, 2006) applied to the translational velocities
+void fire_update(struct Parameters *p_parameters, struct FireState *p_fire, struct Vectors *p_vectors, double Ekin)
+{
+    size_t num_part = p_parameters->num_part;
+    struct Vec3D *v = p_vectors->v;
+    struct Vec3D *f = p_vectors->f;
+
+    // the column compacts by normal dynamics: FIRE drains the kinetic energy of the collapse and would
+    // freeze a loose packing, so it takes over once that energy has decayed to a fraction of its peak
+    if (!p_fire->active)
+    {
+        if (Ekin > p_fire->Ekin_max)
+            p_fire->Ekin_max = Ekin;
+        if (Ekin >= p_parameters->fire_Ekin_ratio * p_fire->Ekin_max)
+            return;
+        p_fire->active = true;
+    }
+
+    double P = 0.0;
+    for (size_t i = 0; i < num_part; i++)
+        P += f[i].x * v[i].x + f[i].y * v[i].y + f[i].z * v[i].z;
+
+    if (P > 0.0)
+    {
+        // turn the velocity of each particle towards its force, keeping its speed
+        double alpha = p_fire->alpha;
+        for (size_t i = 0; i < num_part; i++)
+        {
+            double f_sq = f[i].x * f[i].x + f[i].y * f[i].y + f[i].z * f[i].z;
+            double v_sq = v[i].x * v[i].x + v[i].y * v[i].y + v[i].z * v[i].z;
+            double fctr = (f_sq > 0.0 ? alpha * sqrt(v_sq / f_sq) : 0.0);
+            v[i].x = (1.0 - alpha) * v[i].x + fctr * f[i].x;
+            v[i].y = (1.0 - alpha) * v[i].y + fctr * f[i].y;
+            v[i].z = (1.0 - alpha) * v[i].z + fctr * f[i].z;
+        }
+        p_fire->n_pos++;
+        if (p_fire->n_pos > p_parameters->fire_N_min)
+        {
+            double dt = p_parameters->dt * p_parameters->fire_f_inc;
+            p_parameters->dt = (dt < p_parameters->fire_dt_max ? dt : p_parameters->fire_dt_max);
+            p_fire->alpha *= p_parameters->fire_f_alpha;
+        }
+    }
+    else
+    {
+        // uphill: shrink the time step (not below that of normal dynamics) and stop the particles that move
+        // against their force. Rattlers falling in their cage keep their velocity; stopping them as well
+        // would hold them in mid-air, with a net force of one particle weight that never relaxes.
+        p_fire->n_pos = 0;
+        double dt = p_parameters->dt * p_parameters->fire_f_dec;
+        p_parameters->dt = (dt > p_fire->dt_md ? dt : p_fire->dt_md);
+        p_fire->alpha = p_parameters->fire_alpha_start;
+        for (size_t i = 0; i < num_part; i++)
+        {
+            if (f[i].x * v[i].x + f[i].y * v[i].y + f[i].z * v[i].z <= 0.0)
+            {
+                v[i] = (struct Vec3D){0.0, 0.0, 0.0};
+                p_vectors->omega[i] = (struct Vec3D){0.0, 0.0, 0.0};
+            }
+        }
+    }
+}
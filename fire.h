@@ -0,0 +1,36 @@
+#ifndef FIRE_H_
+#define FIRE_H_
+
+/**
+ * @brief Initialise the FIRE minimizer and remember the time step of normal dynamics
+ * 
+ * @param p_parameters used members: dt, fire_alpha_start
+ * @param p_fire FIRE state
+ */
+void fire_init(struct Parameters *p_parameters, struct FireState *p_fire);
+
+/**
+ * @brief Restore the time step of normal dynamics and restart the mixing parameter and the compaction stage.
+ * Called when a phase starts, so a FIRE phase hands off to dynamics with the original time step.
+ * 
+ * @param p_parameters used members: fire_alpha_start; set members: dt
+ * @param p_fire FIRE state
+ */
+void fire_reset(struct Parameters *p_parameters, struct FireState *p_fire);
+
+/**
+ * @brief Apply the FIRE velocity modification after a velocity-Verlet step.
+ * Nothing is changed until Ekin has dropped below fire_Ekin_ratio times its peak in the phase, so the collapse of
+ * the column compacts it by normal dynamics first. Then, if the power F.v is positive, the velocity of each
+ * particle is turned towards its force and, after fire_N_min such steps, the time step grows up to fire_dt_max.
+ * Otherwise the time step is reduced, but not below that of normal dynamics, and the particles that move against
+ * their force are stopped.
+ * 
+ * @param p_parameters used members: fire_*; set members: dt
+ * @param p_fire FIRE state
+ * @param p_vectors used members: f; set members: v, omega
+ * @param Ekin kinetic energy
+ */
+void fire_update(struct Parameters *p_parameters, struct FireState *p_fire, struct Vectors *p_vectors, double Ekin);
+
+#endif /* FIRE_H_ */
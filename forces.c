@@ -4,11 +4,24 @@
 #include "constants.h"
 #include "structs.h"
 #include "nbrlist.h"
+#include "timing.h"
 #include "forces.h"
 
+// Add a*w to the contact stress t
+static void add_virial(struct SymTensor *t, double a, const struct SymTensor *w)
+{
+    t->xx += a * w->xx;
+    t->yy += a * w->yy;
+    t->zz += a * w->zz;
+    t->xy += a * w->xy;
+    t->xz += a * w->xz;
+    t->yz += a * w->yz;
+}
+
 // Compute all forces on particles
 // This function returns the total potential energy of the system.
-double calculate_forces(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors)
+double calculate_forces(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors, bool virial,
+                        struct Timing *p_timing)
 {
     double Epot = 0.0;
     struct Vec3D *f = p_vectors->f;
@@ -27,15 +40,49 @@ double calculate_forces(struct Parameters *p_parameters, struct Colllist *p_coll
         f[i].z = mass[i]*g.z;
         T[i] = (struct Vec3D){0.0, 0.0, 0.0};
     }
-    Epot += calculate_forces_pp(p_parameters, p_colllist, p_vectors);
-    Epot += calculate_forces_pw(p_parameters, p_colllist, p_vectors);
+    if (p_parameters->damping > 0.0) // background damping of the active phase
+    {
+        const double damping = p_parameters->damping;
+        struct Vec3D *v = p_vectors->v;
+        for (size_t i = 0; i < num_part; i++)
+        {
+            f[i].x -= damping * mass[i] * v[i].x;
+            f[i].y -= damping * mass[i] * v[i].y;
+            f[i].z -= damping * mass[i] * v[i].z;
+        }
+    }
+    struct SymTensor *stress = virial ? p_vectors->stress : NULL;
+    if (stress != NULL)
+        for (size_t i = 0; i < num_part; i++)
+            stress[i] = (struct SymTensor){0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    timing_lap(p_timing, TIMER_OTHER);
+    Epot += calculate_forces_pp(p_parameters, p_colllist, p_vectors, stress);
+    timing_lap(p_timing, TIMER_FORCES_PP);
+    Epot += calculate_forces_pw(p_parameters, p_colllist, p_vectors, stress);
+    timing_lap(p_timing, TIMER_FORCES_PW);
+    if (stress != NULL) // virial to stress: divide by the particle volume
+    {
+        double *R = p_vectors->radius;
+        for (size_t i = 0; i < num_part; i++)
+        {
+            double inv_vol = 3.0 / (4.0 * PI * R[i] * R[i] * R[i]);
+            stress[i].xx *= inv_vol;
+            stress[i].yy *= inv_vol;
+            stress[i].zz *= inv_vol;
+            stress[i].xy *= inv_vol;
+            stress[i].xz *= inv_vol;
+            stress[i].yz *= inv_vol;
+        }
+        timing_lap(p_timing, TIMER_OTHER);
+    }
     return Epot;
 }
 
 // Compute all forces on particles die to particle-particle contacts
 // The function implement a soft-sphere model and used a collision list  
 // This function returns the potential energy of (the concervative part of) these interactions
-double calculate_forces_pp(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors)
+double calculate_forces_pp(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors,
+                           struct SymTensor *stress)
 {
     double Epot = 0.0;
     const double k_n_pp = p_parameters->k_n_pp;
@@ -45,6 +92,9 @@ double calculate_forces_pp(struct Parameters *p_parameters, struct Colllist *p_c
     const double fric_pp = p_parameters->fric_pp;
     struct Pair *nbr = p_colllist->nbr;
     struct DeltaR *tijs = p_colllist->tij;
+    double *fn_sq = p_colllist->fn_sq;
+    double *ft_sq = p_colllist->ft_sq;
+    struct Vec3D *fij = p_colllist->fij;
     const size_t num_nbrs = p_colllist->num_nbrs;
     const size_t num_part = p_parameters->num_part;
     double * R = p_vectors->radius;
@@ -119,13 +169,24 @@ double calculate_forces_pp(struct Parameters *p_parameters, struct Colllist *p_c
             tijs[k].x = -dft.x / k_t_pp;
             tijs[k].y = -dft.y / k_t_pp;
             tijs[k].z = -dft.z / k_t_pp;
+            dft.sq = fric_pp * fric_pp * dfn.sq;
         }
         else
             Epot += 0.5 * k_t_pp * tij.sq;
+        fn_sq[k] = dfn.sq;
+        ft_sq[k] = dft.sq;
         struct Vec3D df;
         df.x = dfn.x + dft.x;
         df.y = dfn.y + dft.y;
         df.z = dfn.z + dft.z;
+        fij[k] = df;
+        if (stress != NULL) // pair virial rij x df, split at the contact point along the branch vectors of i and j
+        {
+            struct SymTensor w = {rij.x * df.x, rij.y * df.y, rij.z * df.z, 0.5 * (rij.x * df.y + rij.y * df.x),
+                                  0.5 * (rij.x * df.z + rij.z * df.x), 0.5 * (rij.y * df.z + rij.z * df.y)};
+            add_virial(&stress[i], (R[i] - 0.5 * overlap) / r, &w);
+            add_virial(&stress[j], (R[j] - 0.5 * overlap) / r, &w);
+        }
         struct Vec3D dT;
         dT.x = 0.5 * (rij.z * dft.y - rij.y * dft.z);
         dT.y = 0.5 * (rij.x * dft.z - rij.z * dft.x);
@@ -149,7 +210,8 @@ double calculate_forces_pp(struct Parameters *p_parameters, struct Colllist *p_c
 // Compute forces on particles due to particle-wall contacts
 // The function implement a soft-sphere model and used a collision list
 // This function returns the potential energy of (the concervative part of) these interactions
-double calculate_forces_pw(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors)
+double calculate_forces_pw(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors,
+                           struct SymTensor *stress)
 {
     double Epot = 0.0;
     double *k_n_pw = p_parameters->k_n_pw;
@@ -238,9 +300,16 @@ double calculate_forces_pw(struct Parameters *p_parameters, struct Colllist *p_c
         f[i].x += dfn.x + dft.x;
         f[i].y += dfn.y + dft.y;
         f[i].z += dfn.z + dft.z;
+        if (stress != NULL) // the branch vector to the wall contact is -riw
+        {
+            struct Vec3D df = {dfn.x + dft.x, dfn.y + dft.y, dfn.z + dft.z};
+            struct SymTensor w = {rij.x * df.x, rij.y * df.y, rij.z * df.z, 0.5 * (rij.x * df.y + rij.y * df.x),
+                                  0.5 * (rij.x * df.z + rij.z * df.x), 0.5 * (rij.y * df.z + rij.z * df.y)};
+            add_virial(&stress[i], 1.0, &w);
+        }
         T[i].x += (rij.z * dft.y - rij.y * dft.z);
         T[i].y += (rij.x * dft.z - rij.z * dft.x);
         T[i].z += (rij.y * dft.x - rij.x * dft.y);
     }
     return Epot; 
-}
\ No newline at end of file
+}
\ No newline at end of file
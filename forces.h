@@ -1,32 +1,43 @@
 #ifndef FORCES_H_
 #define FORCES_H_
 
+#include <stdbool.h>
+
 /**
  * @brief Calculate forces and torques on particles
  * @param p_parameters
  * @param p_colllist
  * @param[out] p_vectors used members
+ * @param virial also compute the contact stress per particle in p_vectors->stress (if allocated): the sum over
+ * its contacts of the branch vector (centre to contact point) times the contact force, with a minus sign so
+ * that compression is positive, divided by the particle volume
+ * @param[in,out] p_timing laps of the particle-particle and particle-wall forces, NULL: not timed
  * @return double potential energy
  */
-double calculate_forces(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors);
+double calculate_forces(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors, bool virial,
+                        struct Timing *p_timing);
 
 /**
  * @brief Calculate particle-particle forces and torques on particles
  * @param p_parameters
  * @param p_colllist
  * @param[out] p_vectors used members
+ * @param[in,out] stress contact virials per particle to add to, NULL: skip
  * @return double potential energy
  */
-double calculate_forces_pp(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors);
+double calculate_forces_pp(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors,
+                           struct SymTensor *stress);
 
 /**
  * @briefCalculate particle-wall forces and torques on particles
  * @param p_parameters
  * @param p_colllist used members: num_nbrs, nbr, tij
  * @param[out] p_vectors used members: f
+ * @param[in,out] stress contact virials per particle to add to, NULL: skip
  * @return double potential energy
  */
-double calculate_forces_pw(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors);
+double calculate_forces_pw(struct Parameters *p_parameters, struct Colllist *p_colllist, struct Vectors *p_vectors,
+                           struct SymTensor *stress);
 
 
 #endif /* FORCES_H_ */
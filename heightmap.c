@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "analysis.h"
+#include "fileoutput.h"
+#include "heightmap.h"
+
+static size_t hm_index(double x, double cell, size_t num)
+{
+    long i = (long)floor(x / cell);
+    if (i < 0)
+        return 0;
+    if ((size_t)i >= num)
+        return num - 1;
+    return (size_t)i;
+}
+
+// Least-squares slope of h(r) on the flank of the pile, as an angle (positive for a surface falling outwards)
+static double hm_fit_slope(const struct HeightMapState *p_state, const struct Parameters *p_parameters)
+{
+    size_t peak = 0;
+    for (size_t ib = 1; ib < p_state->num_bins; ++ib)
+        if (p_state->h_r[ib] > p_state->h_r[peak])
+            peak = ib;
+    double h_lo = p_parameters->hm_fit_lo * p_state->h_peak;
+    double h_hi = p_parameters->hm_fit_hi * p_state->h_peak;
+    double n = 0.0, sr = 0.0, sh = 0.0, srr = 0.0, srh = 0.0;
+    for (size_t ib = peak; ib < p_state->num_bins; ++ib)
+    {
+        double r = (ib + 0.5) * p_state->cell;
+        double h = p_state->h_r[ib];
+        if (r > p_state->R_runout)
+            break;
+        if (h < h_lo || h > h_hi)
+            continue;
+        n += 1.0;
+        sr += r;
+        sh += h;
+        srr += r * r;
+        srh += r * h;
+    }
+    double denom = n * srr - sr * sr;
+    if (n < 2.0 || denom <= 0.0)
+        return 0.0;
+    return atan(-(n * srh - sr * sh) / denom);
+}
+
+static void hm_sample(struct Analysis *p_analysis, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    struct HeightMapState *p_state = (struct HeightMapState *)p_analysis->state;
+    // the final pile may be the last sample of the time series already
+    bool repeat = p_analysis->num_samples > 0 && p_snap->step == p_state->step;
+
+    // reset the columns of the previous snapshot only
+    for (size_t k = 0; k < p_state->num_touched; ++k)
+        p_state->h[p_state->touched[k]] = 0.0;
+    p_state->num_touched = 0;
+
+    for (size_t i = 0; i < p_snap->num_part; ++i)
+    {
+        size_t ix = hm_index(p_snap->r[i].x, p_state->cell, p_state->num_x);
+        size_t iy = hm_index(p_snap->r[i].y, p_state->cell, p_state->num_y);
+        size_t c = ix * p_state->num_y + iy;
+        double top = p_snap->r[i].z + p_snap->radius[i];
+        if (p_state->h[c] == 0.0)
+            p_state->touched[p_state->num_touched++] = c;
+        if (top > p_state->h[c])
+            p_state->h[c] = top;
+    }
+
+    for (size_t ib = 0; ib < p_state->num_bins; ++ib)
+        p_state->h_r[ib] = p_state->coverage[ib] = 0.0;
+    for (size_t k = 0; k < p_state->num_touched; ++k)
+    {
+        size_t c = p_state->touched[k];
+        size_t ib = p_state->bin[c];
+        p_state->h_r[ib] += p_state->h[c];
+        p_state->coverage[ib] += 1.0;
+    }
+    p_state->h_peak = 0.0;
+    p_state->R_runout = 0.0;
+    bool contiguous = true;
+    for (size_t ib = 0; ib < p_state->num_bins; ++ib)
+    {
+        if (p_state->num_columns[ib] == 0)
+            continue;
+        p_state->h_r[ib] /= (double)p_state->num_columns[ib];
+        p_state->coverage[ib] /= (double)p_state->num_columns[ib];
+        if (p_state->h_r[ib] > p_state->h_peak)
+            p_state->h_peak = p_state->h_r[ib];
+        contiguous = contiguous && p_state->coverage[ib] >= p_parameters->hm_coverage;
+        if (contiguous)
+            p_state->R_runout = (ib + 1) * p_state->cell;
+    }
+    p_state->slope = hm_fit_slope(p_state, p_parameters);
+    p_state->step = p_snap->step;
+
+    if (p_state->fp_runout && !repeat)
+    {
+        fprintf(p_state->fp_runout, "%lu,%g,%g,%g,%g,%g\n", (long unsigned)p_snap->step, p_snap->time, p_state->h_peak,
+                p_state->R_runout, p_state->slope * 180.0 / PI, p_state->slope);
+        fflush(p_state->fp_runout);
+    }
+    if (p_state->fp_profile && !repeat)
+    {
+        fprintf(p_state->fp_profile, "%lu,%g", (long unsigned)p_snap->step, p_snap->time);
+        for (size_t ib = 0; ib < p_state->num_bins; ++ib)
+            fprintf(p_state->fp_profile, ",%g", p_state->h_r[ib]);
+        fprintf(p_state->fp_profile, "\n");
+        fflush(p_state->fp_profile);
+    }
+}
+
+// The last sample is the final pile
+static void hm_finish(struct Analysis *p_analysis, struct Parameters *p_parameters)
+{
+    struct HeightMapState *p_state = (struct HeightMapState *)p_analysis->state;
+    record_final_pile(p_parameters, p_state->h_peak, p_state->R_runout, p_state->slope, p_state->step);
+
+    FILE *fp = fopen("data/heightmap_final.csv", "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Error: cannot open data/heightmap_final.csv for writing\n");
+        return;
+    }
+    fprintf(fp, "x,y,h\n");
+    for (size_t ix = 0; ix < p_state->num_x; ++ix)
+        for (size_t iy = 0; iy < p_state->num_y; ++iy)
+            fprintf(fp, "%g,%g,%g\n", (ix + 0.5) * p_state->cell, (iy + 0.5) * p_state->cell,
+                    p_state->h[ix * p_state->num_y + iy]);
+    fclose(fp);
+}
+
+static void hm_free(void *state)
+{
+    struct HeightMapState *p_state = (struct HeightMapState *)state;
+    if (p_state == NULL)
+        return;
+    if (p_state->fp_runout)
+        fclose(p_state->fp_runout);
+    if (p_state->fp_profile)
+        fclose(p_state->fp_profile);
+    free(p_state->h);
+    free(p_state->touched);
+    free(p_state->bin);
+    free(p_state->num_columns);
+    free(p_state->h_r);
+    free(p_state->coverage);
+    free(p_state);
+}
+
+void heightmap_register(struct Parameters *p_parameters, struct AnalysisSet *p_set)
+{
+    // the final pile is always characterised; without a valid hm_cell only the time series is off
+    size_t num_dt = p_parameters->num_dt_heightmap;
+    if (p_parameters->hm_cell <= 0.0)
+    {
+        fprintf(stderr, "Warning: surface height map time series off, hm_cell <= 0; final pile on columns of 2 R_max\n");
+        num_dt = 0;
+    }
+    struct HeightMapState *p_state = (struct HeightMapState *)calloc(1, sizeof(struct HeightMapState));
+    if (p_state == NULL)
+        return;
+    p_state->cell = p_parameters->hm_cell > 0.0 ? p_parameters->hm_cell : 2.0 * p_parameters->R_max;
+    p_state->num_x = (size_t)ceil(p_parameters->L.x / p_state->cell);
+    p_state->num_y = (size_t)ceil(p_parameters->L.y / p_state->cell);
+    p_state->axis = (struct Vec3D){0.5 * p_parameters->L.x, 0.5 * p_parameters->L.y, 0.0};
+    double r_corner = sqrt(p_state->axis.x * p_state->axis.x + p_state->axis.y * p_state->axis.y);
+    p_state->num_bins = (size_t)ceil(r_corner / p_state->cell) + 1;
+    size_t num_cells = p_state->num_x * p_state->num_y;
+    p_state->h = (double *)calloc(num_cells, sizeof(double));
+    p_state->touched = (size_t *)malloc(num_cells * sizeof(size_t));
+    p_state->bin = (size_t *)malloc(num_cells * sizeof(size_t));
+    p_state->num_columns = (size_t *)calloc(p_state->num_bins, sizeof(size_t));
+    p_state->h_r = (double *)calloc(p_state->num_bins, sizeof(double));
+    p_state->coverage = (double *)calloc(p_state->num_bins, sizeof(double));
+    if (!p_state->h || !p_state->touched || !p_state->bin || !p_state->num_columns || !p_state->h_r || !p_state->coverage)
+    {
+        fprintf(stderr, "Error: failed to allocate the surface height map\n");
+        hm_free(p_state);
+        return;
+    }
+    for (size_t ix = 0; ix < p_state->num_x; ++ix)
+        for (size_t iy = 0; iy < p_state->num_y; ++iy)
+        {
+            double dx = (ix + 0.5) * p_state->cell - p_state->axis.x;
+            double dy = (iy + 0.5) * p_state->cell - p_state->axis.y;
+            size_t ib = (size_t)(sqrt(dx * dx + dy * dy) / p_state->cell);
+            if (ib >= p_state->num_bins)
+                ib = p_state->num_bins - 1;
+            p_state->bin[ix * p_state->num_y + iy] = ib;
+            p_state->num_columns[ib]++;
+        }
+
+    if (num_dt > 0)
+    {
+        p_state->fp_runout = fopen("data/runout.csv", "w");
+        p_state->fp_profile = fopen("data/surface_profile.csv", "w");
+        if (p_state->fp_runout)
+            fprintf(p_state->fp_runout, "step,time,h_peak,R_runout,slope_deg,slope_rad\n");
+        else
+            fprintf(stderr, "Error: cannot open data/runout.csv for writing\n");
+        if (p_state->fp_profile)
+        {
+            fprintf(p_state->fp_profile, "step,time");
+            for (size_t ib = 0; ib < p_state->num_bins; ++ib)
+                fprintf(p_state->fp_profile, ",%g", (ib + 0.5) * p_state->cell);
+            fprintf(p_state->fp_profile, "\n");
+        }
+        else
+            fprintf(stderr, "Error: cannot open data/surface_profile.csv for writing\n");
+    }
+
+    struct Analysis analysis = {.name = "surface height map", .num_dt = num_dt, .final = true,
+                                .fields = 0u, .contacts = false, .state = p_state,
+                                .sample = hm_sample, .finish = hm_finish, .free = hm_free, .merge = NULL};
+    analysis_add(p_set, &analysis);
+}
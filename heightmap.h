@@ -0,0 +1,26 @@
+#ifndef HEIGHTMAP_H_
+#define HEIGHTMAP_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Register the free-surface height map as an analysis. Every num_dt_heightmap steps (and for the final
+ * pile) the box is divided into vertical columns of edge hm_cell and the surface height of a column is the top
+ * (z + radius) of its highest particle; only the columns touched by the previous snapshot are reset. The column
+ * heights are averaged over radial bins of width hm_cell around the axis to h(r), from which:
+ * - h_peak: maximum of h(r)
+ * - R_runout: outer edge of the outermost bin of the contiguous run of bins from the axis on with at least a
+ *   fraction hm_coverage of their columns covered
+ * - slope: angle of the least-squares line through h(r) outside the peak between hm_fit_lo and hm_fit_hi times h_peak
+ * 
+ * Each snapshot is appended to data/runout.csv and data/surface_profile.csv; the final pile is reported in
+ * data/final_pile_surface.csv and its column heights are written to data/heightmap_final.csv. If hm_cell is not
+ * positive the time series is off and the final pile uses columns of 2 R_max.
+ * 
+ * @param[in] p_parameters used members: num_dt_heightmap, hm_cell, hm_coverage, hm_fit_lo, hm_fit_hi, R_max, L
+ * @param[in,out] p_set 
+ */
+void heightmap_register(struct Parameters *p_parameters, struct AnalysisSet *p_set);
+
+#endif /* HEIGHTMAP_H_ */
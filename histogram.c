@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "structs.h"
+#include "histogram.h"
+
+bool histogram_alloc(struct Histogram *p_hist, size_t nbins, double min, double max)
+{
+    p_hist->nbins = nbins;
+    p_hist->min = min;
+    p_hist->max = max;
+    p_hist->bin_width = (max - min) / (double)nbins;
+    p_hist->total_counts = 0.0;
+    p_hist->delta = 0.0;
+    p_hist->counts = (size_t *)calloc(nbins, sizeof(size_t));
+    p_hist->bin_centers = (double *)malloc(nbins * sizeof(double));
+    if (p_hist->counts == NULL || p_hist->bin_centers == NULL)
+    {
+        histogram_free(p_hist);
+        return false;
+    }
+    for (size_t b = 0; b < nbins; ++b)
+        p_hist->bin_centers[b] = min + (b + 0.5) * p_hist->bin_width;
+    return true;
+}
+
+void histogram_add(struct Histogram *p_hist, double x)
+{
+    p_hist->total_counts += 1.0;
+    double b = floor((x - p_hist->min) / p_hist->bin_width);
+    if (b >= 0.0 && b < (double)p_hist->nbins)
+        p_hist->counts[(size_t)b]++;
+}
+
+void histogram_merge(struct Histogram *p_hist, const struct Histogram *p_other)
+{
+    for (size_t b = 0; b < p_hist->nbins; ++b)
+        p_hist->counts[b] += p_other->counts[b];
+    p_hist->total_counts += p_other->total_counts;
+}
+
+double histogram_pdf(const struct Histogram *p_hist, size_t bin)
+{
+    if (p_hist->total_counts == 0.0)
+        return 0.0;
+    return (double)p_hist->counts[bin] / (p_hist->total_counts * p_hist->bin_width);
+}
+
+void histogram_free(struct Histogram *p_hist)
+{
+    free(p_hist->counts);
+    p_hist->counts = NULL;
+    free(p_hist->bin_centers);
+    p_hist->bin_centers = NULL;
+    p_hist->nbins = 0;
+}
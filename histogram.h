@@ -0,0 +1,50 @@
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Allocate the bins of a histogram of nbins equal bins over min..max
+ * 
+ * @param[out] p_hist 
+ * @param[in] nbins number of bins
+ * @param[in] min lower end of the first bin
+ * @param[in] max upper end of the last bin
+ * @return bool false if out of memory
+ */
+bool histogram_alloc(struct Histogram *p_hist, size_t nbins, double min, double max);
+
+/**
+ * @brief Count a value; values outside min..max only count in total_counts
+ * 
+ * @param[in,out] p_hist 
+ * @param[in] x 
+ */
+void histogram_add(struct Histogram *p_hist, double x);
+
+/**
+ * @brief Add the counts of a histogram with the same bins
+ * 
+ * @param[in,out] p_hist 
+ * @param[in] p_other 
+ */
+void histogram_merge(struct Histogram *p_hist, const struct Histogram *p_other);
+
+/**
+ * @brief Probability density of a bin: its counts over total_counts and the bin width
+ * 
+ * @param[in] p_hist 
+ * @param[in] bin bin index
+ * @return double 0 if nothing was counted
+ */
+double histogram_pdf(const struct Histogram *p_hist, size_t bin);
+
+/**
+ * @brief Free the bins of a histogram
+ * 
+ * @param[in,out] p_hist 
+ */
+void histogram_free(struct Histogram *p_hist);
+
+#endif /* HISTOGRAM_H_ */
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
 #include "constants.h"
 #include "structs.h"
@@ -32,7 +33,10 @@ void initialise(struct Parameters *p_parameters, struct Vectors *p_vectors)
     srand(SEED); // Positive integer as seed for random number generator
     p_vectors->time = 0.0; // Initialize the time to zero
     initialise_particles(p_parameters, p_vectors);
-    initialise_positions_cylinder(p_parameters, p_vectors);
+    if (p_parameters->init_positions == INIT_POSITIONS_DEPOSITION)
+        initialise_positions_deposition(p_parameters, p_vectors);
+    else
+        initialise_positions_cylinder(p_parameters, p_vectors);
     initialise_velocities(p_parameters, p_vectors);
     return;
 }
@@ -119,6 +123,245 @@ void initialise_positions_cylinder(struct Parameters *p_parameters, struct Vecto
     }
 }
 
+/* --- drop-and-roll deposition --- */
+
+// Grid used during deposition: cubic cells of size h covering the bounding box of the cylinder
+struct DepositionGrid
+{
+    struct Celllist cells; //!< cell-linked list of the particles deposited so far
+    struct Vec3D origin;   //!< lower corner of the grid
+    double inv_h;          //!< inverse cell size
+};
+
+// Cell index of position r along one grid direction, clipped to the grid
+static size_t deposition_index(double x, double x0, double inv_h, size_t n)
+{
+    double d = floor((x - x0) * inv_h);
+    if (d < 0.0)
+        return 0;
+    return ((size_t)d >= n ? n - 1 : (size_t)d);
+}
+
+// Push a particle at p with radius Ri out of the floor, the cylinder wall and all deposited particles.
+// Overlaps are removed along the contact normal, or if lift is set by lifting the particle vertically.
+// Contact normals (pointing towards the particle) within a gap of gap_tol are stored in normals, up to max_contacts.
+// Returns the number of contacts found; *p_moved is set to 1 if the position changed.
+static size_t deposition_contacts(struct Parameters *p_parameters, struct Vectors *p_vectors, struct DepositionGrid *p_grid,
+                                  struct Vec3D *p, double Ri, int lift, double gap_tol, struct Vec3D *normals, size_t max_contacts, int *p_moved)
+{
+    size_t num_contacts = 0;
+    struct Vec3D *r = p_vectors->r;
+    double *R = p_vectors->radius;
+    double cx = 0.5 * p_parameters->L.x;
+    double cy = 0.5 * p_parameters->L.y;
+    double R_cyl = p_parameters->R_cyl;
+    struct Index3D n = p_grid->cells.size_grid;
+    struct Index3D c = {deposition_index(p->x, p_grid->origin.x, p_grid->inv_h, n.i),
+                        deposition_index(p->y, p_grid->origin.y, p_grid->inv_h, n.j),
+                        deposition_index(p->z, p_grid->origin.z, p_grid->inv_h, n.k)};
+    *p_moved = 0;
+    for (size_t k = (c.k > 0 ? c.k - 1 : 0); k <= c.k + 1 && k < n.k; ++k)
+        for (size_t j = (c.j > 0 ? c.j - 1 : 0); j <= c.j + 1 && j < n.j; ++j)
+            for (size_t i = (c.i > 0 ? c.i - 1 : 0); i <= c.i + 1 && i < n.i; ++i)
+                for (size_t m = p_grid->cells.head[i + n.i * (j + n.j * k)]; m != SIZE_MAX; m = p_grid->cells.list[m])
+                {
+                    struct DeltaR d = {p->x - r[m].x, p->y - r[m].y, p->z - r[m].z, 0.0};
+                    double sumR = Ri + R[m];
+                    d.sq = d.x * d.x + d.y * d.y + d.z * d.z;
+                    if (d.sq >= (sumR + gap_tol) * (sumR + gap_tol) || d.sq == 0.0)
+                        continue;
+                    double dist = sqrt(d.sq);
+                    if (dist < (1.0 - 1e-6) * sumR) // tolerance avoids endless tiny corrections
+                    {
+                        double dxy_sq = d.x * d.x + d.y * d.y;
+                        if (lift && d.z > 0.0 && dxy_sq < sumR * sumR)
+                        {
+                            // lift the particle vertically onto the sphere below; lifting never creates
+                            // overlaps with the floor or the wall, so repeated corrections converge where
+                            // corrections along the normals may keep pushing the particle back and forth
+                            p->z = r[m].z + sqrt(sumR * sumR - dxy_sq);
+                        }
+                        else
+                        {
+                            double fctr = sumR / dist;
+                            p->x = r[m].x + fctr * d.x;
+                            p->y = r[m].y + fctr * d.y;
+                            p->z = r[m].z + fctr * d.z;
+                        }
+                        d = (struct DeltaR){p->x - r[m].x, p->y - r[m].y, p->z - r[m].z, 0.0};
+                        dist = sumR;
+                        *p_moved = 1;
+                    }
+                    if (num_contacts < max_contacts)
+                        normals[num_contacts++] = (struct Vec3D){d.x / dist, d.y / dist, d.z / dist};
+                }
+    double dx = p->x - cx;
+    double dy = p->y - cy;
+    double dist_xy = sqrt(dx * dx + dy * dy);
+    if (dist_xy + Ri > R_cyl - gap_tol)
+    {
+        if (dist_xy + Ri > R_cyl + 1e-6 * Ri)
+        {
+            double fctr = (R_cyl - Ri) / dist_xy;
+            p->x = cx + fctr * dx;
+            p->y = cy + fctr * dy;
+            *p_moved = 1;
+        }
+        if (num_contacts < max_contacts)
+            normals[num_contacts++] = (struct Vec3D){-dx / dist_xy, -dy / dist_xy, 0.0};
+    }
+    if (p->z < Ri + gap_tol)
+    {
+        if (p->z < Ri)
+        {
+            p->z = Ri;
+            *p_moved = 1;
+        }
+        if (num_contacts < max_contacts)
+            normals[num_contacts++] = (struct Vec3D){0.0, 0.0, 1.0};
+    }
+    return num_contacts;
+}
+
+// Direction of steepest descent under gravity that does not move into any of the contacts.
+// Returns the length of the (unnormalised) direction; zero means the particle rests in a stable pocket.
+static double deposition_descent(struct Vec3D *normals, size_t num_contacts, struct Vec3D *d)
+{
+    *d = (struct Vec3D){0.0, 0.0, -1.0};
+    for (int pass = 0; pass < 16; ++pass)
+    {
+        int projected = 0;
+        for (size_t k = 0; k < num_contacts; ++k)
+        {
+            double dn = d->x * normals[k].x + d->y * normals[k].y + d->z * normals[k].z;
+            if (dn < -1e-12)
+            {
+                d->x -= dn * normals[k].x;
+                d->y -= dn * normals[k].y;
+                d->z -= dn * normals[k].z;
+                projected = 1;
+            }
+        }
+        if (!projected)
+            break;
+    }
+    double d_len = sqrt(d->x * d->x + d->y * d->y + d->z * d->z);
+    return (d->z < 0.0 ? d_len : 0.0);
+}
+
+// Drop-and-roll deposition: particles fall one by one at a random position inside the cylinder
+// and roll down over the particles already deposited until they rest in a stable pocket.
+void initialise_positions_deposition(struct Parameters *p_parameters, struct Vectors *p_vectors)
+{
+    size_t num_part = p_parameters->num_part;
+    double *R = p_vectors->radius;
+    struct Vec3D *r = p_vectors->r;
+    double R_max = 0;
+    for (size_t i = 0; i < num_part; ++i)
+        R_max = (R[i] > R_max ? R[i] : R_max);
+    double cx = 0.5 * p_parameters->L.x;
+    double cy = 0.5 * p_parameters->L.y;
+    double R_cyl = p_parameters->R_cyl;
+    double H = p_parameters->L.z;
+
+    // cells of size 2*R_max: touching particles are always in the same or adjacent cells
+    struct DepositionGrid grid;
+    double h = 2.0 * R_max;
+    grid.inv_h = 1.0 / h;
+    grid.origin = (struct Vec3D){cx - R_cyl, cy - R_cyl, 0.0};
+    grid.cells.size_grid = (struct Index3D){(size_t)ceil(2.0 * R_cyl / h), (size_t)ceil(2.0 * R_cyl / h), (size_t)ceil(H / h)};
+    struct Index3D n = grid.cells.size_grid;
+    grid.cells.num_cells = n.i * n.j * n.k;
+    grid.cells.head = (size_t *)malloc(grid.cells.num_cells * sizeof(size_t));
+    grid.cells.list = (size_t *)malloc(num_part * sizeof(size_t));
+    for (size_t icell = 0; icell < grid.cells.num_cells; ++icell)
+        grid.cells.head[icell] = SIZE_MAX;
+
+    size_t num_above = 0;
+    for (size_t ipart = 0; ipart < num_part; ++ipart)
+    {
+        double Ri = R[ipart];
+        double x, y;
+        do // random point in the unit disk
+        {
+            x = 2.0 * generate_uniform_random() - 1.0;
+            y = 2.0 * generate_uniform_random() - 1.0;
+        } while (x * x + y * y > 1.0);
+        struct Vec3D p = {cx + (R_cyl - Ri) * x, cy + (R_cyl - Ri) * y, Ri};
+
+        // vertical drop: highest contact with particles in the column below
+        size_t ci = deposition_index(p.x, grid.origin.x, grid.inv_h, n.i);
+        size_t cj = deposition_index(p.y, grid.origin.y, grid.inv_h, n.j);
+        for (size_t k = 0; k < n.k; ++k)
+            for (size_t j = (cj > 0 ? cj - 1 : 0); j <= cj + 1 && j < n.j; ++j)
+                for (size_t i = (ci > 0 ? ci - 1 : 0); i <= ci + 1 && i < n.i; ++i)
+                    for (size_t m = grid.cells.head[i + n.i * (j + n.j * k)]; m != SIZE_MAX; m = grid.cells.list[m])
+                    {
+                        double dx = p.x - r[m].x;
+                        double dy = p.y - r[m].y;
+                        double sumR = Ri + R[m];
+                        double d_sq = dx * dx + dy * dy;
+                        if (d_sq < sumR * sumR)
+                        {
+                            double z = r[m].z + sqrt(sumR * sumR - d_sq);
+                            p.z = (z > p.z ? z : p.z);
+                        }
+                    }
+
+        // roll: move along the steepest descent direction allowed by the current contacts and push the
+        // particle back onto the surface. A step that does not lower the particle is undone and halved.
+        struct Vec3D normals[16];
+        double step = 0.25 * Ri;
+        double gap_tol = 1e-4 * Ri;
+        int moved;
+        size_t num_corrections = 0;
+        for (size_t iter = 0; iter < 1000; ++iter)
+        {
+            size_t num_contacts = deposition_contacts(p_parameters, p_vectors, &grid, &p, Ri, num_corrections > 8,
+                                                      gap_tol, normals, 16, &moved);
+            if (moved) // overlaps were removed, determine the contacts again
+            {
+                num_corrections++;
+                continue;
+            }
+            num_corrections = 0;
+            struct Vec3D d;
+            double d_len = deposition_descent(normals, num_contacts, &d);
+            if (d_len < 1e-6 || step < 1e-3 * Ri)
+                break;
+            struct Vec3D p_old = p;
+            p.x += step * d.x / d_len;
+            p.y += step * d.y / d_len;
+            p.z += step * d.z / d_len;
+            moved = 1;
+            for (int sweep = 0; sweep < 4 && moved; ++sweep)
+                deposition_contacts(p_parameters, p_vectors, &grid, &p, Ri, 0, 0.0, normals, 0, &moved);
+            if (p.z > p_old.z - 0.01 * step) // the particle must go down; otherwise retry with a smaller step
+            {
+                p = p_old;
+                step *= 0.5;
+            }
+        }
+        // remove overlaps left by particles that got stuck between their contacts
+        moved = 1;
+        for (int sweep = 0; sweep < 50 && moved; ++sweep)
+            deposition_contacts(p_parameters, p_vectors, &grid, &p, Ri, 1, 0.0, normals, 0, &moved);
+        if (p.z > H - Ri)
+            num_above++;
+
+        r[ipart] = p;
+        size_t icell = deposition_index(p.x, grid.origin.x, grid.inv_h, n.i) +
+                       n.i * (deposition_index(p.y, grid.origin.y, grid.inv_h, n.j) +
+                              n.j * deposition_index(p.z, grid.origin.z, grid.inv_h, n.k));
+        grid.cells.list[ipart] = grid.cells.head[icell];
+        grid.cells.head[icell] = ipart;
+    }
+    if (num_above > 0)
+        fprintf(stderr, "Warning! %lu particles deposited above the top wall\n", (long unsigned)num_above);
+
+    free(grid.cells.head);
+    free(grid.cells.list);
+}
 
 void initialise_velocities(struct Parameters *p_parameters, struct Vectors *p_vectors)
 {
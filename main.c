@@ -65,18 +65,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
 #include "constants.h"
 #include "structs.h"
 #include "setparameters.h"
-#include "initialise.h"
-#include "nbrlist.h"
-#include "forces.h"
-#include "dynamics.h"
-#include "memory.h"
-#include "fileoutput.h"
-#include "walls.h"
-#include <stdbool.h>
+#include "pbs.h"
 
 /**
  * @brief main The main of the DEM code. After initialization, 
@@ -86,106 +78,17 @@
  */
 int main(void)
 {
-    struct Vectors vectors;
     struct Parameters parameters;
-    struct Nbrlist nbrlist;
-    struct Colllist colllist;
-    size_t step = 0;
-    double Ekin, Epot;
-
     set_parameters(&parameters);
-    alloc_memory(&parameters, &vectors, &nbrlist, &colllist);
-    if(parameters.load_restart == 1)
-    {
-        load_restart(&parameters, &vectors);
-    }
-    else
-        initialise(&parameters, &vectors);
-
-    build_nbrlist(&parameters, &vectors, &nbrlist);
-    update_colllist(&parameters, &vectors, &nbrlist, &colllist);
-    Epot = calculate_forces(&parameters, &colllist, &vectors);
-    record_trajectories_xyz(1, &parameters, &vectors);
-
-    /* initialize profile accumulators (sample frequency uses parameters.num_dt_traj below) */
-    profile_accumulators_init(&parameters);
-
-    /* --- automatic settling detector / collapse handling --- */
-    bool cyl_removed = false;
-    int settle_counter = 0;
-    bool use_manual_removal = (parameters.collapse_start_step >= 0);
-    int cyl_index = parameters.cyl_wall_index;
-    /* ----------------------------------------------------- */
-
-    while (step < parameters.num_dt_steps) //start of the velocity-Verlet loop
-    {
-
-        step++;
-        vectors.time += parameters.dt;
-
-        Ekin = update_velocities_half_dt(&parameters, &nbrlist, &vectors);
-        update_positions(&parameters, &nbrlist, &vectors);
-
-        update_tangential_displacements(&parameters, &vectors, &colllist);
-        boundary_conditions(&parameters, &vectors);
-        update_nbrlist(&parameters, &vectors, &nbrlist);
-        update_colllist(&parameters, &vectors, &nbrlist, &colllist);
-        Epot = calculate_forces(&parameters, &colllist, &vectors);
-        Ekin = update_velocities_half_dt(&parameters, &nbrlist, &vectors);
-
-        /* --- detect settling and remove cylindrical wall when settled --- */
-        if (!cyl_removed) {
-            if (use_manual_removal) {
-                if ((int)step == parameters.collapse_start_step) {
-                    if (cyl_index >= 0 && cyl_index < parameters.num_walls) {
-                        if (parameters.num_walls > cyl_index) parameters.num_walls = cyl_index;
-                        update_colllist(&parameters, &vectors, &nbrlist, &colllist);
-                        cyl_removed = true;
-                        printf("Cylindrical wall manually removed at step %lu\n", (long unsigned)step);
-                    }
-                }
-            } else {
-                double Ekin_per_particle = Ekin / (double) parameters.num_part;
-                if (Ekin_per_particle < parameters.Ekin_tol) {
-                    settle_counter++;
-                } else {
-                    settle_counter = 0;
-                }
-                if (settle_counter >= parameters.settle_pers_steps) {
-                    if (cyl_index >= 0 && cyl_index < parameters.num_walls) {
-                        if (parameters.num_walls > cyl_index) parameters.num_walls = cyl_index;
-                        update_colllist(&parameters, &vectors, &nbrlist, &colllist);
-                        cyl_removed = true;
-                        printf("Cylindrical wall removed automatically at step %lu (Ekin/part=%g)\n", (long unsigned)step, Ekin_per_particle);
-                    }
-                }
-            }
-        }
-        /* --------------------------------------------------------------- */
-
-       if (step%parameters.num_dt_printf ==0) printf("Step %lu, Time %g, Z %g, Epot %g, Ekin %g, Etot %g\n", (long unsigned) step, vectors.time,
-               2.0*((double) colllist.num_nbrs)/((double) parameters.num_part),
-               Epot, Ekin, Epot+Ekin); //Z is the coordination number
-
-        if (step%parameters.num_dt_traj ==0) {
-            record_trajectories_xyz(0,&parameters,&vectors);
-            /* also sample profiles at the same frequency (averaging) */
-            profile_accumulators_add_sample(&parameters, &vectors);
-        }
-        
-        if (step%parameters.num_dt_restart == 0) save_restart(&parameters,&vectors); 
-    }
-
-    // write averaged profiles computed over all samples
-    profile_accumulators_write_average(&parameters);
-
-    // characterize final pile after collapse
-    characterize_final_pile(&parameters, &vectors);
 
-    compute_profiles(&parameters, &vectors);
-    compute_profiles_center_based(&parameters, &vectors);
-    save_restart(&parameters,&vectors);
-    free_memory(&vectors, &nbrlist, &colllist);
+    /* initialization, stepping and final output are done by the library, see pbs.h */
+    struct Simulation *p_sim = pbs_create(&parameters);
+    if (p_sim == NULL)
+        exit(1);
+    if (pbs_step_count(p_sim) < parameters.num_dt_steps)
+        pbs_step(p_sim, parameters.num_dt_steps - pbs_step_count(p_sim));
+    pbs_finish(p_sim);
+    pbs_destroy(p_sim);
 
     return 0;
 }
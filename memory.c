@@ -15,10 +15,8 @@ void alloc_vectors(struct Vectors *p_vectors, size_t num_part)
     p_vectors->omega = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
     p_vectors->f = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
     p_vectors->T = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
-
-    // initialise histogram arrays
-    p_vectors->hist_vol_r = calloc(p_vectors->hist_num_bins_r, sizeof(double));
-    p_vectors->hist_vol_z = calloc(p_vectors->hist_num_bins_z, sizeof(double));
+    p_vectors->stress = NULL; // allocated if an analysis samples the contact stress
+    p_vectors->image = (struct Image3D *)calloc(num_part, sizeof(struct Image3D));
 }
 
 void free_vectors(struct Vectors *p_vectors)
@@ -42,10 +40,10 @@ void free_vectors(struct Vectors *p_vectors)
     p_vectors->f = NULL;
     free(p_vectors->T);
     p_vectors->T = NULL;
-    free(p_vectors->hist_vol_r);
-    p_vectors->hist_vol_r = NULL;  
-    free(p_vectors->hist_vol_z);
-    p_vectors->hist_vol_z = NULL;
+    free(p_vectors->stress);
+    p_vectors->stress = NULL;
+    free(p_vectors->image);
+    p_vectors->image = NULL;
 }
 
 void alloc_memory(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist, struct Colllist *p_colllist)
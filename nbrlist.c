@@ -109,6 +109,8 @@ void alloc_nbrlist(struct Parameters *p_parameters, struct Nbrlist *p_nbrlist)
     p_nbrlist->dr = (struct DeltaR *)malloc(p_parameters->num_part * sizeof(struct DeltaR));
     p_nbrlist->nbr_cnt = (size_t *)malloc((num_part) * sizeof(size_t));
     //    p_nbrlist->nbr_cnt_tmp = (size_t *)malloc(num_part * sizeof(size_t));
+    p_nbrlist->num_builds = 0;
+    p_nbrlist->num_allocs = 0;
 }
 
 void free_nbrlist(struct Nbrlist *p_nbrlist)
@@ -147,6 +149,7 @@ void build_nbrlist(struct Parameters *p_parameters, struct Vectors *p_vectors, s
 
     // First build a cell-linked-list
     build_celllist(p_parameters, p_vectors, p_nbrlist->p_celllist);
+    p_nbrlist->num_builds++;
 
     /*  Use the cell-linked-list to build a neighbor list.
         PairNBs are included to the neighbor list of their distance is less than r_cut+r_shell. */
@@ -178,6 +181,7 @@ void build_nbrlist(struct Parameters *p_parameters, struct Vectors *p_vectors, s
                     nbr = (struct Pair *)realloc(nbr, num_nbrs_max * sizeof(struct Pair));
                     p_nbrlist->nbr = nbr;
                     p_nbrlist->num_nbrs_max = num_nbrs_max;
+                    p_nbrlist->num_allocs++;
                 }
                 if (j > i) //is expected to true unless new particles have been inserted
                 {
@@ -257,6 +261,7 @@ void build_nbrlist(struct Parameters *p_parameters, struct Vectors *p_vectors, s
                         nbr = (struct Pair *)realloc(nbr, num_nbrs_max * sizeof(struct Pair));
                         p_nbrlist->nbr = nbr;
                         p_nbrlist->num_nbrs_max = num_nbrs_max;
+                        p_nbrlist->num_allocs++;
                     }
                     if (j > i)
                     {
@@ -304,6 +309,7 @@ void build_nbrlist(struct Parameters *p_parameters, struct Vectors *p_vectors, s
         qsort(nbr + k, nbr_cnt[i] - k, sizeof(struct Pair), cmp_sort_nbr);
     p_nbrlist->num_nbrs = num_nbrs;
     p_nbrlist->dr = (struct DeltaR *)realloc(p_nbrlist->dr, num_part * sizeof(struct DeltaR));
+    p_nbrlist->num_allocs += 2; // nbr_tmp and dr
     for (size_t i = 0; i < num_part; ++i) /*initialize particle displacements (with respect to creation time) to zero */
         p_nbrlist->dr[i] = dr;
 }
@@ -354,10 +360,14 @@ int update_nbrlist(struct Parameters *p_parameters, struct Vectors *p_vectors, s
 void alloc_colllist(struct Parameters *p_parameters, struct Colllist *p_colllist)
 {
     p_colllist->num_nbrs = 0;
+    p_colllist->num_allocs = 0;
     p_colllist->nbr = (struct Pair *)malloc(0);
     p_colllist->nbr_tmp = (struct Pair *)malloc(0);
     p_colllist->tij = (struct DeltaR *)malloc(0);
     p_colllist->tij_tmp = (struct DeltaR *)malloc(0);
+    p_colllist->fn_sq = (double *)malloc(0);
+    p_colllist->ft_sq = (double *)malloc(0);
+    p_colllist->fij = (struct Vec3D *)malloc(0);
     p_colllist->num_w = 0;
     size_t num_w_max = 0;
     p_colllist->num_w_max = num_w_max;
@@ -414,6 +424,9 @@ void update_colllist(struct Parameters *p_parameters, struct Vectors *p_vectors,
     p_colllist->tij = tij;
     for (m = 0; m < num_nbrs; ++m)
         tij[m] = t0;
+    p_colllist->fn_sq = (double *)realloc(p_colllist->fn_sq, num_nbrs * sizeof(double));
+    p_colllist->ft_sq = (double *)realloc(p_colllist->ft_sq, num_nbrs * sizeof(double));
+    p_colllist->fij = (struct Vec3D *)realloc(p_colllist->fij, num_nbrs * sizeof(struct Vec3D));
 
     size_t k;
     for (m = 0, k = 0; m < num_nbrs && k < num_nbrs_old;)
@@ -450,12 +463,15 @@ void update_colllist(struct Parameters *p_parameters, struct Vectors *p_vectors,
     vw = (struct Vec3D *)realloc(vw, num_part * sizeof(struct Vec3D)); */
     struct Vec3D *r = p_vectors->r;
     unsigned int num_walls = p_parameters->num_walls;
+    unsigned int wall_mask = p_parameters->wall_mask;
     size_t num_w_max = p_colllist->num_w_max;
     k = 0;
     for (size_t i = 0; i < num_part; i++)
     {
         for (unsigned int j = 0; j < num_walls; ++j)
         {
+            if (!(wall_mask & WALL_BIT(j))) // wall switched off in the active phase
+                continue;
             struct DeltaR riw_loc;
             struct Vec3D vw_loc;
             if (p_parameters->wall_function[j](p_parameters, R[i], &r[i], &riw_loc, &vw_loc))
@@ -467,6 +483,7 @@ void update_colllist(struct Parameters *p_parameters, struct Vectors *p_vectors,
                     wall_id = (unsigned int *)realloc(wall_id, num_w_max * sizeof(unsigned int));
                     riw = (struct DeltaR *)realloc(riw, num_w_max * sizeof(struct DeltaR));
                     vw = (struct Vec3D *)realloc(vw, num_w_max * sizeof(struct Vec3D));
+                    p_colllist->num_allocs += 4;
                 }
                 indcs_w[k] = i;
                 wall_id[k] = j;
@@ -518,6 +535,27 @@ void update_colllist(struct Parameters *p_parameters, struct Vectors *p_vectors,
     p_colllist->indcs_w_tmp = (size_t *)realloc(indcs_w_old, num_w_max * sizeof(size_t));
     p_colllist->wall_id_tmp = (unsigned int *)realloc(wall_id_old, num_w_max * sizeof(unsigned int));
     p_colllist->tiw_tmp = (struct DeltaR *)realloc(tiw_old, num_w_max * sizeof(struct DeltaR));
+    p_colllist->num_allocs += 10; // the reallocations of every update: 6 of the pair lists, 4 of the wall lists
+}
+
+void remove_inactive_wall_contacts(struct Parameters *p_parameters, struct Colllist *p_colllist)
+/* Drop the wall contacts with walls that are no longer in the wall mask.
+   Particle-particle contacts and the remaining wall contacts keep their tangential displacements. */
+{
+    unsigned int wall_mask = p_parameters->wall_mask;
+    size_t m = 0;
+    for (size_t k = 0; k < p_colllist->num_w; ++k)
+    {
+        if (!(wall_mask & WALL_BIT(p_colllist->wall_id[k])))
+            continue;
+        p_colllist->indcs_w[m] = p_colllist->indcs_w[k];
+        p_colllist->wall_id[m] = p_colllist->wall_id[k];
+        p_colllist->riw[m] = p_colllist->riw[k];
+        p_colllist->tiw[m] = p_colllist->tiw[k];
+        p_colllist->vw[m] = p_colllist->vw[k];
+        ++m;
+    }
+    p_colllist->num_w = m;
 }
 
 void free_colllist(struct Colllist *p_colllist)
@@ -526,6 +564,9 @@ void free_colllist(struct Colllist *p_colllist)
     free(p_colllist->nbr_tmp);
     free(p_colllist->tij);
     free(p_colllist->tij_tmp);
+    free(p_colllist->fn_sq);
+    free(p_colllist->ft_sq);
+    free(p_colllist->fij);
     free(p_colllist->indcs_w);
     free(p_colllist->indcs_w_tmp);
     free(p_colllist->wall_id);
@@ -534,4 +575,4 @@ void free_colllist(struct Colllist *p_colllist)
     free(p_colllist->tiw);
     free(p_colllist->tiw_tmp);
     free(p_colllist->vw);
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -84,6 +84,15 @@ void alloc_colllist(struct Parameters *p_parameters, struct Colllist *p_colllist
  */
 void update_colllist(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,  struct Colllist* p_colllist);
 
+/**
+ * @brief Remove the wall contacts of walls that are switched off in p_parameters->wall_mask.
+ * The neighbor list and particle-particle contacts are left untouched.
+ * 
+ * @param p_parameters used members: wall_mask
+ * @param p_colllist 
+ */
+void remove_inactive_wall_contacts(struct Parameters *p_parameters, struct Colllist *p_colllist);
+
 /**
  * @brief Free the memory allocated for the collision list
  * 
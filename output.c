@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "constants.h"
+#include "structs.h"
+#include "fileoutput.h"
+#include "trajectory.h"
+#include "vtk.h"
+#include "output.h"
+#include "archive.h"
+#include "analysis.h"
+
+// Produce the output requested for one snapshot
+static void output_process(struct OutputPipeline *p_output, struct Snapshot *p_snap)
+{
+    struct Parameters *p_parameters = p_output->p_parameters;
+    if (p_snap->tasks & OUTPUT_TASK_STATUS)
+        printf("Step %lu, Time %g, Z %g, Epot %g, Ekin %g, Etot %g\n", (long unsigned)p_snap->step, p_snap->time,
+               2.0 * ((double)p_snap->num_contacts) / ((double)p_snap->num_part),
+               p_snap->Epot, p_snap->Ekin, p_snap->Epot + p_snap->Ekin); //Z is the coordination number
+
+    // the writers take struct Vectors; only the arrays of the snapshot are filled in
+    struct Vectors vectors;
+    memset(&vectors, 0, sizeof(vectors));
+    vectors.time = p_snap->time;
+    vectors.radius = p_snap->radius;
+    vectors.r = p_snap->r;
+    vectors.v = p_snap->v;
+    vectors.omega = p_snap->omega;
+    vectors.f = p_snap->f;
+    if (p_snap->tasks & OUTPUT_TASK_FRAME)
+    {
+        if (p_parameters->traj_format == TRAJ_FORMAT_XYZ)
+        {
+            record_trajectories_xyz(p_output->traj.num_frames == 0, p_parameters, &vectors);
+            p_output->traj.num_frames++;
+        }
+        else if (p_parameters->traj_format == TRAJ_FORMAT_VTU)
+            vtk_write_frame(p_parameters, &p_output->vtk, p_snap);
+        else
+            trajectory_write_frame(p_parameters, &p_output->traj, &vectors, p_snap->step);
+    }
+    if (p_snap->tasks & OUTPUT_TASK_ANALYSIS)
+        analysis_sample(p_output->p_analyses, p_parameters, p_snap);
+    if (p_snap->tasks & OUTPUT_TASK_ARCHIVE)
+    {
+        char filename[1100];
+        snprintf(filename, sizeof(filename), "%s_%09lu.pba", p_parameters->filename_archive, (long unsigned)p_snap->step);
+        archive_write(filename, p_parameters, &vectors, p_snap->step);
+    }
+}
+
+// Sleep on the condition variable until *p_flag is cleared by the other thread or ready() holds
+static void output_wait(struct OutputPipeline *p_output, atomic_bool *p_flag, bool (*ready)(struct OutputPipeline *))
+{
+    pthread_mutex_lock(&p_output->mutex);
+    atomic_store(p_flag, true);
+    while (!ready(p_output)) // the other thread checks the flag after publishing, so no wake-up is lost
+        pthread_cond_wait(&p_output->cond, &p_output->mutex);
+    atomic_store(p_flag, false);
+    pthread_mutex_unlock(&p_output->mutex);
+}
+
+// Wake up the other thread if it sleeps on *p_flag
+static void output_wake(struct OutputPipeline *p_output, atomic_bool *p_flag)
+{
+    if (atomic_load(p_flag))
+    {
+        pthread_mutex_lock(&p_output->mutex);
+        pthread_cond_broadcast(&p_output->cond);
+        pthread_mutex_unlock(&p_output->mutex);
+    }
+}
+
+static bool output_has_snapshot(struct OutputPipeline *p_output)
+{
+    return atomic_load(&p_output->head) != atomic_load(&p_output->tail) || atomic_load(&p_output->stop);
+}
+
+static bool output_is_drained(struct OutputPipeline *p_output)
+{
+    return atomic_load(&p_output->head) == atomic_load(&p_output->tail);
+}
+
+static bool output_has_free_slot(struct OutputPipeline *p_output)
+{
+    return atomic_load(&p_output->head) - atomic_load(&p_output->tail) < p_output->num_slots;
+}
+
+static void *output_writer(void *arg)
+{
+    struct OutputPipeline *p_output = (struct OutputPipeline *)arg;
+    while (true)
+    {
+        size_t tail = atomic_load(&p_output->tail);
+        if (tail == atomic_load(&p_output->head))
+        {
+            if (atomic_load(&p_output->stop) && tail == atomic_load(&p_output->head))
+                break;
+            output_wait(p_output, &p_output->writer_waiting, output_has_snapshot);
+            continue;
+        }
+        output_process(p_output, &p_output->slots[tail % p_output->num_slots]);
+        atomic_store(&p_output->tail, tail + 1); // releases the buffer
+        output_wake(p_output, &p_output->producer_waiting);
+    }
+    fflush(stdout);
+    return NULL;
+}
+
+// Free the snapshot buffers of the ring
+static void output_free_slots(struct OutputPipeline *p_output)
+{
+    for (size_t k = 0; k < p_output->num_slots; ++k)
+    {
+        free(p_output->slots[k].radius);
+        free(p_output->slots[k].r);
+        free(p_output->slots[k].v);
+        free(p_output->slots[k].omega);
+        free(p_output->slots[k].f);
+        free(p_output->slots[k].stress);
+        free(p_output->slots[k].image);
+        free(p_output->slots[k].type);
+        free(p_output->slots[k].contacts);
+        free(p_output->slots[k].fn_sq);
+        free(p_output->slots[k].ft_sq);
+        free(p_output->slots[k].fij);
+        free(p_output->slots[k].nbrs);
+    }
+    free(p_output->slots);
+    p_output->slots = NULL;
+    p_output->num_slots = 0;
+}
+
+bool output_init(struct Parameters *p_parameters, struct AnalysisSet *p_analyses, struct OutputPipeline *p_output)
+{
+    memset(p_output, 0, sizeof(*p_output));
+    p_output->p_parameters = p_parameters;
+    p_output->p_analyses = p_analyses;
+    p_output->async = p_parameters->output_async;
+    p_output->backpressure = p_parameters->output_backpressure;
+    atomic_init(&p_output->head, 0);
+    atomic_init(&p_output->tail, 0);
+    atomic_init(&p_output->writer_waiting, false);
+    atomic_init(&p_output->producer_waiting, false);
+    atomic_init(&p_output->stop, false);
+    if (!trajectory_open(p_parameters, &p_output->traj))
+        return false;
+    vtk_open(p_parameters, &p_output->vtk);
+    if (!p_output->async)
+        return true;
+
+    size_t num_part = p_parameters->num_part;
+    p_output->num_slots = (p_parameters->output_num_slots > 0 ? p_parameters->output_num_slots : 1);
+    p_output->slots = (struct Snapshot *)calloc(p_output->num_slots, sizeof(struct Snapshot));
+    for (size_t k = 0; k < p_output->num_slots; ++k)
+    {
+        struct Snapshot *p_snap = &p_output->slots[k];
+        p_snap->num_part = num_part;
+        p_snap->radius = (double *)malloc(num_part * sizeof(double));
+        p_snap->r = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
+        p_snap->v = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
+        unsigned int fields = p_parameters->traj_fields | (p_parameters->num_dt_archive > 0 ? p_parameters->archive_fields : 0u) |
+                              p_analyses->fields;
+        if (p_parameters->traj_format == TRAJ_FORMAT_VTU)
+            fields = TRAJ_FIELD_ALL;
+        p_snap->type = (int *)malloc(num_part * sizeof(int));
+        if (fields & TRAJ_FIELD_OMEGA)
+            p_snap->omega = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
+        if (fields & TRAJ_FIELD_FORCE)
+            p_snap->f = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
+        if (p_analyses->fields & SNAPSHOT_FIELD_STRESS)
+            p_snap->stress = (struct SymTensor *)malloc(num_part * sizeof(struct SymTensor));
+        if (p_analyses->fields & SNAPSHOT_FIELD_IMAGE)
+            p_snap->image = (struct Image3D *)malloc(num_part * sizeof(struct Image3D));
+    }
+    pthread_mutex_init(&p_output->mutex, NULL);
+    pthread_cond_init(&p_output->cond, NULL);
+    if (pthread_create(&p_output->thread, NULL, output_writer, p_output) != 0)
+    {
+        // fall back to synchronous output
+        fprintf(stderr, "Warning: cannot start the output thread, output is written synchronously\n");
+        pthread_mutex_destroy(&p_output->mutex);
+        pthread_cond_destroy(&p_output->cond);
+        output_free_slots(p_output);
+        p_output->async = false;
+    }
+    return true;
+}
+
+void output_publish(struct OutputPipeline *p_output, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist, struct Colllist *p_colllist,
+                    size_t step, size_t phase, double Ekin, double Epot, unsigned int tasks)
+{
+    struct Parameters *p_parameters = p_output->p_parameters;
+    size_t num_part = p_parameters->num_part;
+    size_t num_contacts = p_colllist->num_nbrs;
+    // the contact network is only needed for VTU frames and analyses that ask for it
+    bool contacts = ((tasks & OUTPUT_TASK_FRAME) && p_parameters->traj_format == TRAJ_FORMAT_VTU && p_parameters->vtk_contacts) ||
+                    ((tasks & OUTPUT_TASK_ANALYSIS) && p_output->p_analyses->contacts);
+    // the analyses are fixed now: one registered later must not sample a snapshot without the fields it needs
+    unsigned int analyses = (tasks & OUTPUT_TASK_ANALYSIS) ? analysis_mask_due(p_output->p_analyses, step) : 0u;
+    unsigned int fields_analysis = (tasks & OUTPUT_TASK_ANALYSIS) ? analysis_fields_due(p_output->p_analyses, step) : 0u;
+    bool nbrs = (fields_analysis & SNAPSHOT_FIELD_NBRS) != 0u;
+    size_t num_nbrs = nbrs ? p_nbrlist->num_nbrs : 0;
+    if (!p_output->async)
+    {
+        // synchronous output works directly on the particle arrays
+        struct Snapshot snap = {.step = step, .phase = phase, .time = p_vectors->time, .Ekin = Ekin, .Epot = Epot,
+                                .num_contacts = num_contacts, .tasks = tasks, .analyses = analyses, .num_part = num_part, .radius = p_vectors->radius,
+                                .r = p_vectors->r, .v = p_vectors->v, .omega = p_vectors->omega, .f = p_vectors->f,
+                                .stress = p_vectors->stress, .image = p_vectors->image, .type = p_vectors->type,
+                                .contacts = contacts ? p_colllist->nbr : NULL, .fn_sq = p_colllist->fn_sq,
+                                .ft_sq = p_colllist->ft_sq, .fij = p_colllist->fij, .num_contacts_max = num_contacts,
+                                .nbrs = nbrs ? p_nbrlist->nbr : NULL, .num_nbrs = num_nbrs, .num_nbrs_max = num_nbrs};
+        output_process(p_output, &snap);
+        return;
+    }
+
+    if (!output_has_free_slot(p_output))
+    {
+        // trajectory frames, archives and status lines may be dropped, analysis samples are always delivered
+        if (p_output->backpressure == OUTPUT_BACKPRESSURE_DROP && !(tasks & OUTPUT_TASK_ANALYSIS))
+        {
+            p_output->num_dropped_frames += (tasks & OUTPUT_TASK_FRAME) != 0;
+            p_output->num_dropped_archives += (tasks & OUTPUT_TASK_ARCHIVE) != 0;
+            p_output->num_dropped_status += (tasks & OUTPUT_TASK_STATUS) != 0;
+            return;
+        }
+        output_wait(p_output, &p_output->producer_waiting, output_has_free_slot);
+    }
+    size_t head = atomic_load(&p_output->head);
+    struct Snapshot *p_snap = &p_output->slots[head % p_output->num_slots];
+    p_snap->step = step;
+    p_snap->phase = phase;
+    p_snap->time = p_vectors->time;
+    p_snap->Ekin = Ekin;
+    p_snap->Epot = Epot;
+    p_snap->num_contacts = num_contacts;
+    p_snap->tasks = tasks;
+    p_snap->analyses = analyses;
+    if ((fields_analysis & TRAJ_FIELD_OMEGA) && p_snap->omega == NULL) // analysis registered after output_init
+        p_snap->omega = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
+    if ((fields_analysis & TRAJ_FIELD_FORCE) && p_snap->f == NULL)
+        p_snap->f = (struct Vec3D *)malloc(num_part * sizeof(struct Vec3D));
+    if ((fields_analysis & SNAPSHOT_FIELD_STRESS) && p_snap->stress == NULL)
+        p_snap->stress = (struct SymTensor *)malloc(num_part * sizeof(struct SymTensor));
+    if ((fields_analysis & SNAPSHOT_FIELD_IMAGE) && p_snap->image == NULL)
+        p_snap->image = (struct Image3D *)malloc(num_part * sizeof(struct Image3D));
+    memcpy(p_snap->radius, p_vectors->radius, num_part * sizeof(double));
+    memcpy(p_snap->r, p_vectors->r, num_part * sizeof(struct Vec3D));
+    memcpy(p_snap->v, p_vectors->v, num_part * sizeof(struct Vec3D));
+    if (p_snap->omega != NULL)
+        memcpy(p_snap->omega, p_vectors->omega, num_part * sizeof(struct Vec3D));
+    if (p_snap->f != NULL)
+        memcpy(p_snap->f, p_vectors->f, num_part * sizeof(struct Vec3D));
+    if ((fields_analysis & SNAPSHOT_FIELD_STRESS) && p_vectors->stress != NULL)
+        memcpy(p_snap->stress, p_vectors->stress, num_part * sizeof(struct SymTensor));
+    if (fields_analysis & SNAPSHOT_FIELD_IMAGE)
+        memcpy(p_snap->image, p_vectors->image, num_part * sizeof(struct Image3D));
+    memcpy(p_snap->type, p_vectors->type, num_part * sizeof(int));
+    if (contacts)
+    {
+        if (num_contacts > p_snap->num_contacts_max)
+        {
+            p_snap->num_contacts_max = num_contacts + num_contacts / 4;
+            p_snap->contacts = (struct Pair *)realloc(p_snap->contacts, p_snap->num_contacts_max * sizeof(struct Pair));
+            p_snap->fn_sq = (double *)realloc(p_snap->fn_sq, p_snap->num_contacts_max * sizeof(double));
+            p_snap->ft_sq = (double *)realloc(p_snap->ft_sq, p_snap->num_contacts_max * sizeof(double));
+            p_snap->fij = (struct Vec3D *)realloc(p_snap->fij, p_snap->num_contacts_max * sizeof(struct Vec3D));
+        }
+        memcpy(p_snap->contacts, p_colllist->nbr, num_contacts * sizeof(struct Pair));
+        memcpy(p_snap->fn_sq, p_colllist->fn_sq, num_contacts * sizeof(double));
+        memcpy(p_snap->ft_sq, p_colllist->ft_sq, num_contacts * sizeof(double));
+        memcpy(p_snap->fij, p_colllist->fij, num_contacts * sizeof(struct Vec3D));
+    }
+    p_snap->num_nbrs = num_nbrs;
+    if (nbrs)
+    {
+        if (num_nbrs > p_snap->num_nbrs_max)
+        {
+            p_snap->num_nbrs_max = num_nbrs + num_nbrs / 4;
+            p_snap->nbrs = (struct Pair *)realloc(p_snap->nbrs, p_snap->num_nbrs_max * sizeof(struct Pair));
+        }
+        memcpy(p_snap->nbrs, p_nbrlist->nbr, num_nbrs * sizeof(struct Pair));
+    }
+    atomic_store(&p_output->head, head + 1); // publishes the snapshot
+    output_wake(p_output, &p_output->writer_waiting);
+}
+
+void output_drain(struct OutputPipeline *p_output)
+{
+    if (p_output->async && !output_is_drained(p_output))
+        output_wait(p_output, &p_output->producer_waiting, output_is_drained);
+}
+
+void output_finish(struct OutputPipeline *p_output)
+{
+    if (p_output->async)
+    {
+        atomic_store(&p_output->stop, true);
+        pthread_mutex_lock(&p_output->mutex);
+        pthread_cond_broadcast(&p_output->cond);
+        pthread_mutex_unlock(&p_output->mutex);
+        pthread_join(p_output->thread, NULL);
+        pthread_mutex_destroy(&p_output->mutex);
+        pthread_cond_destroy(&p_output->cond);
+        if (p_output->num_dropped_frames + p_output->num_dropped_archives + p_output->num_dropped_status > 0)
+            printf("Output pipeline dropped %lu trajectory frames, %lu archives and %lu status lines\n",
+                   (long unsigned)p_output->num_dropped_frames, (long unsigned)p_output->num_dropped_archives,
+                   (long unsigned)p_output->num_dropped_status);
+        output_free_slots(p_output);
+    }
+    trajectory_close(&p_output->traj);
+    vtk_close(&p_output->vtk);
+}
+
+void output_schedule_init(struct OutputSchedule *p_schedule, size_t step)
+{
+    p_schedule->step_last = step;
+    p_schedule->disp_max = 0.0;
+}
+
+bool output_frame_due(struct OutputSchedule *p_schedule, struct Parameters *p_parameters, struct Vectors *p_vectors, size_t step)
+{
+    struct Vec3D *v = p_vectors->v;
+    double v_sq_max = 0.0;
+    for (size_t i = 0; i < p_parameters->num_part; ++i)
+    {
+        double v_sq = v[i].x * v[i].x + v[i].y * v[i].y + v[i].z * v[i].z;
+        v_sq_max = (v_sq > v_sq_max ? v_sq : v_sq_max);
+    }
+    p_schedule->disp_max += sqrt(v_sq_max) * p_parameters->dt;
+
+    size_t num_dt = step - p_schedule->step_last;
+    bool due = num_dt >= p_parameters->traj_num_dt_max ||
+               (num_dt >= p_parameters->traj_num_dt_min && p_schedule->disp_max >= p_parameters->traj_disp);
+    if (due)
+        output_schedule_init(p_schedule, step);
+    return due;
+}
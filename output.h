@@ -0,0 +1,75 @@
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Open the trajectory (or VTU series), allocate the snapshot buffers and start the writer thread (if output_async).
+ * If the thread cannot be started, the output is written synchronously.
+ * 
+ * @param[in] p_parameters used members: output_async, output_num_slots, output_backpressure, traj_fields, num_dt_archive,
+ * archive_fields, num_part;
+ * the pointer is kept and read by the writer thread
+ * @param[in] p_analyses analyses sampled for snapshots with OUTPUT_TASK_ANALYSIS, the pointer is kept
+ * @param[out] p_output 
+ * @return bool false if the trajectory file cannot be opened; nothing is then left to finish
+ */
+bool output_init(struct Parameters *p_parameters, struct AnalysisSet *p_analyses, struct OutputPipeline *p_output);
+
+/**
+ * @brief Hand the state of the current time step to the output writer. The particle data is copied into
+ * a free snapshot buffer, so the time loop continues while the writer produces the output.
+ * 
+ * @param[in,out] p_output 
+ * @param[in] p_vectors used members: time, radius, r, v, omega, f, stress, image, type
+ * @param[in] p_nbrlist used members: num_nbrs and nbr for analyses with SNAPSHOT_FIELD_NBRS
+ * @param[in] p_colllist used members: num_nbrs, and nbr, fn_sq, ft_sq, fij for the contact network of VTU frames and analyses
+ * @param[in] step time step
+ * @param[in] phase index of the active phase
+ * @param[in] Ekin kinetic energy
+ * @param[in] Epot potential energy
+ * @param[in] tasks output to produce: OUTPUT_TASK_STATUS, OUTPUT_TASK_FRAME, OUTPUT_TASK_ANALYSIS and/or OUTPUT_TASK_ARCHIVE
+ */
+void output_publish(struct OutputPipeline *p_output, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist, struct Colllist *p_colllist,
+                    size_t step, size_t phase, double Ekin, double Epot, unsigned int tasks);
+
+/**
+ * @brief Wait until the writer has processed all published snapshots, e.g. before the set of analyses changes.
+ * The writer thread keeps running.
+ * 
+ * @param[in,out] p_output 
+ */
+void output_drain(struct OutputPipeline *p_output);
+
+/**
+ * @brief Wait until all published snapshots are written, stop the writer thread, close the trajectory and
+ * free the snapshot buffers
+ * 
+ * @param[in,out] p_output 
+ */
+void output_finish(struct OutputPipeline *p_output);
+
+/**
+ * @brief Start the adaptive trajectory cadence
+ * 
+ * @param[out] p_schedule 
+ * @param[in] step time step of the first frame
+ */
+void output_schedule_init(struct OutputSchedule *p_schedule, size_t step);
+
+/**
+ * @brief Decide whether a trajectory frame is due. The largest particle speed bounds how far any particle
+ * moved since the last frame; a frame is written once that bound exceeds traj_disp, but never within
+ * traj_num_dt_min steps of the previous frame and at least every traj_num_dt_max steps.
+ * Call once every time step.
+ * 
+ * @param[in,out] p_schedule 
+ * @param[in] p_parameters used members: num_part, dt, traj_num_dt_min, traj_num_dt_max, traj_disp
+ * @param[in] p_vectors used members: v
+ * @param[in] step current time step
+ * @return bool true if a frame should be written in this time step
+ */
+bool output_frame_due(struct OutputSchedule *p_schedule, struct Parameters *p_parameters, struct Vectors *p_vectors, size_t step);
+
+#endif /* OUTPUT_H_ */
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "constants.h"
+#include "structs.h"
+#include "checksum.h"
+#include "restart.h"
+#include "packingcache.h"
+
+#define PACKING_CACHE_VERSION 4u
+
+static void packing_cache_filename(struct Parameters *p_parameters, uint64_t key, char *filename, size_t size)
+{
+    snprintf(filename, size, "%spacking_%016llx.bin", p_parameters->packing_cache_dir, (unsigned long long)key);
+}
+
+uint64_t packing_cache_key(struct Parameters *p_parameters)
+{
+    struct Phase *p_settle = &p_parameters->phases[0];
+    uint64_t h = FNV1A_64_OFFSET;
+    h = fnv1a_64_uint(h, PACKING_CACHE_VERSION);
+    h = fnv1a_64_uint(h, p_parameters->num_part);
+    h = fnv1a_64_uint(h, SEED);
+    h = fnv1a_64_uint(h, p_parameters->init_positions);
+    h = fnv1a_64_double(h, p_parameters->R_min);
+    h = fnv1a_64_double(h, p_parameters->R_max);
+    h = fnv1a_64_double(h, p_parameters->density);
+    h = fnv1a_64_double(h, p_parameters->mass_ref);
+    h = fnv1a_64_double(h, p_parameters->k_n_pp);
+    h = fnv1a_64_double(h, p_parameters->eta_n_pp);
+    h = fnv1a_64_double(h, p_parameters->k_t_pp);
+    h = fnv1a_64_double(h, p_parameters->eta_t_pp);
+    h = fnv1a_64_double(h, p_parameters->fric_pp);
+    h = fnv1a_64_uint(h, p_parameters->num_walls);
+    for (unsigned int iw = 0; iw < p_parameters->num_walls; ++iw)
+    {
+        if (!(p_settle->wall_mask & WALL_BIT(iw)))
+            continue;
+        h = fnv1a_64_uint(h, iw);
+        h = fnv1a_64_double(h, p_parameters->k_n_pw[iw]);
+        h = fnv1a_64_double(h, p_parameters->eta_n_pw[iw]);
+        h = fnv1a_64_double(h, p_parameters->k_t_pw[iw]);
+        h = fnv1a_64_double(h, p_parameters->eta_t_pw[iw]);
+        h = fnv1a_64_double(h, p_parameters->fric_pw[iw]);
+    }
+    h = fnv1a_64_double(h, p_parameters->L.x);
+    h = fnv1a_64_double(h, p_parameters->L.y);
+    h = fnv1a_64_double(h, p_parameters->L.z);
+    h = fnv1a_64_double(h, p_parameters->R_cyl);
+    h = fnv1a_64_double(h, p_parameters->g.x);
+    h = fnv1a_64_double(h, p_parameters->g.y);
+    h = fnv1a_64_double(h, p_parameters->g.z);
+    h = fnv1a_64_double(h, p_parameters->dt);
+    h = fnv1a_64_double(h, p_parameters->r_cut);
+    h = fnv1a_64_double(h, p_parameters->Tg);
+    // settling phase: trigger and integration settings (name and output cadence do not matter)
+    h = fnv1a_64_uint(h, p_settle->trigger);
+    h = fnv1a_64_double(h, p_settle->trigger_value);
+    h = fnv1a_64_uint(h, p_settle->trigger_pers_steps);
+    h = fnv1a_64_double(h, p_settle->r_shell);
+    h = fnv1a_64_double(h, p_settle->damping);
+    h = fnv1a_64_uint(h, p_settle->integrator);
+    if (p_settle->integrator == INTEGRATOR_FIRE)
+    {
+        h = fnv1a_64_double(h, p_parameters->fire_Ekin_ratio);
+        h = fnv1a_64_double(h, p_parameters->fire_dt_max);
+        h = fnv1a_64_uint(h, p_parameters->fire_N_min);
+        h = fnv1a_64_double(h, p_parameters->fire_f_inc);
+        h = fnv1a_64_double(h, p_parameters->fire_f_dec);
+        h = fnv1a_64_double(h, p_parameters->fire_alpha_start);
+        h = fnv1a_64_double(h, p_parameters->fire_f_alpha);
+    }
+    return h;
+}
+
+bool packing_cache_load(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,
+                        struct Colllist *p_colllist, size_t *p_step, struct PhaseState *p_phase_state,
+                        struct FireState *p_fire, struct SteadyState *p_steady)
+{
+    uint64_t key = packing_cache_key(p_parameters);
+    char filename[1100];
+    packing_cache_filename(p_parameters, key, filename, sizeof(filename));
+    if (!restart_load_file(filename, key, p_parameters, p_vectors, p_nbrlist, p_colllist, p_step, p_phase_state,
+                           p_fire, p_steady, false))
+        return false;
+    printf("Loaded settled packing %s (step %lu, time %g)\n", filename, (long unsigned)*p_step, p_vectors->time);
+    printf("Note: the settling phase is skipped, so its trajectory frames and analysis samples are missing from the output\n");
+    return true;
+}
+
+void packing_cache_store(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,
+                         struct Colllist *p_colllist, size_t step, struct PhaseState *p_phase_state,
+                         struct FireState *p_fire, struct SteadyState *p_steady)
+{
+    uint64_t key = packing_cache_key(p_parameters);
+    char filename[1100];
+    packing_cache_filename(p_parameters, key, filename, sizeof(filename));
+    char *buffer = NULL;
+    size_t capacity = 0;
+    size_t size = restart_serialize(p_parameters, p_vectors, p_nbrlist, p_colllist, step, p_phase_state, p_fire,
+                                    p_steady, key, &buffer, &capacity);
+    restart_seal(buffer);
+    if (restart_write_file(filename, buffer, size))
+        printf("Stored settled packing %s\n", filename);
+    free(buffer);
+}
@@ -0,0 +1,46 @@
+#ifndef PACKINGCACHE_H_
+#define PACKINGCACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Hash of all parameters that determine the state at the end of the first (settling) phase:
+ * particle count, radii, density, contact coefficients of the particles and of the walls active while settling,
+ * box and cylinder geometry, gravity, time step, initial positions, seed and the settings of the first phase.
+ * 
+ * @param[in] p_parameters 
+ * @return uint64_t key of the packing in the cache
+ */
+uint64_t packing_cache_key(struct Parameters *p_parameters);
+
+/**
+ * @brief Load the state at the end of the settling phase with key @ref packing_cache_key from the cache directory,
+ * if it exists. The state is a restart image (see @ref restart_serialize), so the run continues exactly as
+ * the run that stored it. Output of the settling phase (trajectory frames, analysis samples and the averages over
+ * them) is not reproduced, so those files differ from the run that stored the packing.
+ * 
+ * @param[in,out] p_parameters used members: packing_cache_dir, see @ref restart_load_file for the set members
+ * @param[out] p_vectors 
+ * @param[out] p_nbrlist 
+ * @param[out] p_colllist 
+ * @param[out] p_step time step at which the settling phase ended
+ * @param[out] p_phase_state 
+ * @param[out] p_fire 
+ * @param[in,out] p_steady 
+ * @return bool true if the packing was found and loaded
+ */
+bool packing_cache_load(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,
+                        struct Colllist *p_colllist, size_t *p_step, struct PhaseState *p_phase_state,
+                        struct FireState *p_fire, struct SteadyState *p_steady);
+
+/**
+ * @brief Store the state at the end of the settling phase in the cache directory under key @ref packing_cache_key.
+ * 
+ * @see restart_serialize
+ */
+void packing_cache_store(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,
+                         struct Colllist *p_colllist, size_t step, struct PhaseState *p_phase_state,
+                         struct FireState *p_fire, struct SteadyState *p_steady);
+
+#endif /* PACKINGCACHE_H_ */
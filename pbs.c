@@ -0,0 +1,443 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "constants.h"
+#include "structs.h"
+#include "setparameters.h"
+#include "initialise.h"
+#include "nbrlist.h"
+#include "forces.h"
+#include "dynamics.h"
+#include "memory.h"
+#include "fileoutput.h"
+#include "walls.h"
+#include "phases.h"
+#include "steadystate.h"
+#include "fire.h"
+#include "packingcache.h"
+#include "restart.h"
+#include "checkpoint.h"
+#include "output.h"
+#include "archive.h"
+#include "analysis.h"
+#include "profiles.h"
+#include "coarsegrain.h"
+#include "heightmap.h"
+#include "stress.h"
+#include "contactnet.h"
+#include "veldist.h"
+#include "rdf.h"
+#include "correlator.h"
+#include "timing.h"
+#include "pbs.h"
+
+enum PbsParamType {PBS_PARAM_SIZE, PBS_PARAM_DOUBLE, PBS_PARAM_UINT, PBS_PARAM_BOOL};
+
+// scalar parameters that can be set by name
+static const struct
+{
+    const char *name;
+    size_t offset;
+    enum PbsParamType type;
+} pbs_param_table[] = {
+    {"num_part", offsetof(struct Parameters, num_part), PBS_PARAM_SIZE},
+    {"num_dt_steps", offsetof(struct Parameters, num_dt_steps), PBS_PARAM_SIZE},
+    {"dt", offsetof(struct Parameters, dt), PBS_PARAM_DOUBLE},
+    {"L.x", offsetof(struct Parameters, L.x), PBS_PARAM_DOUBLE},
+    {"L.y", offsetof(struct Parameters, L.y), PBS_PARAM_DOUBLE},
+    {"L.z", offsetof(struct Parameters, L.z), PBS_PARAM_DOUBLE},
+    {"g.x", offsetof(struct Parameters, g.x), PBS_PARAM_DOUBLE},
+    {"g.y", offsetof(struct Parameters, g.y), PBS_PARAM_DOUBLE},
+    {"g.z", offsetof(struct Parameters, g.z), PBS_PARAM_DOUBLE},
+    {"fric_pp", offsetof(struct Parameters, fric_pp), PBS_PARAM_DOUBLE},
+    {"num_dt_printf", offsetof(struct Parameters, num_dt_printf), PBS_PARAM_SIZE},
+    {"num_dt_traj", offsetof(struct Parameters, num_dt_traj), PBS_PARAM_SIZE},
+    {"traj_fields", offsetof(struct Parameters, traj_fields), PBS_PARAM_UINT},
+    {"traj_single_precision", offsetof(struct Parameters, traj_single_precision), PBS_PARAM_BOOL},
+    {"traj_delta", offsetof(struct Parameters, traj_delta), PBS_PARAM_BOOL},
+    {"traj_adaptive", offsetof(struct Parameters, traj_adaptive), PBS_PARAM_BOOL},
+    {"num_dt_archive", offsetof(struct Parameters, num_dt_archive), PBS_PARAM_SIZE},
+    {"num_dt_restart", offsetof(struct Parameters, num_dt_restart), PBS_PARAM_SIZE},
+    {"restart_async", offsetof(struct Parameters, restart_async), PBS_PARAM_BOOL},
+    {"output_async", offsetof(struct Parameters, output_async), PBS_PARAM_BOOL},
+    {"H_R_ratio", offsetof(struct Parameters, H_R_ratio), PBS_PARAM_DOUBLE},
+    {"R_cyl", offsetof(struct Parameters, R_cyl), PBS_PARAM_DOUBLE},
+    {"use_packing_cache", offsetof(struct Parameters, use_packing_cache), PBS_PARAM_BOOL},
+    {"num_dt_steady", offsetof(struct Parameters, num_dt_steady), PBS_PARAM_SIZE},
+    {"steady_Ekin_tol", offsetof(struct Parameters, steady_Ekin_tol), PBS_PARAM_DOUBLE},
+    {"steady_v_tol", offsetof(struct Parameters, steady_v_tol), PBS_PARAM_DOUBLE},
+    {"steady_dh_tol", offsetof(struct Parameters, steady_dh_tol), PBS_PARAM_DOUBLE},
+    {"num_dt_stress", offsetof(struct Parameters, num_dt_stress), PBS_PARAM_SIZE},
+    {"num_dt_corr", offsetof(struct Parameters, num_dt_corr), PBS_PARAM_SIZE},
+    {"num_dt_timing", offsetof(struct Parameters, num_dt_timing), PBS_PARAM_SIZE},
+};
+
+struct Parameters *pbs_parameters_create(void)
+{
+    struct Parameters *p_parameters = malloc(sizeof(struct Parameters));
+    if (p_parameters)
+        set_parameters(p_parameters);
+    return p_parameters;
+}
+
+void pbs_parameters_destroy(struct Parameters *p_parameters)
+{
+    free(p_parameters);
+}
+
+static int pbs_param_find(const char *name)
+{
+    for (size_t k = 0; k < sizeof(pbs_param_table) / sizeof(pbs_param_table[0]); k++)
+        if (strcmp(pbs_param_table[k].name, name) == 0)
+            return (int)k;
+    return -1;
+}
+
+bool pbs_parameters_set(struct Parameters *p_parameters, const char *name, double value)
+{
+    int k = pbs_param_find(name);
+    if (k < 0)
+        return false;
+    char *member = (char *)p_parameters + pbs_param_table[k].offset;
+    switch (pbs_param_table[k].type)
+    {
+    case PBS_PARAM_SIZE: *(size_t *)member = (size_t)value; break;
+    case PBS_PARAM_DOUBLE: *(double *)member = value; break;
+    case PBS_PARAM_UINT: *(unsigned int *)member = (unsigned int)value; break;
+    case PBS_PARAM_BOOL: *(bool *)member = (value != 0.0); break;
+    }
+    return true;
+}
+
+bool pbs_parameters_get(const struct Parameters *p_parameters, const char *name, double *p_value)
+{
+    int k = pbs_param_find(name);
+    if (k < 0)
+        return false;
+    const char *member = (const char *)p_parameters + pbs_param_table[k].offset;
+    switch (pbs_param_table[k].type)
+    {
+    case PBS_PARAM_SIZE: *p_value = (double)*(const size_t *)member; break;
+    case PBS_PARAM_DOUBLE: *p_value = *(const double *)member; break;
+    case PBS_PARAM_UINT: *p_value = (double)*(const unsigned int *)member; break;
+    case PBS_PARAM_BOOL: *p_value = *(const bool *)member ? 1.0 : 0.0; break;
+    }
+    return true;
+}
+
+// Per-particle contact stress for the analyses that sample it
+static void pbs_stress_alloc(struct Simulation *p_sim)
+{
+    if ((p_sim->analyses.fields & SNAPSHOT_FIELD_STRESS) && p_sim->vectors.stress == NULL)
+        p_sim->vectors.stress = (struct SymTensor *)calloc(p_sim->parameters.num_part, sizeof(struct SymTensor));
+}
+
+struct Simulation *pbs_create(const struct Parameters *p_parameters)
+{
+    struct Simulation *p_sim = calloc(1, sizeof(struct Simulation));
+    if (p_sim == NULL)
+        return NULL;
+    p_sim->parameters = *p_parameters;
+    struct Parameters *p = &p_sim->parameters;
+    alloc_memory(p, &p_sim->vectors, &p_sim->nbrlist, &p_sim->colllist);
+
+    /* energy minimization for phases with INTEGRATOR_FIRE */
+    fire_init(p, &p_sim->fire);
+    /* early termination once the pile has stopped moving */
+    steady_state_init(p, &p_sim->steady);
+
+    bool restored = false; // complete state including contact history was loaded
+    if (p->load_restart == 1)
+    {
+        restored = load_restart(p, &p_sim->vectors, &p_sim->nbrlist, &p_sim->colllist, &p_sim->step,
+                                &p_sim->phase_state, &p_sim->fire, &p_sim->steady);
+        if (!restored)
+        {
+            steady_state_free(&p_sim->steady);
+            free_memory(&p_sim->vectors, &p_sim->nbrlist, &p_sim->colllist);
+            free(p_sim);
+            return NULL;
+        }
+    }
+    else if (p->use_packing_cache && p->num_phases > 1)
+    {
+        restored = packing_cache_load(p, &p_sim->vectors, &p_sim->nbrlist, &p_sim->colllist, &p_sim->step,
+                                      &p_sim->phase_state, &p_sim->fire, &p_sim->steady);
+        p_sim->cache_packing = !restored;
+    }
+    if (!restored)
+    {
+        initialise(p, &p_sim->vectors);
+        /* settle -> wall removal -> spread sequence, see phases in set_parameters */
+        phases_init(p, &p_sim->phase_state, p_sim->step, p_sim->vectors.time);
+        build_nbrlist(p, &p_sim->vectors, &p_sim->nbrlist);
+        update_colllist(p, &p_sim->vectors, &p_sim->nbrlist, &p_sim->colllist);
+        p_sim->Epot = calculate_forces(p, &p_sim->colllist, &p_sim->vectors, false, NULL);
+    }
+
+    /* in-situ analyses, sampled from the snapshots of the output pipeline */
+    analysis_init(&p_sim->analyses);
+    profiles_register(p, &p_sim->analyses);
+    coarsegrain_register(p, &p_sim->analyses);
+    heightmap_register(p, &p_sim->analyses);
+    stress_register(p, &p_sim->analyses);
+    contactnet_register(p, &p_sim->analyses);
+    veldist_register(p, &p_sim->analyses);
+    rdf_register(p, &p_sim->analyses);
+    correlator_register(p, &p_sim->analyses);
+    pbs_stress_alloc(p_sim);
+
+    /* trajectory frames, analysis samples and status lines are produced by a background writer */
+    if (!output_init(p, &p_sim->analyses, &p_sim->output))
+    {
+        analysis_free(&p_sim->analyses);
+        steady_state_free(&p_sim->steady);
+        free_memory(&p_sim->vectors, &p_sim->nbrlist, &p_sim->colllist);
+        free(p_sim);
+        return NULL;
+    }
+    output_publish(&p_sim->output, &p_sim->vectors, &p_sim->nbrlist, &p_sim->colllist, p_sim->step, p_sim->phase_state.current,
+                   0.0, p_sim->Epot, OUTPUT_TASK_FRAME);
+    output_schedule_init(&p_sim->schedule, p_sim->step); // adaptive trajectory cadence (D2)
+
+    /* restart files are written by a background thread while stepping continues */
+    if (p->restart_async && !checkpoint_init(p, &p_sim->checkpoint))
+        p->restart_async = false;
+
+    /* time per part of the step and list counters (off unless num_dt_timing > 0) */
+    timing_init(p, &p_sim->timing);
+    return p_sim;
+}
+
+size_t pbs_step(struct Simulation *p_sim, size_t num_steps)
+{
+    struct Parameters *p = &p_sim->parameters;
+    struct Vectors *p_vectors = &p_sim->vectors;
+    struct Nbrlist *p_nbrlist = &p_sim->nbrlist;
+    struct Colllist *p_colllist = &p_sim->colllist;
+    struct Timing *p_timing = &p_sim->timing;
+    size_t num_done = 0;
+
+    while (num_done < num_steps && !p_sim->stopped && !p_sim->finished) //velocity-Verlet loop
+    {
+        size_t step = ++p_sim->step;
+        num_done++;
+        p_vectors->time += p->dt;
+        timing_start_step(p_timing, p_sim->phase_state.current);
+
+        p_sim->Ekin = update_velocities_half_dt(p, p_nbrlist, p_vectors);
+        timing_lap(p_timing, TIMER_VELOCITIES);
+        update_positions(p, p_nbrlist, p_vectors);
+        timing_lap(p_timing, TIMER_POSITIONS);
+
+        update_tangential_displacements(p, p_vectors, p_colllist);
+        timing_lap(p_timing, TIMER_TANGENTIAL);
+        boundary_conditions(p, p_vectors);
+        timing_lap(p_timing, TIMER_BOUNDARY);
+        update_nbrlist(p, p_vectors, p_nbrlist);
+        timing_lap(p_timing, TIMER_NBRLIST);
+        update_colllist(p, p_vectors, p_nbrlist, p_colllist);
+        timing_lap(p_timing, TIMER_COLLLIST);
+        // contact stress only on the steps an analysis samples it
+        bool virial = (analysis_fields_due(&p_sim->analyses, step) & SNAPSHOT_FIELD_STRESS) != 0u;
+        p_sim->Epot = calculate_forces(p, p_colllist, p_vectors, virial, p_timing);
+        p_sim->Ekin = update_velocities_half_dt(p, p_nbrlist, p_vectors);
+        timing_lap(p_timing, TIMER_VELOCITIES);
+
+        if (p->phases[p_sim->phase_state.current].integrator == INTEGRATOR_FIRE)
+            fire_update(p, &p_sim->fire, p_vectors, p_sim->Ekin);
+        if (phases_update(p, &p_sim->phase_state, step, p_sim->Ekin, p_vectors, p_nbrlist, p_colllist))
+        {
+            fire_reset(p, &p_sim->fire); // new phase starts with the time step of normal dynamics
+            if (p_sim->cache_packing && p_sim->phase_state.current == 1)
+                packing_cache_store(p, p_vectors, p_nbrlist, p_colllist, step, &p_sim->phase_state, &p_sim->fire, &p_sim->steady);
+        }
+
+        timing_lap(p_timing, TIMER_OTHER);
+        unsigned int tasks = 0;
+        if (step%p->num_dt_printf ==0) tasks |= OUTPUT_TASK_STATUS;
+        if (analysis_due(&p_sim->analyses, step)) tasks |= OUTPUT_TASK_ANALYSIS;
+        if (p->traj_adaptive ? output_frame_due(&p_sim->schedule, p, p_vectors, step) : step%p->num_dt_traj == 0)
+            tasks |= OUTPUT_TASK_FRAME;
+        if (p->num_dt_archive > 0 && step%p->num_dt_archive == 0) tasks |= OUTPUT_TASK_ARCHIVE;
+        if (tasks)
+            output_publish(&p_sim->output, p_vectors, p_nbrlist, p_colllist, step, p_sim->phase_state.current,
+                           p_sim->Ekin, p_sim->Epot, tasks);
+        timing_lap(p_timing, TIMER_OUTPUT);
+
+        if (p->phases[p_sim->phase_state.current].detect_steady && step%p->num_dt_steady == 0 &&
+            steady_state_update(p, p_vectors, p_sim->Ekin, &p_sim->steady))
+            p_sim->stopped = true;
+        timing_lap(p_timing, TIMER_OTHER);
+
+        if (!p_sim->stopped && step%p->num_dt_restart == 0)
+        {
+            if (p->restart_async)
+                checkpoint_save(&p_sim->checkpoint, p, p_vectors, p_nbrlist, p_colllist, step, &p_sim->phase_state, &p_sim->fire, &p_sim->steady);
+            else
+                save_restart(p, p_vectors, p_nbrlist, p_colllist, step, &p_sim->phase_state, &p_sim->fire, &p_sim->steady);
+            timing_lap(p_timing, TIMER_OUTPUT);
+        }
+        timing_end_step(p_timing, step, p_nbrlist, p_colllist);
+    }
+    return num_done;
+}
+
+void pbs_finish(struct Simulation *p_sim)
+{
+    if (p_sim->finished)
+        return;
+    p_sim->finished = true;
+    struct Parameters *p = &p_sim->parameters;
+    struct Vectors *p_vectors = &p_sim->vectors;
+
+    output_finish(&p_sim->output);
+    if (p_sim->steady.reached)
+        printf("Run stopped at step %lu (time %g): %s\n", (long unsigned)p_sim->step, p_vectors->time, p_sim->steady.reason);
+    else
+        printf("Run stopped at step %lu (time %g): reached num_dt_steps\n", (long unsigned)p_sim->step, p_vectors->time);
+
+    // analyses of the final state, then all results (e.g. averaged and final profiles, final pile)
+    analysis_finish(&p_sim->analyses, p, p_vectors, &p_sim->colllist, p_sim->step, p_sim->phase_state.current);
+
+    // compressed snapshot of the final pile
+    char filename_archive[1100];
+    snprintf(filename_archive, sizeof(filename_archive), "%s_final.pba", p->filename_archive);
+    archive_write(filename_archive, p, p_vectors, p_sim->step);
+    if (p->restart_async)
+    {
+        checkpoint_save(&p_sim->checkpoint, p, p_vectors, &p_sim->nbrlist, &p_sim->colllist, p_sim->step,
+                        &p_sim->phase_state, &p_sim->fire, &p_sim->steady);
+        checkpoint_finish(&p_sim->checkpoint);
+    }
+    else
+        save_restart(p, p_vectors, &p_sim->nbrlist, &p_sim->colllist, p_sim->step, &p_sim->phase_state, &p_sim->fire, &p_sim->steady);
+    timing_finish(&p_sim->timing);
+}
+
+void pbs_destroy(struct Simulation *p_sim)
+{
+    if (p_sim == NULL)
+        return;
+    if (!p_sim->finished)
+    {
+        output_finish(&p_sim->output);
+        if (p_sim->parameters.restart_async)
+            checkpoint_finish(&p_sim->checkpoint);
+        analysis_free(&p_sim->analyses);
+        timing_free(&p_sim->timing);
+    }
+    steady_state_free(&p_sim->steady);
+    free_memory(&p_sim->vectors, &p_sim->nbrlist, &p_sim->colllist);
+    free(p_sim);
+}
+
+size_t pbs_step_count(const struct Simulation *p_sim)
+{
+    return p_sim->step;
+}
+
+double pbs_time(const struct Simulation *p_sim)
+{
+    return p_sim->vectors.time;
+}
+
+void pbs_energies(const struct Simulation *p_sim, double *p_Ekin, double *p_Epot)
+{
+    *p_Ekin = p_sim->Ekin;
+    *p_Epot = p_sim->Epot;
+}
+
+bool pbs_stopped(const struct Simulation *p_sim)
+{
+    return p_sim->stopped;
+}
+
+struct Parameters *pbs_parameters(struct Simulation *p_sim)
+{
+    return &p_sim->parameters;
+}
+
+bool (*pbs_wall_function(const char *name))(struct Parameters *, double, struct Vec3D *, struct DeltaR *, struct Vec3D *)
+{
+    if (strcmp(name, "bottom") == 0)
+        return bottom_wall;
+    if (strcmp(name, "top") == 0)
+        return top_wall;
+    if (strcmp(name, "cylindrical") == 0)
+        return cylindrical_wall;
+    return NULL;
+}
+
+int pbs_wall_add(struct Simulation *p_sim,
+                 bool (*wall_function)(struct Parameters *, double, struct Vec3D *, struct DeltaR *, struct Vec3D *),
+                 double e_n, double e_t, double muf)
+{
+    struct Parameters *p = &p_sim->parameters;
+    if (p->num_walls >= NUM_WALLS_MAX || wall_function == NULL)
+        return -1;
+    unsigned int index = p->num_walls++;
+    p->wall_function[index] = wall_function;
+    set_wall_coefficients(p, index, e_n, e_t, muf);
+    p->wall_mask |= WALL_BIT(index);
+    for (size_t k = p_sim->phase_state.current; k < p->num_phases; k++)
+        p->phases[k].wall_mask |= WALL_BIT(index);
+    return (int)index;
+}
+
+bool pbs_wall_remove(struct Simulation *p_sim, unsigned int index)
+{
+    struct Parameters *p = &p_sim->parameters;
+    if (index >= p->num_walls)
+        return false;
+    p->wall_mask &= ~WALL_BIT(index);
+    for (size_t k = p_sim->phase_state.current; k < p->num_phases; k++)
+        p->phases[k].wall_mask &= ~WALL_BIT(index);
+    remove_inactive_wall_contacts(p, &p_sim->colllist);
+    return true;
+}
+
+bool pbs_analysis_add(struct Simulation *p_sim, const struct Analysis *p_analysis)
+{
+    // the writer thread reads the set of analyses while it samples the published snapshots
+    output_drain(&p_sim->output);
+    if (!analysis_add(&p_sim->analyses, p_analysis))
+        return false;
+    pbs_stress_alloc(p_sim);
+    return true;
+}
+
+const void *pbs_array(const struct Simulation *p_sim, enum PbsArrayId id, size_t *p_num)
+{
+    const struct Vectors *p_vectors = &p_sim->vectors;
+    *p_num = p_sim->parameters.num_part;
+    switch (id)
+    {
+    case PBS_ARRAY_POSITION: return p_vectors->r;
+    case PBS_ARRAY_VELOCITY: return p_vectors->v;
+    case PBS_ARRAY_OMEGA: return p_vectors->omega;
+    case PBS_ARRAY_FORCE: return p_vectors->f;
+    case PBS_ARRAY_TORQUE: return p_vectors->T;
+    case PBS_ARRAY_RADIUS: return p_vectors->radius;
+    case PBS_ARRAY_MASS: return p_vectors->mass;
+    case PBS_ARRAY_TYPE: return p_vectors->type;
+    case PBS_ARRAY_IMAGE: return p_vectors->image;
+    case PBS_ARRAY_STRESS:
+        if (p_vectors->stress != NULL)
+            return p_vectors->stress;
+        break;
+    }
+    *p_num = 0;
+    return NULL;
+}
+
+const struct Pair *pbs_contacts(const struct Simulation *p_sim, size_t *p_num, const double **p_fn_sq, const double **p_ft_sq)
+{
+    *p_num = p_sim->colllist.num_nbrs;
+    if (p_fn_sq)
+        *p_fn_sq = p_sim->colllist.fn_sq;
+    if (p_ft_sq)
+        *p_ft_sq = p_sim->colllist.ft_sq;
+    return p_sim->colllist.nbr;
+}
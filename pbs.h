@@ -0,0 +1,190 @@
+#ifndef PBS_H_
+#define PBS_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "structs.h"
+
+/* Library API: drive a simulation from another program (main.c is one client). All output files are written
+   as configured in the parameters. Simulations keep no global state, but the analyses, timing and final-pile
+   output write to fixed file names in data/ of the working directory, so simulations that run at the same time
+   overwrite each other's results unless they run in separate processes with separate working directories. */
+
+/**
+ * @brief Allocate a parameter struct filled with the defaults of @ref set_parameters, for clients that cannot
+ * embed struct Parameters (e.g. Python through ctypes)
+ *
+ * @return struct Parameters* free with @ref pbs_parameters_destroy, NULL if out of memory
+ */
+struct Parameters *pbs_parameters_create(void);
+
+/**
+ * @brief Free a parameter struct of @ref pbs_parameters_create
+ *
+ * @param[in] p_parameters
+ */
+void pbs_parameters_destroy(struct Parameters *p_parameters);
+
+/**
+ * @brief Set a scalar parameter by its member name, e.g. "num_dt_steps" or "g.z". Quantities derived from it
+ * in @ref set_parameters (time step, contact coefficients, ...) are not recomputed.
+ *
+ * @param[in,out] p_parameters
+ * @param[in] name member name
+ * @param[in] value new value, converted to the type of the member
+ * @return bool false if there is no settable member of that name
+ */
+bool pbs_parameters_set(struct Parameters *p_parameters, const char *name, double value);
+
+/**
+ * @brief Get a scalar parameter by its member name, see @ref pbs_parameters_set
+ *
+ * @param[in] p_parameters
+ * @param[in] name member name
+ * @param[out] p_value value converted to double
+ * @return bool false if there is no such member
+ */
+bool pbs_parameters_get(const struct Parameters *p_parameters, const char *name, double *p_value);
+
+/**
+ * @brief Create a simulation: allocate it, then load the restart file (if load_restart), load the packing
+ * cache or initialise the particles, and start the output and checkpoint writers
+ *
+ * @param[in] p_parameters parameters, copied into the simulation
+ * @return struct Simulation* NULL if the restart file cannot be loaded, the trajectory file cannot be opened or
+ * memory runs out
+ */
+struct Simulation *pbs_create(const struct Parameters *p_parameters);
+
+/**
+ * @brief Advance a simulation by up to num_steps velocity-Verlet steps, including phase changes, output
+ * and restart files
+ *
+ * @param[in,out] p_sim
+ * @param[in] num_steps number of time steps
+ * @return size_t number of steps done; less than num_steps if the steady-state detector stopped the run
+ */
+size_t pbs_step(struct Simulation *p_sim, size_t num_steps);
+
+/**
+ * @brief End a run: flush the output, write the analysis results (profiles, final pile characterization), the final
+ * archive and restart file. The simulation can still be inspected afterwards but not stepped.
+ *
+ * @param[in,out] p_sim
+ */
+void pbs_finish(struct Simulation *p_sim);
+
+/**
+ * @brief Free a simulation; stops its writer threads if @ref pbs_finish was not called
+ *
+ * @param[in] p_sim
+ */
+void pbs_destroy(struct Simulation *p_sim);
+
+/**
+ * @brief Number of the last time step done
+ *
+ * @param[in] p_sim
+ * @return size_t
+ */
+size_t pbs_step_count(const struct Simulation *p_sim);
+
+/**
+ * @brief Simulated time
+ *
+ * @param[in] p_sim
+ * @return double
+ */
+double pbs_time(const struct Simulation *p_sim);
+
+/**
+ * @brief Kinetic and potential energy after the last time step
+ *
+ * @param[in] p_sim
+ * @param[out] p_Ekin
+ * @param[out] p_Epot
+ */
+void pbs_energies(const struct Simulation *p_sim, double *p_Ekin, double *p_Epot);
+
+/**
+ * @brief Whether the steady-state detector has stopped the run
+ *
+ * @param[in] p_sim
+ * @return bool
+ */
+bool pbs_stopped(const struct Simulation *p_sim);
+
+/**
+ * @brief Parameters of a running simulation. Members that only affect output may be changed between steps.
+ *
+ * @param[in] p_sim
+ * @return struct Parameters*
+ */
+struct Parameters *pbs_parameters(struct Simulation *p_sim);
+
+/**
+ * @brief Look up a wall model of walls.h by name: "bottom", "top" or "cylindrical"
+ *
+ * @param[in] name
+ * @return wall function, NULL if unknown
+ */
+bool (*pbs_wall_function(const char *name))(struct Parameters *, double, struct Vec3D *, struct DeltaR *, struct Vec3D *);
+
+/**
+ * @brief Add a wall to a simulation. It is active in the current and all later phases; its contacts are found
+ * in the next time step.
+ *
+ * @param[in,out] p_sim
+ * @param[in] wall_function wall model, see walls.h
+ * @param[in] e_n normal restitution coefficient
+ * @param[in] e_t tangential restitution coefficient
+ * @param[in] muf friction coefficient
+ * @return int index of the wall, -1 if NUM_WALLS_MAX walls exist
+ */
+int pbs_wall_add(struct Simulation *p_sim,
+                 bool (*wall_function)(struct Parameters *, double, struct Vec3D *, struct DeltaR *, struct Vec3D *),
+                 double e_n, double e_t, double muf);
+
+/**
+ * @brief Remove a wall from the current and all later phases and drop its contacts. The index stays reserved.
+ *
+ * @param[in,out] p_sim
+ * @param[in] index index of the wall
+ * @return bool false if there is no such wall
+ */
+bool pbs_wall_remove(struct Simulation *p_sim, unsigned int index);
+
+/**
+ * @brief Register an in-situ analysis, see analysis.h. It samples the snapshots of the output pipeline
+ * (on the writer thread if output_async) and writes its results in @ref pbs_finish. It can be added between
+ * steps: the call waits until the writer has processed the snapshots published so far, and the analysis samples
+ * from the next snapshot on.
+ *
+ * @param[in,out] p_sim
+ * @param[in] p_analysis copied; the simulation takes ownership of its state
+ * @return bool false if ANALYSIS_NUM_MAX analyses are registered
+ */
+bool pbs_analysis_add(struct Simulation *p_sim, const struct Analysis *p_analysis);
+
+/**
+ * @brief Zero-copy view of a particle array; valid until @ref pbs_destroy
+ *
+ * @param[in] p_sim
+ * @param[in] id array, see enum PbsArrayId for the element types
+ * @param[out] p_num number of particles
+ * @return const void* first element
+ */
+const void *pbs_array(const struct Simulation *p_sim, enum PbsArrayId id, size_t *p_num);
+
+/**
+ * @brief Zero-copy view of the particle-particle contacts (collision list); valid until the next @ref pbs_step
+ *
+ * @param[in] p_sim
+ * @param[out] p_num number of contacts
+ * @param[out] p_fn_sq squared normal contact force per contact, may be NULL
+ * @param[out] p_ft_sq squared tangential contact force per contact, may be NULL
+ * @return const struct Pair* contact pairs with their connecting vectors
+ */
+const struct Pair *pbs_contacts(const struct Simulation *p_sim, size_t *p_num, const double **p_fn_sq, const double **p_ft_sq);
+
+#endif /* PBS_H_ */
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "constants.h"
+#include "structs.h"
+#include "nbrlist.h"
+#include "phases.h"
+
+// Copy the settings of phase iphase into the parameters used by the time loop
+static void apply_phase(struct Parameters *p_parameters, size_t iphase)
+{
+    struct Phase *p_phase = &p_parameters->phases[iphase];
+    p_parameters->num_dt_traj = p_phase->num_dt_traj;
+    p_parameters->r_shell = p_phase->r_shell;
+    p_parameters->damping = p_phase->damping;
+    p_parameters->wall_mask = p_phase->wall_mask;
+}
+
+void phases_init(struct Parameters *p_parameters, struct PhaseState *p_phase_state, size_t step, double time)
+{
+    *p_phase_state = (struct PhaseState){0, step, time, 0};
+    if (p_parameters->num_phases == 0)
+        return;
+    apply_phase(p_parameters, 0);
+    printf("Phase '%s' started at step %lu\n", p_parameters->phases[0].name, (long unsigned)step);
+}
+
+// Largest squared ratio of the net force on a particle and its weight
+static double max_force_ratio_sq(struct Parameters *p_parameters, struct Vectors *p_vectors)
+{
+    struct Vec3D g = p_parameters->g;
+    double g_sq = g.x * g.x + g.y * g.y + g.z * g.z;
+    double ratio_sq_max = 0.0;
+    for (size_t i = 0; i < p_parameters->num_part; ++i)
+    {
+        struct Vec3D f = p_vectors->f[i];
+        double w_sq = p_vectors->mass[i] * p_vectors->mass[i] * (g_sq > 0.0 ? g_sq : 1.0);
+        double ratio_sq = (f.x * f.x + f.y * f.y + f.z * f.z) / w_sq;
+        ratio_sq_max = (ratio_sq > ratio_sq_max ? ratio_sq : ratio_sq_max);
+    }
+    return ratio_sq_max;
+}
+
+// Returns true if the trigger of the active phase has fired
+static bool phase_trigger_fired(struct Parameters *p_parameters, struct PhaseState *p_phase_state, size_t step, double Ekin,
+                                struct Vectors *p_vectors)
+{
+    struct Phase *p_phase = &p_parameters->phases[p_phase_state->current];
+    switch (p_phase->trigger)
+    {
+    case PHASE_TRIGGER_STEP:
+        return (double)(step - p_phase_state->step_start) >= p_phase->trigger_value;
+    case PHASE_TRIGGER_TIME:
+        return p_vectors->time - p_phase_state->time_start >= p_phase->trigger_value;
+    case PHASE_TRIGGER_EKIN:
+        if (Ekin / (double)p_parameters->num_part < p_phase->trigger_value)
+            p_phase_state->counter++;
+        else
+            p_phase_state->counter = 0;
+        return p_phase_state->counter >= p_phase->trigger_pers_steps;
+    case PHASE_TRIGGER_FORCE:
+        if (max_force_ratio_sq(p_parameters, p_vectors) < p_phase->trigger_value * p_phase->trigger_value)
+            p_phase_state->counter++;
+        else
+            p_phase_state->counter = 0;
+        return p_phase_state->counter >= p_phase->trigger_pers_steps;
+    case PHASE_TRIGGER_NONE:
+    default:
+        return false;
+    }
+}
+
+bool phases_update(struct Parameters *p_parameters, struct PhaseState *p_phase_state, size_t step, double Ekin,
+                   struct Vectors *p_vectors, struct Nbrlist *p_nbrlist, struct Colllist *p_colllist)
+{
+    if (p_phase_state->current + 1 >= p_parameters->num_phases)
+        return false;
+    if (!phase_trigger_fired(p_parameters, p_phase_state, step, Ekin, p_vectors))
+        return false;
+
+    unsigned int wall_mask_old = p_parameters->wall_mask;
+    double r_shell_old = p_parameters->r_shell;
+    p_phase_state->current++;
+    p_phase_state->step_start = step;
+    p_phase_state->time_start = p_vectors->time;
+    p_phase_state->counter = 0;
+    apply_phase(p_parameters, p_phase_state->current);
+
+    if (p_parameters->r_shell != r_shell_old)
+    {
+        // a new shell thickness invalidates the neighbor list; the collision list keeps its history
+        build_nbrlist(p_parameters, p_vectors, p_nbrlist);
+        update_colllist(p_parameters, p_vectors, p_nbrlist, p_colllist);
+    }
+    else if ((p_parameters->wall_mask & wall_mask_old) != wall_mask_old)
+        remove_inactive_wall_contacts(p_parameters, p_colllist); // newly activated walls are found by the next update_colllist
+    printf("Phase '%s' started at step %lu (time %g)\n", p_parameters->phases[p_phase_state->current].name,
+           (long unsigned)step, p_vectors->time);
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef PHASES_H_
+#define PHASES_H_
+
+#include <stdbool.h>
+
+/**
+ * @brief Start the first phase and apply its settings to the parameters.
+ * 
+ * @param[in,out] p_parameters used members: phases, num_phases; set members: num_dt_traj, r_shell, damping, wall_mask
+ * @param[out] p_phase_state progress through the phases
+ * @param[in] step time step at which the first phase starts
+ * @param[in] time time at which the first phase starts
+ */
+void phases_init(struct Parameters *p_parameters, struct PhaseState *p_phase_state, size_t step, double time);
+
+/**
+ * @brief Check the trigger of the active phase and switch to the next phase if it fired.
+ * When the wall mask changes only the wall contacts in the collision list are updated,
+ * when the shell thickness changes the neighbor list is rebuilt.
+ * 
+ * @param[in,out] p_parameters 
+ * @param[in,out] p_phase_state 
+ * @param[in] step current time step
+ * @param[in] Ekin current kinetic energy
+ * @param[in] p_vectors 
+ * @param[in,out] p_nbrlist 
+ * @param[in,out] p_colllist 
+ * @return bool true if a new phase was started
+ */
+bool phases_update(struct Parameters *p_parameters, struct PhaseState *p_phase_state, size_t step, double Ekin,
+                   struct Vectors *p_vectors, struct Nbrlist *p_nbrlist, struct Colllist *p_colllist);
+
+#endif /* PHASES_H_ */
@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "analysis.h"
+#include "profiles.h"
+
+static void profile_free(void *state)
+{
+    struct ProfileState *p_state = (struct ProfileState *)state;
+    if (p_state == NULL)
+        return;
+    free(p_state->vol_r);
+    free(p_state->vol_z);
+    free(p_state->count_r);
+    free(p_state->vol_r_tot);
+    free(p_state->vol_z_tot);
+    free(p_state->phi_r_sum);
+    free(p_state->phi_z_sum);
+    free(p_state->count_r_sum);
+    free(p_state);
+}
+
+// Allocate the bins (0..R_cyl radially, 0..L.z axially) and their geometric volumes
+static struct ProfileState *profile_alloc(struct Parameters *p_parameters, size_t num_bins_r, size_t num_bins_z)
+{
+    struct ProfileState *p_state = (struct ProfileState *)calloc(1, sizeof(struct ProfileState));
+    if (p_state == NULL)
+        return NULL;
+    double R_cyl = p_parameters->R_cyl;
+    double H = p_parameters->L.z;
+    p_state->num_bins_r = num_bins_r;
+    p_state->num_bins_z = num_bins_z;
+    p_state->dr = R_cyl / (double)num_bins_r;
+    p_state->dz = H / (double)num_bins_z;
+    p_state->vol_r = (double *)calloc(num_bins_r, sizeof(double));
+    p_state->vol_z = (double *)calloc(num_bins_z, sizeof(double));
+    p_state->count_r = (size_t *)calloc(num_bins_r, sizeof(size_t));
+    p_state->vol_r_tot = (double *)calloc(num_bins_r, sizeof(double));
+    p_state->vol_z_tot = (double *)calloc(num_bins_z, sizeof(double));
+    p_state->phi_r_sum = (double *)calloc(num_bins_r, sizeof(double));
+    p_state->phi_z_sum = (double *)calloc(num_bins_z, sizeof(double));
+    p_state->count_r_sum = (double *)calloc(num_bins_r, sizeof(double));
+    if (!p_state->vol_r || !p_state->vol_z || !p_state->count_r || !p_state->vol_r_tot || !p_state->vol_z_tot ||
+        !p_state->phi_r_sum || !p_state->phi_z_sum || !p_state->count_r_sum)
+    {
+        fprintf(stderr, "Error: failed to allocate profile bins\n");
+        profile_free(p_state);
+        return NULL;
+    }
+
+    for (size_t ir = 0; ir < num_bins_r; ++ir) {
+        double r1 = ir * p_state->dr;
+        double r2 = (ir + 1) * p_state->dr;
+        p_state->vol_r_tot[ir] = PI * (r2*r2 - r1*r1) * H;
+    }
+    for (size_t iz = 0; iz < num_bins_z; ++iz) {
+        double z1 = iz * p_state->dz;
+        double z2 = (iz + 1) * p_state->dz;
+        p_state->vol_z_tot[iz] = PI * R_cyl * R_cyl * (z2 - z1);
+    }
+    return p_state;
+}
+
+// Bin the particle volumes and centres of one snapshot (each particle counts fully in the bin of its centre)
+static void profile_bin(struct ProfileState *p_state, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    size_t num_bins_r = p_state->num_bins_r;
+    size_t num_bins_z = p_state->num_bins_z;
+    for (size_t ir = 0; ir < num_bins_r; ++ir) {
+        p_state->vol_r[ir] = 0.0;
+        p_state->count_r[ir] = 0;
+    }
+    for (size_t iz = 0; iz < num_bins_z; ++iz)
+        p_state->vol_z[iz] = 0.0;
+
+    double cx = 0.5 * p_parameters->L.x;
+    double cy = 0.5 * p_parameters->L.y;
+    for (size_t i = 0; i < p_snap->num_part; ++i) {
+        double x = p_snap->r[i].x;
+        double y = p_snap->r[i].y;
+        double z = p_snap->r[i].z;
+        double r_part = sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy));
+        double R = p_snap->radius[i];
+        double vol = (4.0/3.0) * PI * R * R * R;
+        p_state->solid_vol_sum += vol;
+
+        int ir = (int)(r_part / p_state->dr);
+        if (ir >= 0 && (size_t)ir < num_bins_r) {
+            p_state->vol_r[ir] += vol;
+            p_state->count_r[ir]++;
+        }
+
+        int iz = (int)(z / p_state->dz);
+        if (iz >= 0 && (size_t)iz < num_bins_z)
+            p_state->vol_z[iz] += vol;
+    }
+    p_state->num_part_sum += p_snap->num_part;
+}
+
+// Accumulate the volume fractions of one snapshot
+static void profile_sample(struct Analysis *p_analysis, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    struct ProfileState *p_state = (struct ProfileState *)p_analysis->state;
+    profile_bin(p_state, p_parameters, p_snap);
+    for (size_t ir = 0; ir < p_state->num_bins_r; ++ir) {
+        if (p_state->vol_r_tot[ir] > 0.0)
+            p_state->phi_r_sum[ir] += p_state->vol_r[ir] / p_state->vol_r_tot[ir];
+        p_state->count_r_sum[ir] += (double)p_state->count_r[ir];
+    }
+    for (size_t iz = 0; iz < p_state->num_bins_z; ++iz) {
+        if (p_state->vol_z_tot[iz] > 0.0)
+            p_state->phi_z_sum[iz] += p_state->vol_z[iz] / p_state->vol_z_tot[iz];
+    }
+}
+
+// Add the sums of another instance with the same bins
+static void profile_merge(struct Analysis *p_analysis, const struct Analysis *p_other)
+{
+    struct ProfileState *p_state = (struct ProfileState *)p_analysis->state;
+    const struct ProfileState *p_state_other = (const struct ProfileState *)p_other->state;
+    for (size_t ir = 0; ir < p_state->num_bins_r; ++ir) {
+        p_state->phi_r_sum[ir] += p_state_other->phi_r_sum[ir];
+        p_state->count_r_sum[ir] += p_state_other->count_r_sum[ir];
+    }
+    for (size_t iz = 0; iz < p_state->num_bins_z; ++iz)
+        p_state->phi_z_sum[iz] += p_state_other->phi_z_sum[iz];
+    p_state->solid_vol_sum += p_state_other->solid_vol_sum;
+    p_state->num_part_sum += p_state_other->num_part_sum;
+}
+
+// Write the averaged volume fractions against the bin centres scaled by R_cyl and L.z
+static void profile_write(struct Analysis *p_analysis, struct Parameters *p_parameters)
+{
+    struct ProfileState *p_state = (struct ProfileState *)p_analysis->state;
+    double num_samples = (double)p_analysis->num_samples;
+
+    FILE *fr = fopen(p_state->filename_r, "w");
+    if (fr) {
+        fprintf(fr, "radius,%s\n", p_state->column);
+        for (size_t ir = 0; ir < p_state->num_bins_r; ++ir) {
+            double r_center = ((ir + 0.5) * p_state->dr)/p_parameters->R_cyl;
+            fprintf(fr, "%g,%g\n", r_center, p_state->phi_r_sum[ir] / num_samples);
+        }
+        fclose(fr);
+    } else {
+        fprintf(stderr, "Error: cannot open %s for writing\n", p_state->filename_r);
+    }
+
+    FILE *fz = fopen(p_state->filename_z, "w");
+    if (fz) {
+        fprintf(fz, "height,%s\n", p_state->column);
+        for (size_t iz = 0; iz < p_state->num_bins_z; ++iz) {
+            double z_center = ((iz + 0.5) * p_state->dz)/p_parameters->L.z;
+            fprintf(fz, "%g,%g\n", z_center, p_state->phi_z_sum[iz] / num_samples);
+        }
+        fclose(fz);
+    } else {
+        fprintf(stderr, "Error: cannot open %s for writing\n", p_state->filename_z);
+    }
+}
+
+/* Write a centre-count based radial profile: the mean number of particle centres per annulus is
+   converted to a volume fraction using the average particle volume. */
+static void profile_write_center(struct Analysis *p_analysis, struct Parameters *p_parameters)
+{
+    struct ProfileState *p_state = (struct ProfileState *)p_analysis->state;
+    double num_samples = (double)p_analysis->num_samples;
+    double avg_particle_vol = (p_state->num_part_sum > 0) ? (p_state->solid_vol_sum / (double)p_state->num_part_sum) : 0.0;
+
+    FILE *fc = fopen(p_state->filename_r, "w");
+    if (fc) {
+        fprintf(fc, "radius,count,%s\n", p_state->column);
+        for (size_t ir = 0; ir < p_state->num_bins_r; ++ir) {
+            double r_center = (ir + 0.5) * p_state->dr;
+            double count = p_state->count_r_sum[ir] / num_samples;
+            double phi_center = 0.0;
+            if (p_state->vol_r_tot[ir] > 0.0)
+                phi_center = count * avg_particle_vol / p_state->vol_r_tot[ir];
+            fprintf(fc, "%g,%g,%g\n", r_center, count, phi_center);
+        }
+        fclose(fc);
+    } else {
+        fprintf(stderr, "Error: cannot open %s for writing\n", p_state->filename_r);
+    }
+}
+
+static void profile_add(struct AnalysisSet *p_set, struct Parameters *p_parameters, const char *name, size_t num_dt, bool final,
+                        size_t num_bins_r, size_t num_bins_z, const char *filename_r, const char *filename_z, const char *column,
+                        void (*finish)(struct Analysis *, struct Parameters *))
+{
+    struct ProfileState *p_state = profile_alloc(p_parameters, num_bins_r, num_bins_z);
+    if (p_state == NULL)
+        return;
+    p_state->filename_r = filename_r;
+    p_state->filename_z = filename_z;
+    p_state->column = column;
+    struct Analysis analysis = {.name = name, .num_dt = num_dt, .final = final,
+                                .fields = 0u, .contacts = false, .state = p_state,
+                                .sample = profile_sample, .finish = finish, .free = profile_free, .merge = profile_merge};
+    analysis_add(p_set, &analysis);
+}
+
+void profiles_register(struct Parameters *p_parameters, struct AnalysisSet *p_set)
+{
+    if (p_parameters->num_dt_profiles > 0)
+        profile_add(p_set, p_parameters, "averaged profiles", p_parameters->num_dt_profiles, false,
+                    p_parameters->profile_num_bins_r, p_parameters->profile_num_bins_z,
+                    "data/dens_radial_avg.csv", "data/dens_axial_avg.csv", "volume_fraction_avg", profile_write);
+    profile_add(p_set, p_parameters, "final profiles", 0, true,
+                p_parameters->profile_final_num_bins_r, p_parameters->profile_final_num_bins_z,
+                "data/dens_radial.csv", "data/dens_axial.csv", "volume_fraction", profile_write);
+    profile_add(p_set, p_parameters, "final centre profile", 0, true, p_parameters->profile_final_num_bins_r, 1,
+                "data/dens_radial_center.csv", NULL, "volume_fraction_center", profile_write_center);
+}
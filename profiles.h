@@ -0,0 +1,19 @@
+#ifndef PROFILES_H_
+#define PROFILES_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Register the volume fraction profiles as analyses:
+ * - profiles averaged every num_dt_profiles steps over the run: data/dens_radial_avg.csv, data/dens_axial_avg.csv
+ * - profiles of the final pile: data/dens_radial.csv, data/dens_axial.csv
+ * - radial profile of the final pile from particle centres: data/dens_radial_center.csv
+ * 
+ * @param[in] p_parameters used members: R_cyl, L, num_dt_profiles, profile_num_bins_r, profile_num_bins_z,
+ * profile_final_num_bins_r, profile_final_num_bins_z
+ * @param[in,out] p_set 
+ */
+void profiles_register(struct Parameters *p_parameters, struct AnalysisSet *p_set);
+
+#endif /* PROFILES_H_ */
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "analysis.h"
+#include "rdf.h"
+
+static size_t rdf_cell_index(double x, double L, size_t num)
+{
+    long i = (long)floor(x / L * (double)num);
+    if (i < 0)
+        return 0;
+    if ((size_t)i >= num)
+        return num - 1;
+    return (size_t)i;
+}
+
+static double rdf_min_image(double d, double L)
+{
+    return d - L * floor(d / L + 0.5);
+}
+
+static void rdf_bin(struct RdfState *p_state, double r_sq)
+{
+    double r = sqrt(r_sq);
+    if (r < p_state->r_max)
+        p_state->pairs[(size_t)(r / p_state->r_max * (double)p_state->num_bins)] += 2.0;
+}
+
+// Bin all pairs closer than r_max, found in the cell of each particle and 13 of its neighbor cells
+static void rdf_cell_pass(struct RdfState *p_state, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    const int nbr_indcs[13][3] = {{0, 0, 1}, {0, 1, -1}, {0, 1, 0}, {0, 1, 1}, {1, -1, -1}, {1, -1, 0}, {1, -1, 1}, {1, 0, -1}, {1, 0, 0}, {1, 0, 1}, {1, 1, -1}, {1, 1, 0}, {1, 1, 1}};
+    struct Index3D n = p_state->size_grid;
+    struct Vec3D L = p_parameters->L;
+    double r_max_sq = p_state->r_max * p_state->r_max;
+    size_t num_cells = n.i * n.j * n.k;
+    for (size_t c = 0; c < num_cells; ++c)
+        p_state->head[c] = SIZE_MAX;
+    for (size_t i = 0; i < p_snap->num_part; ++i)
+    {
+        size_t c = rdf_cell_index(p_snap->r[i].x, L.x, n.i) +
+                   n.i * (rdf_cell_index(p_snap->r[i].y, L.y, n.j) + n.j * rdf_cell_index(p_snap->r[i].z, L.z, n.k));
+        p_state->list[i] = p_state->head[c];
+        p_state->head[c] = i;
+    }
+    for (size_t c = 0; c < num_cells; ++c)
+    {
+        size_t ci = c % n.i, cj = (c / n.i) % n.j, ck = c / (n.i * n.j);
+        for (size_t i = p_state->head[c]; i != SIZE_MAX; i = p_state->list[i])
+        {
+            struct Vec3D ri = p_snap->r[i];
+            for (int k = -1; k < 13; ++k)
+            {
+                size_t j;
+                if (k < 0) // own cell: the particles after i
+                    j = p_state->list[i];
+                else
+                {
+                    size_t ni = (ci + n.i + nbr_indcs[k][0]) % n.i;
+                    size_t nj = (cj + n.j + nbr_indcs[k][1]) % n.j;
+                    size_t nk = (ck + n.k + nbr_indcs[k][2]) % n.k;
+                    j = p_state->head[ni + n.i * (nj + n.j * nk)];
+                }
+                for (; j != SIZE_MAX; j = p_state->list[j])
+                {
+                    double dx = rdf_min_image(ri.x - p_snap->r[j].x, L.x);
+                    double dy = rdf_min_image(ri.y - p_snap->r[j].y, L.y);
+                    double dz = rdf_min_image(ri.z - p_snap->r[j].z, L.z);
+                    double r_sq = dx * dx + dy * dy + dz * dz;
+                    if (r_sq < r_max_sq)
+                        rdf_bin(p_state, r_sq);
+                }
+            }
+        }
+    }
+}
+
+static void rdf_sample(struct Analysis *p_analysis, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    struct RdfState *p_state = (struct RdfState *)p_analysis->state;
+    struct Index3D n = p_state->size_density;
+    struct Vec3D L = p_parameters->L;
+
+    // local number density of every particle from the coarse density cells
+    size_t num_cells = n.i * n.j * n.k;
+    for (size_t c = 0; c < num_cells; ++c)
+        p_state->density_count[c] = 0;
+    for (int pass = 0; pass < 2; ++pass)
+        for (size_t i = 0; i < p_snap->num_part; ++i)
+        {
+            size_t c = rdf_cell_index(p_snap->r[i].x, L.x, n.i) +
+                       n.i * (rdf_cell_index(p_snap->r[i].y, L.y, n.j) + n.j * rdf_cell_index(p_snap->r[i].z, L.z, n.k));
+            if (pass == 0)
+                p_state->density_count[c]++;
+            else
+                p_state->rho_sum += (double)p_state->density_count[c];
+        }
+
+    if (p_state->use_nbrlist)
+    {
+        for (size_t k = 0; k < p_snap->num_nbrs; ++k)
+            rdf_bin(p_state, p_snap->nbrs[k].rij.sq);
+    }
+    else
+        rdf_cell_pass(p_state, p_parameters, p_snap);
+}
+
+static void rdf_merge(struct Analysis *p_analysis, const struct Analysis *p_other)
+{
+    struct RdfState *p_state = (struct RdfState *)p_analysis->state;
+    const struct RdfState *p_state_other = (const struct RdfState *)p_other->state;
+    for (size_t b = 0; b < p_state->num_bins; ++b)
+        p_state->pairs[b] += p_state_other->pairs[b];
+    p_state->rho_sum += p_state_other->rho_sum;
+}
+
+static void rdf_finish(struct Analysis *p_analysis, struct Parameters *p_parameters)
+{
+    struct RdfState *p_state = (struct RdfState *)p_analysis->state;
+    FILE *fp = fopen("data/rdf.csv", "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Error: cannot open data/rdf.csv for writing\n");
+        return;
+    }
+    double dr = p_state->r_max / (double)p_state->num_bins;
+    double vol_cell = p_state->density_cell.x * p_state->density_cell.y * p_state->density_cell.z;
+    double rho_sum = p_state->rho_sum / vol_cell;
+    fprintf(fp, "r,g\n");
+    for (size_t b = 0; b < p_state->num_bins; ++b)
+    {
+        double r1 = b * dr, r2 = (b + 1) * dr;
+        double vol_shell = (4.0 / 3.0) * PI * (r2 * r2 * r2 - r1 * r1 * r1);
+        fprintf(fp, "%g,%g\n", (b + 0.5) * dr, rho_sum > 0.0 ? p_state->pairs[b] / (rho_sum * vol_shell) : 0.0);
+    }
+    fclose(fp);
+}
+
+static void rdf_free(void *state)
+{
+    struct RdfState *p_state = (struct RdfState *)state;
+    if (p_state == NULL)
+        return;
+    free(p_state->pairs);
+    free(p_state->density_count);
+    free(p_state->head);
+    free(p_state->list);
+    free(p_state);
+}
+
+void rdf_register(struct Parameters *p_parameters, struct AnalysisSet *p_set)
+{
+    if (p_parameters->num_dt_rdf == 0 || p_parameters->rdf_num_bins == 0 || p_parameters->rdf_r_max <= 0.0)
+        return;
+    struct RdfState *p_state = (struct RdfState *)calloc(1, sizeof(struct RdfState));
+    if (p_state == NULL)
+        return;
+    struct Vec3D L = p_parameters->L;
+    p_state->num_bins = p_parameters->rdf_num_bins;
+    p_state->r_max = p_parameters->rdf_r_max;
+    p_state->use_nbrlist = p_state->r_max <= p_parameters->r_cut;
+    double a = p_parameters->rdf_density_cell;
+    p_state->size_density = (struct Index3D){(size_t)fmax(1.0, floor(L.x / a)), (size_t)fmax(1.0, floor(L.y / a)),
+                                             (size_t)fmax(1.0, floor(L.z / a))};
+    p_state->density_cell = (struct Vec3D){L.x / p_state->size_density.i, L.y / p_state->size_density.j,
+                                           L.z / p_state->size_density.k};
+    p_state->pairs = (double *)calloc(p_state->num_bins, sizeof(double));
+    p_state->density_count = (size_t *)malloc(p_state->size_density.i * p_state->size_density.j * p_state->size_density.k *
+                                              sizeof(size_t));
+    bool ok = p_state->pairs != NULL && p_state->density_count != NULL;
+    if (ok && !p_state->use_nbrlist)
+    {
+        p_state->size_grid = (struct Index3D){(size_t)floor(L.x / p_state->r_max), (size_t)floor(L.y / p_state->r_max),
+                                              (size_t)floor(L.z / p_state->r_max)};
+        if (p_state->size_grid.i < 3 || p_state->size_grid.j < 3 || p_state->size_grid.k < 3)
+        {
+            fprintf(stderr, "Warning: radial distribution function off, rdf_r_max exceeds a third of the box\n");
+            rdf_free(p_state);
+            return;
+        }
+        p_state->head = (size_t *)malloc(p_state->size_grid.i * p_state->size_grid.j * p_state->size_grid.k * sizeof(size_t));
+        p_state->list = (size_t *)malloc(p_parameters->num_part * sizeof(size_t));
+        ok = p_state->head != NULL && p_state->list != NULL;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Error: failed to allocate the radial distribution function\n");
+        rdf_free(p_state);
+        return;
+    }
+
+    struct Analysis analysis = {.name = "radial distribution function", .num_dt = p_parameters->num_dt_rdf, .final = false,
+                                .fields = (p_state->use_nbrlist ? SNAPSHOT_FIELD_NBRS : 0u), .contacts = false, .state = p_state,
+                                .sample = rdf_sample, .finish = rdf_finish, .free = rdf_free, .merge = rdf_merge};
+    analysis_add(p_set, &analysis);
+}
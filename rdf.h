@@ -0,0 +1,21 @@
+#ifndef RDF_H_
+#define RDF_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Register the radial distribution function g(r) as an analysis (if num_dt_rdf > 0). Up to r_cut the pairs of
+ * the neighbor list, whose connecting vectors are kept up to date every time step, are binned directly; for a longer
+ * range rdf_r_max the particles are sorted into a cell list with cells of at least rdf_r_max. Because the pile is not
+ * uniform, every particle is compared with its local number density, the number of particles in its cell of edge
+ * rdf_density_cell over the cell volume: g(r) = sum_i n_i(r) / (sum_i rho_i V_shell(r)). Near the free surface the
+ * shells extend into empty space, so g(r) falls below 1 at large r. The average over the samples is written to
+ * data/rdf.csv at the end of the run.
+ * 
+ * @param[in] p_parameters used members: num_dt_rdf, rdf_num_bins, rdf_r_max, rdf_density_cell, r_cut, L, num_part
+ * @param[in,out] p_set 
+ */
+void rdf_register(struct Parameters *p_parameters, struct AnalysisSet *p_set);
+
+#endif /* RDF_H_ */
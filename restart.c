@@ -0,0 +1,496 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "constants.h"
+#include "structs.h"
+#include "memory.h"
+#include "checksum.h"
+#include "restart.h"
+
+// Array to be stored as a section
+struct RestartBlock
+{
+    uint32_t id;
+    uint32_t size_elem;
+    uint64_t num_elem;
+    void *data;
+};
+
+static size_t restart_align(size_t size)
+{
+    return (size + RESTART_ALIGN - 1) / RESTART_ALIGN * RESTART_ALIGN;
+}
+
+static void restart_fill_parameters(struct Parameters *p_parameters, struct RestartParameters *p_rp)
+{
+    memset(p_rp, 0, sizeof(*p_rp));
+    p_rp->num_part = p_parameters->num_part;
+    p_rp->num_walls = p_parameters->num_walls;
+    p_rp->seed = SEED;
+    p_rp->density = p_parameters->density;
+    p_rp->mass_ref = p_parameters->mass_ref;
+    p_rp->R_min = p_parameters->R_min;
+    p_rp->R_max = p_parameters->R_max;
+    p_rp->L[0] = p_parameters->L.x;
+    p_rp->L[1] = p_parameters->L.y;
+    p_rp->L[2] = p_parameters->L.z;
+    p_rp->g[0] = p_parameters->g.x;
+    p_rp->g[1] = p_parameters->g.y;
+    p_rp->g[2] = p_parameters->g.z;
+    p_rp->k_n_pp = p_parameters->k_n_pp;
+    p_rp->eta_n_pp = p_parameters->eta_n_pp;
+    p_rp->k_t_pp = p_parameters->k_t_pp;
+    p_rp->eta_t_pp = p_parameters->eta_t_pp;
+    p_rp->fric_pp = p_parameters->fric_pp;
+    for (unsigned int iw = 0; iw < p_parameters->num_walls && iw < NUM_WALLS_MAX; ++iw)
+    {
+        p_rp->k_n_pw[iw] = p_parameters->k_n_pw[iw];
+        p_rp->eta_n_pw[iw] = p_parameters->eta_n_pw[iw];
+        p_rp->k_t_pw[iw] = p_parameters->k_t_pw[iw];
+        p_rp->eta_t_pw[iw] = p_parameters->eta_t_pw[iw];
+        p_rp->fric_pw[iw] = p_parameters->fric_pw[iw];
+    }
+    p_rp->r_cut = p_parameters->r_cut;
+    p_rp->R_cyl = p_parameters->R_cyl;
+}
+
+// Report the members of the stored parameter block that differ from the current parameters
+static void restart_check_parameters(struct Parameters *p_parameters, const struct RestartParameters *p_stored)
+{
+#define RESTART_PARAMETER(member) {#member, offsetof(struct RestartParameters, member), sizeof(((struct RestartParameters *)0)->member)}
+    static const struct
+    {
+        const char *name;
+        size_t offset, size;
+    } members[] = {RESTART_PARAMETER(num_walls), RESTART_PARAMETER(seed), RESTART_PARAMETER(density),
+                   RESTART_PARAMETER(mass_ref), RESTART_PARAMETER(R_min), RESTART_PARAMETER(R_max),
+                   RESTART_PARAMETER(L), RESTART_PARAMETER(g), RESTART_PARAMETER(k_n_pp),
+                   RESTART_PARAMETER(eta_n_pp), RESTART_PARAMETER(k_t_pp), RESTART_PARAMETER(eta_t_pp),
+                   RESTART_PARAMETER(fric_pp), RESTART_PARAMETER(k_n_pw), RESTART_PARAMETER(eta_n_pw),
+                   RESTART_PARAMETER(k_t_pw), RESTART_PARAMETER(eta_t_pw), RESTART_PARAMETER(fric_pw),
+                   RESTART_PARAMETER(r_cut), RESTART_PARAMETER(R_cyl)};
+#undef RESTART_PARAMETER
+    struct RestartParameters current;
+    restart_fill_parameters(p_parameters, &current);
+    for (size_t k = 0; k < sizeof(members) / sizeof(members[0]); ++k)
+        if (memcmp((const char *)&current + members[k].offset, (const char *)p_stored + members[k].offset, members[k].size) != 0)
+            fprintf(stderr, "Warning: parameter %s differs from the value in the restart file\n", members[k].name);
+}
+
+size_t restart_serialize(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,
+                         struct Colllist *p_colllist, size_t step, struct PhaseState *p_phase_state,
+                         struct FireState *p_fire, struct SteadyState *p_steady, uint64_t key,
+                         char **p_buffer, size_t *p_capacity)
+{
+    struct RestartParameters parameters;
+    restart_fill_parameters(p_parameters, &parameters);
+    struct RestartRunState run;
+    memset(&run, 0, sizeof(run));
+    run.step = step;
+    run.time = p_vectors->time;
+    run.dt = p_parameters->dt;
+    run.r_shell = p_parameters->r_shell;
+    run.damping = p_parameters->damping;
+    run.num_dt_traj = p_parameters->num_dt_traj;
+    run.wall_mask = p_parameters->wall_mask;
+    run.steady_reached = p_steady->reached;
+    run.phase_current = p_phase_state->current;
+    run.phase_step_start = p_phase_state->step_start;
+    run.phase_time_start = p_phase_state->time_start;
+    run.phase_counter = p_phase_state->counter;
+    run.fire_dt_md = p_fire->dt_md;
+    run.fire_alpha = p_fire->alpha;
+    run.fire_n_pos = p_fire->n_pos;
+    run.fire_Ekin_max = p_fire->Ekin_max;
+    run.fire_active = p_fire->active;
+    run.steady_num_samples = p_steady->num_samples;
+
+    size_t num_part = p_parameters->num_part;
+    size_t num_steady = (p_steady->num_samples < p_steady->window ? p_steady->num_samples : p_steady->window);
+    size_t num_w = p_colllist->num_w;
+    struct RestartBlock blocks[] = {
+        {RESTART_SECTION_PARAMETERS, sizeof(parameters), 1, &parameters},
+        {RESTART_SECTION_RUN_STATE, sizeof(run), 1, &run},
+        {RESTART_SECTION_TYPE, sizeof(int), num_part, p_vectors->type},
+        {RESTART_SECTION_RADIUS, sizeof(double), num_part, p_vectors->radius},
+        {RESTART_SECTION_MASS, sizeof(double), num_part, p_vectors->mass},
+        {RESTART_SECTION_R, sizeof(struct Vec3D), num_part, p_vectors->r},
+        {RESTART_SECTION_DR, sizeof(struct Vec3D), num_part, p_vectors->dr},
+        {RESTART_SECTION_V, sizeof(struct Vec3D), num_part, p_vectors->v},
+        {RESTART_SECTION_OMEGA, sizeof(struct Vec3D), num_part, p_vectors->omega},
+        {RESTART_SECTION_F, sizeof(struct Vec3D), num_part, p_vectors->f},
+        {RESTART_SECTION_T, sizeof(struct Vec3D), num_part, p_vectors->T},
+        {RESTART_SECTION_NBR, sizeof(struct Pair), p_nbrlist->num_nbrs, p_nbrlist->nbr},
+        {RESTART_SECTION_NBR_DR, sizeof(struct DeltaR), num_part, p_nbrlist->dr},
+        {RESTART_SECTION_COLL, sizeof(struct Pair), p_colllist->num_nbrs, p_colllist->nbr},
+        {RESTART_SECTION_COLL_TIJ, sizeof(struct DeltaR), p_colllist->num_nbrs, p_colllist->tij},
+        {RESTART_SECTION_WALL_INDCS, sizeof(size_t), num_w, p_colllist->indcs_w},
+        {RESTART_SECTION_WALL_ID, sizeof(unsigned int), num_w, p_colllist->wall_id},
+        {RESTART_SECTION_WALL_RIW, sizeof(struct DeltaR), num_w, p_colllist->riw},
+        {RESTART_SECTION_WALL_TIW, sizeof(struct DeltaR), num_w, p_colllist->tiw},
+        {RESTART_SECTION_WALL_VW, sizeof(struct Vec3D), num_w, p_colllist->vw},
+        {RESTART_SECTION_STEADY_EKIN, sizeof(double), num_steady, p_steady->Ekin},
+        {RESTART_SECTION_STEADY_V_MAX, sizeof(double), num_steady, p_steady->v_max},
+        {RESTART_SECTION_STEADY_H_MAX, sizeof(double), num_steady, p_steady->h_max},
+        {RESTART_SECTION_STEADY_R_BASE, sizeof(double), num_steady, p_steady->R_base},
+        {RESTART_SECTION_IMAGE, sizeof(struct Image3D), num_part, p_vectors->image}};
+    const size_t num_sections = sizeof(blocks) / sizeof(blocks[0]);
+
+    // layout: header, section table, sections aligned to RESTART_ALIGN
+    struct RestartSection table[sizeof(blocks) / sizeof(blocks[0])];
+    size_t offset = restart_align(sizeof(struct RestartHeader) + sizeof(table));
+    for (size_t k = 0; k < num_sections; ++k)
+    {
+        size_t size = blocks[k].size_elem * blocks[k].num_elem;
+        table[k] = (struct RestartSection){blocks[k].id, blocks[k].size_elem, blocks[k].num_elem, offset, 0};
+        offset = restart_align(offset + size);
+    }
+    size_t size_file = offset;
+
+    if (*p_capacity < size_file)
+    {
+        *p_buffer = (char *)realloc(*p_buffer, size_file);
+        *p_capacity = size_file;
+    }
+    char *buffer = *p_buffer;
+    memset(buffer, 0, size_file); // padding is written as zeros
+
+    struct RestartHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RESTART_MAGIC, sizeof(RESTART_MAGIC));
+    header.version = RESTART_VERSION;
+    header.size_header = sizeof(header);
+    header.endian_tag = RESTART_ENDIAN_TAG;
+    header.num_sections = (uint32_t)num_sections;
+    header.size_file = size_file;
+    header.key = key;
+    memcpy(buffer, &header, sizeof(header));
+    memcpy(buffer + sizeof(header), table, sizeof(table));
+    for (size_t k = 0; k < num_sections; ++k)
+        if (table[k].num_elem > 0)
+            memcpy(buffer + table[k].offset, blocks[k].data, blocks[k].size_elem * blocks[k].num_elem);
+    return size_file;
+}
+
+void restart_seal(char *buffer)
+{
+    struct RestartHeader *p_header = (struct RestartHeader *)buffer;
+    struct RestartSection *table = (struct RestartSection *)(buffer + sizeof(struct RestartHeader));
+    for (size_t k = 0; k < p_header->num_sections; ++k)
+        table[k].checksum = fnv1a_64(FNV1A_64_OFFSET, buffer + table[k].offset, table[k].size_elem * table[k].num_elem);
+    p_header->checksum = fnv1a_64(FNV1A_64_OFFSET, table, p_header->num_sections * sizeof(struct RestartSection));
+}
+
+// Flush a file to the disk
+static int restart_fsync(FILE *p_file)
+{
+#ifdef _WIN32
+    return _commit(_fileno(p_file));
+#else
+    return fsync(fileno(p_file));
+#endif
+}
+
+// Replace filename by filename_tmp in a single step
+static int restart_replace(const char *filename_tmp, const char *filename)
+{
+#ifdef _WIN32
+    return MoveFileExA(filename_tmp, filename, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+#else
+    return rename(filename_tmp, filename);
+#endif
+}
+
+bool restart_write_file(const char *filename, const char *buffer, size_t size)
+{
+    char filename_tmp[1100];
+    snprintf(filename_tmp, sizeof(filename_tmp), "%s.tmp", filename);
+    FILE *p_file = fopen(filename_tmp, "wb");
+    if (p_file == NULL)
+    {
+        fprintf(stderr, "Error: cannot open %s for writing\n", filename_tmp);
+        return false;
+    }
+    bool ok = fwrite(buffer, 1, size, p_file) == size;
+    ok = ok && fflush(p_file) == 0 && restart_fsync(p_file) == 0;
+    ok = (fclose(p_file) == 0) && ok;
+    if (!ok || restart_replace(filename_tmp, filename) != 0)
+    {
+        fprintf(stderr, "Error: writing %s failed\n", filename);
+        remove(filename_tmp);
+        return false;
+    }
+    return true;
+}
+
+// Find section id in the table; returns NULL if it is missing or its element size does not match
+static const struct RestartSection *restart_find(const struct RestartSection *table, size_t num_sections,
+                                                 uint32_t id, size_t size_elem)
+{
+    for (size_t k = 0; k < num_sections; ++k)
+        if (table[k].id == id)
+            return (table[k].size_elem == size_elem ? &table[k] : NULL);
+    return NULL;
+}
+
+// Copy the data of section id to dest
+static void restart_copy(const char *image, const struct RestartSection *table, size_t num_sections,
+                           uint32_t id, size_t size_elem, void *dest)
+{
+    const struct RestartSection *p_section = restart_find(table, num_sections, id, size_elem);
+    if (p_section != NULL && p_section->num_elem > 0)
+        memcpy(dest, image + p_section->offset, p_section->num_elem * size_elem);
+}
+
+// Read a file and verify its header, section table and checksums. Returns the image or NULL.
+static char *restart_read_image(const char *filename, uint64_t key, bool verbose)
+{
+    FILE *p_file = fopen(filename, "rb");
+    if (p_file == NULL)
+    {
+        if (verbose)
+            fprintf(stderr, "Error: cannot open restart file %s\n", filename);
+        return NULL;
+    }
+    // the length of the file bounds the size stated in the header
+    long length_file = -1;
+    if (fseek(p_file, 0, SEEK_END) == 0)
+        length_file = ftell(p_file);
+    rewind(p_file);
+    struct RestartHeader header;
+    char *image = NULL;
+    const char *error = NULL;
+    if (length_file < 0)
+        error = "cannot determine the file length";
+    else if (fread(&header, sizeof(header), 1, p_file) != 1 || memcmp(header.magic, RESTART_MAGIC, sizeof(RESTART_MAGIC)) != 0)
+        error = "not a restart file of this format";
+    else if (header.endian_tag != RESTART_ENDIAN_TAG)
+        error = "written with a different byte order";
+    else if (header.version != RESTART_VERSION || header.size_header != sizeof(header))
+        error = "unsupported version";
+    else if (header.key != key)
+        error = "key does not match";
+    else if (header.size_file < sizeof(header) + header.num_sections * sizeof(struct RestartSection))
+        error = "corrupt header";
+    else if (header.size_file != (uint64_t)length_file)
+        error = "size in the header does not match the file length";
+    else if ((image = (char *)malloc(header.size_file)) == NULL)
+        error = "cannot allocate memory for the file";
+    else
+    {
+        rewind(p_file);
+        if (fread(image, 1, header.size_file, p_file) != header.size_file)
+            error = "file is truncated";
+    }
+    fclose(p_file);
+
+    if (error == NULL)
+    {
+        const struct RestartSection *table = (const struct RestartSection *)(image + sizeof(header));
+        if (fnv1a_64(FNV1A_64_OFFSET, table, header.num_sections * sizeof(struct RestartSection)) != header.checksum)
+            error = "section table checksum mismatch";
+        for (size_t k = 0; k < header.num_sections && error == NULL; ++k)
+        {
+            uint64_t size = table[k].size_elem * table[k].num_elem;
+            if (table[k].offset > header.size_file || size > header.size_file - table[k].offset)
+                error = "section out of bounds";
+            else if (fnv1a_64(FNV1A_64_OFFSET, image + table[k].offset, size) != table[k].checksum)
+                error = "section checksum mismatch";
+        }
+    }
+    if (error != NULL)
+    {
+        fprintf(stderr, "Error: restart file %s: %s\n", filename, error);
+        free(image);
+        return NULL;
+    }
+    return image;
+}
+
+bool restart_load_file(const char *filename, uint64_t key, struct Parameters *p_parameters, struct Vectors *p_vectors,
+                       struct Nbrlist *p_nbrlist, struct Colllist *p_colllist, size_t *p_step,
+                       struct PhaseState *p_phase_state, struct FireState *p_fire, struct SteadyState *p_steady,
+                       bool verbose)
+{
+    char *image = restart_read_image(filename, key, verbose);
+    if (image == NULL)
+        return false;
+    const struct RestartHeader *p_header = (const struct RestartHeader *)image;
+    const struct RestartSection *table = (const struct RestartSection *)(image + sizeof(struct RestartHeader));
+    size_t num_sections = p_header->num_sections;
+
+    const struct RestartSection *p_par = restart_find(table, num_sections, RESTART_SECTION_PARAMETERS, sizeof(struct RestartParameters));
+    const struct RestartSection *p_run = restart_find(table, num_sections, RESTART_SECTION_RUN_STATE, sizeof(struct RestartRunState));
+    const struct RestartSection *p_nbr = restart_find(table, num_sections, RESTART_SECTION_NBR, sizeof(struct Pair));
+    const struct RestartSection *p_coll = restart_find(table, num_sections, RESTART_SECTION_COLL, sizeof(struct Pair));
+    const struct RestartSection *p_wall = restart_find(table, num_sections, RESTART_SECTION_WALL_INDCS, sizeof(size_t));
+    if (p_par == NULL || p_run == NULL || p_nbr == NULL || p_coll == NULL || p_wall == NULL)
+    {
+        fprintf(stderr, "Error: restart file %s: missing sections\n", filename);
+        free(image);
+        return false;
+    }
+    const struct RestartParameters *p_stored = (const struct RestartParameters *)(image + p_par->offset);
+    const struct RestartRunState *p_run_state = (const struct RestartRunState *)(image + p_run->offset);
+
+    if (p_stored->num_part != p_parameters->num_part)
+    {
+        fprintf(stderr, "Warning: restart file %s contains %lu particles instead of %lu\n", filename,
+                (long unsigned)p_stored->num_part, (long unsigned)p_parameters->num_part);
+        free_memory(p_vectors, p_nbrlist, p_colllist);
+        p_parameters->num_part = p_stored->num_part;
+        alloc_memory(p_parameters, p_vectors, p_nbrlist, p_colllist);
+    }
+    restart_check_parameters(p_parameters, p_stored);
+    size_t num_part = p_parameters->num_part;
+
+    // reserve room for the lists before copying
+    size_t num_nbrs = p_nbr->num_elem, num_coll = p_coll->num_elem, num_w = p_wall->num_elem;
+    if (num_nbrs > p_nbrlist->num_nbrs_max)
+    {
+        p_nbrlist->num_nbrs_max = num_nbrs;
+        p_nbrlist->nbr = (struct Pair *)realloc(p_nbrlist->nbr, num_nbrs * sizeof(struct Pair));
+        p_nbrlist->nbr_tmp = (struct Pair *)realloc(p_nbrlist->nbr_tmp, num_nbrs * sizeof(struct Pair));
+    }
+    p_colllist->nbr = (struct Pair *)realloc(p_colllist->nbr, num_coll * sizeof(struct Pair));
+    p_colllist->tij = (struct DeltaR *)realloc(p_colllist->tij, num_coll * sizeof(struct DeltaR));
+    p_colllist->fn_sq = (double *)realloc(p_colllist->fn_sq, num_coll * sizeof(double));
+    p_colllist->ft_sq = (double *)realloc(p_colllist->ft_sq, num_coll * sizeof(double));
+    memset(p_colllist->fn_sq, 0, num_coll * sizeof(double)); // contact forces are recomputed in the next time step
+    memset(p_colllist->ft_sq, 0, num_coll * sizeof(double));
+    p_colllist->fij = (struct Vec3D *)realloc(p_colllist->fij, num_coll * sizeof(struct Vec3D));
+    memset(p_colllist->fij, 0, num_coll * sizeof(struct Vec3D));
+    if (num_w > p_colllist->num_w_max)
+    {
+        size_t num_w_max = num_w;
+        p_colllist->num_w_max = num_w_max;
+        p_colllist->indcs_w = (size_t *)realloc(p_colllist->indcs_w, num_w_max * sizeof(size_t));
+        p_colllist->indcs_w_tmp = (size_t *)realloc(p_colllist->indcs_w_tmp, num_w_max * sizeof(size_t));
+        p_colllist->wall_id = (unsigned int *)realloc(p_colllist->wall_id, num_w_max * sizeof(unsigned int));
+        p_colllist->wall_id_tmp = (unsigned int *)realloc(p_colllist->wall_id_tmp, num_w_max * sizeof(unsigned int));
+        p_colllist->riw = (struct DeltaR *)realloc(p_colllist->riw, num_w_max * sizeof(struct DeltaR));
+        p_colllist->tiw = (struct DeltaR *)realloc(p_colllist->tiw, num_w_max * sizeof(struct DeltaR));
+        p_colllist->tiw_tmp = (struct DeltaR *)realloc(p_colllist->tiw_tmp, num_w_max * sizeof(struct DeltaR));
+        p_colllist->vw = (struct Vec3D *)realloc(p_colllist->vw, num_w_max * sizeof(struct Vec3D));
+    }
+
+    struct
+    {
+        uint32_t id;
+        size_t size_elem, num_elem;
+        void *dest;
+    } copies[] = {
+        {RESTART_SECTION_TYPE, sizeof(int), num_part, p_vectors->type},
+        {RESTART_SECTION_RADIUS, sizeof(double), num_part, p_vectors->radius},
+        {RESTART_SECTION_MASS, sizeof(double), num_part, p_vectors->mass},
+        {RESTART_SECTION_R, sizeof(struct Vec3D), num_part, p_vectors->r},
+        {RESTART_SECTION_DR, sizeof(struct Vec3D), num_part, p_vectors->dr},
+        {RESTART_SECTION_V, sizeof(struct Vec3D), num_part, p_vectors->v},
+        {RESTART_SECTION_OMEGA, sizeof(struct Vec3D), num_part, p_vectors->omega},
+        {RESTART_SECTION_F, sizeof(struct Vec3D), num_part, p_vectors->f},
+        {RESTART_SECTION_T, sizeof(struct Vec3D), num_part, p_vectors->T},
+        {RESTART_SECTION_NBR, sizeof(struct Pair), num_nbrs, p_nbrlist->nbr},
+        {RESTART_SECTION_NBR_DR, sizeof(struct DeltaR), num_part, p_nbrlist->dr},
+        {RESTART_SECTION_COLL, sizeof(struct Pair), num_coll, p_colllist->nbr},
+        {RESTART_SECTION_COLL_TIJ, sizeof(struct DeltaR), num_coll, p_colllist->tij},
+        {RESTART_SECTION_WALL_INDCS, sizeof(size_t), num_w, p_colllist->indcs_w},
+        {RESTART_SECTION_WALL_ID, sizeof(unsigned int), num_w, p_colllist->wall_id},
+        {RESTART_SECTION_WALL_RIW, sizeof(struct DeltaR), num_w, p_colllist->riw},
+        {RESTART_SECTION_WALL_TIW, sizeof(struct DeltaR), num_w, p_colllist->tiw},
+        {RESTART_SECTION_WALL_VW, sizeof(struct Vec3D), num_w, p_colllist->vw}};
+    for (size_t k = 0; k < sizeof(copies) / sizeof(copies[0]); ++k)
+    {
+        const struct RestartSection *p_section = restart_find(table, num_sections, copies[k].id, copies[k].size_elem);
+        if (p_section == NULL || p_section->num_elem != copies[k].num_elem)
+        {
+            fprintf(stderr, "Error: restart file %s: section %u is missing or has the wrong size\n", filename, copies[k].id);
+            free(image);
+            return false;
+        }
+        restart_copy(image, table, num_sections, copies[k].id, copies[k].size_elem, copies[k].dest);
+    }
+    p_nbrlist->num_nbrs = num_nbrs;
+    p_colllist->num_nbrs = num_coll;
+    p_colllist->num_w = num_w;
+
+    // periodic images are missing in files of earlier versions
+    const struct RestartSection *p_image = restart_find(table, num_sections, RESTART_SECTION_IMAGE, sizeof(struct Image3D));
+    if (p_image != NULL && p_image->num_elem == num_part)
+        restart_copy(image, table, num_sections, RESTART_SECTION_IMAGE, sizeof(struct Image3D), p_vectors->image);
+    else
+    {
+        memset(p_vectors->image, 0, num_part * sizeof(struct Image3D));
+        fprintf(stderr, "Warning: periodic images of restart file %s not restored\n", filename);
+    }
+
+    *p_step = p_run_state->step;
+    p_vectors->time = p_run_state->time;
+    p_parameters->dt = p_run_state->dt;
+    p_parameters->r_shell = p_run_state->r_shell;
+    p_parameters->damping = p_run_state->damping;
+    p_parameters->num_dt_traj = p_run_state->num_dt_traj;
+    p_parameters->wall_mask = p_run_state->wall_mask;
+    *p_phase_state = (struct PhaseState){p_run_state->phase_current, p_run_state->phase_step_start,
+                                         p_run_state->phase_time_start, p_run_state->phase_counter};
+    if (p_parameters->num_phases > 0 && p_phase_state->current >= p_parameters->num_phases)
+    {
+        fprintf(stderr, "Warning: restart file %s is in phase %lu, continuing in the last phase\n", filename,
+                (long unsigned)p_phase_state->current);
+        p_phase_state->current = p_parameters->num_phases - 1;
+    }
+    *p_fire = (struct FireState){p_run_state->fire_dt_md, p_run_state->fire_alpha, p_run_state->fire_n_pos,
+                                 p_run_state->fire_Ekin_max, p_run_state->fire_active != 0};
+
+    // the steady-state window is only restored if it has the same length
+    size_t num_steady = (p_run_state->steady_num_samples < p_steady->window ? p_run_state->steady_num_samples : p_steady->window);
+    const struct RestartSection *p_steady_ekin = restart_find(table, num_sections, RESTART_SECTION_STEADY_EKIN, sizeof(double));
+    p_steady->num_samples = 0;
+    if (p_steady_ekin != NULL && p_steady_ekin->num_elem == num_steady)
+    {
+        restart_copy(image, table, num_sections, RESTART_SECTION_STEADY_EKIN, sizeof(double), p_steady->Ekin);
+        restart_copy(image, table, num_sections, RESTART_SECTION_STEADY_V_MAX, sizeof(double), p_steady->v_max);
+        restart_copy(image, table, num_sections, RESTART_SECTION_STEADY_H_MAX, sizeof(double), p_steady->h_max);
+        restart_copy(image, table, num_sections, RESTART_SECTION_STEADY_R_BASE, sizeof(double), p_steady->R_base);
+        p_steady->num_samples = p_run_state->steady_num_samples;
+        p_steady->reached = p_run_state->steady_reached;
+    }
+    else
+        fprintf(stderr, "Warning: steady-state window of restart file %s not restored\n", filename);
+
+    free(image);
+    return true;
+}
+
+void save_restart(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,
+                  struct Colllist *p_colllist, size_t step, struct PhaseState *p_phase_state,
+                  struct FireState *p_fire, struct SteadyState *p_steady)
+{
+    char *buffer = NULL;
+    size_t capacity = 0;
+    size_t size = restart_serialize(p_parameters, p_vectors, p_nbrlist, p_colllist, step, p_phase_state, p_fire,
+                                    p_steady, 0, &buffer, &capacity);
+    restart_seal(buffer);
+    restart_write_file(p_parameters->restart_out_filename, buffer, size);
+    free(buffer);
+}
+
+bool load_restart(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,
+                  struct Colllist *p_colllist, size_t *p_step, struct PhaseState *p_phase_state,
+                  struct FireState *p_fire, struct SteadyState *p_steady)
+{
+    bool ok = restart_load_file(p_parameters->restart_in_filename, 0, p_parameters, p_vectors, p_nbrlist, p_colllist,
+                                p_step, p_phase_state, p_fire, p_steady, true);
+    if (ok)
+        printf("Loaded restart file %s (step %lu, time %g)\n", p_parameters->restart_in_filename,
+               (long unsigned)*p_step, p_vectors->time);
+    return ok;
+}
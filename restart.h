@@ -0,0 +1,93 @@
+#ifndef RESTART_H_
+#define RESTART_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Serialize the complete state of a run into a restart image in memory: parameter block, run state,
+ * particle arrays, neighbor list and collision list (including the tangential displacements tij and tiw)
+ * and the steady-state window. A run continued from this image is bitwise identical to a run that never stopped.
+ * The checksums are left empty, so that the copy made inside the time loop is as short as possible;
+ * they are filled in by @ref restart_seal.
+ * 
+ * @param[in] p_parameters 
+ * @param[in] p_vectors 
+ * @param[in] p_nbrlist 
+ * @param[in] p_colllist 
+ * @param[in] step current time step
+ * @param[in] p_phase_state 
+ * @param[in] p_fire 
+ * @param[in] p_steady 
+ * @param[in] key user key stored in the header, 0 for normal restart files
+ * @param[in,out] p_buffer buffer for the image, grown with realloc when needed (may point to NULL)
+ * @param[in,out] p_capacity allocated size of *p_buffer
+ * @return size_t size of the image in bytes
+ */
+size_t restart_serialize(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,
+                         struct Colllist *p_colllist, size_t step, struct PhaseState *p_phase_state,
+                         struct FireState *p_fire, struct SteadyState *p_steady, uint64_t key,
+                         char **p_buffer, size_t *p_capacity);
+
+/**
+ * @brief Compute the checksums of the sections and of the section table of a restart image
+ * 
+ * @param[in,out] buffer restart image made by @ref restart_serialize
+ */
+void restart_seal(char *buffer);
+
+/**
+ * @brief Write a restart image to a file. The image is written under a temporary name, flushed to disk and
+ * then atomically replaces the file, so a crash never leaves a truncated or missing restart file.
+ * 
+ * @param[in] filename 
+ * @param[in] buffer restart image, see @ref restart_serialize
+ * @param[in] size size of the image in bytes
+ * @return bool true if successful
+ */
+bool restart_write_file(const char *filename, const char *buffer, size_t size);
+
+/**
+ * @brief Load the complete state of a run from a restart file written by @ref restart_write_file.
+ * The header, the section table and the checksums of all sections are verified. Differences between
+ * the stored parameter block and the current parameters are reported as warnings.
+ * 
+ * @param[in] filename 
+ * @param[in] key expected user key, see @ref restart_serialize
+ * @param[in,out] p_parameters set members: num_part (if different), dt, r_shell, damping, num_dt_traj, wall_mask
+ * @param[out] p_vectors 
+ * @param[out] p_nbrlist 
+ * @param[out] p_colllist 
+ * @param[out] p_step time step
+ * @param[out] p_phase_state 
+ * @param[out] p_fire 
+ * @param[in,out] p_steady initialized with @ref steady_state_init
+ * @param[in] verbose if false a missing file is not reported
+ * @return bool true if the state was loaded
+ */
+bool restart_load_file(const char *filename, uint64_t key, struct Parameters *p_parameters, struct Vectors *p_vectors,
+                       struct Nbrlist *p_nbrlist, struct Colllist *p_colllist, size_t *p_step,
+                       struct PhaseState *p_phase_state, struct FireState *p_fire, struct SteadyState *p_steady,
+                       bool verbose);
+
+/**
+ * @brief Save the state of the run to the restart file p_parameters->restart_out_filename
+ * 
+ * @see restart_serialize
+ */
+void save_restart(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,
+                  struct Colllist *p_colllist, size_t step, struct PhaseState *p_phase_state,
+                  struct FireState *p_fire, struct SteadyState *p_steady);
+
+/**
+ * @brief Load the state of the run from the restart file p_parameters->restart_in_filename
+ * 
+ * @see restart_load_file
+ * @return bool true if the state was loaded
+ */
+bool load_restart(struct Parameters *p_parameters, struct Vectors *p_vectors, struct Nbrlist *p_nbrlist,
+                  struct Colllist *p_colllist, size_t *p_step, struct PhaseState *p_phase_state,
+                  struct FireState *p_fire, struct SteadyState *p_steady);
+
+#endif /* RESTART_H_ */
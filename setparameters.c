@@ -5,6 +5,18 @@
 #include "constants.h"
 #include "structs.h"
 #include "walls.h"
+#include "setparameters.h"
+
+void set_wall_coefficients(struct Parameters *p_parameters, unsigned int i, double e_n, double e_t, double muf)
+{
+  double mass_ref = p_parameters->mass_ref;
+  double tcontact = p_parameters->t_contact;
+  p_parameters->k_n_pw[i] = mass_ref * (PI * PI + pow(log(e_n), 2)) / (tcontact * tcontact);               //normal elastic spring constant for particle-wall interactions
+  p_parameters->eta_n_pw[i] = -2.0 * log(e_n) * (mass_ref) / tcontact;                                     //normal dashpot damping coeff. for particle-wall interactions
+  p_parameters->k_t_pw[i] = (2.0 * mass_ref / 7.0) * (PI * PI + pow(log(e_t), 2)) / (tcontact * tcontact); //tangential elastic spring constant for particle-wall interactions
+  p_parameters->eta_t_pw[i] = -2.0 * log(e_t) * (2.0 * mass_ref / 7.0) / tcontact;                         //tangential dashpot damping coeff. for particle-wall interactions
+  p_parameters->fric_pw[i] = muf;
+}
 
 void set_parameters(struct Parameters *p_parameters)
 /* Set the parameters of this simulation */
@@ -36,10 +48,38 @@ void set_parameters(struct Parameters *p_parameters)
   p_parameters->num_dt_printf = 100;          // number of time steps between prints to screen
   p_parameters->num_dt_traj = 50;           //number of time steps between saves
   strcpy(p_parameters->filename_xyz, "trajectories");  //filename (without extension) for pdb file
+  p_parameters->traj_format = TRAJ_FORMAT_BINARY;      // trajectories.pbt; TRAJ_FORMAT_XYZ for trajectories.xyz; TRAJ_FORMAT_VTU for trajectories.pvd
+  p_parameters->vtk_contacts = true;                   // VTU frames: also write the contact network (trajectories_contacts.pvd)
+  p_parameters->traj_fields = TRAJ_FIELD_POSITION | TRAJ_FIELD_RADIUS | TRAJ_FIELD_VELOCITY; // fields in binary frames
+  p_parameters->traj_single_precision = true;          // store floats in binary frames
+  p_parameters->traj_delta = false;                    // true: keyframes plus delta frames holding only the positions of the particles that moved
+  p_parameters->traj_num_frames_key = 100;             // a keyframe with all particles every 100 frames
+  p_parameters->traj_delta_tol = 0.01 * R_min;         // position tolerance of delta frames
+  strcpy(p_parameters->filename_archive, "data/archive"); // compressed snapshots data/archive_<step>.pba and data/archive_final.pba
+  p_parameters->num_dt_archive = 0;                    // 0: archive only the final state
+  p_parameters->archive_fields = TRAJ_FIELD_POSITION | TRAJ_FIELD_RADIUS | TRAJ_FIELD_VELOCITY; // fields in archives
+  p_parameters->archive_cell = 20.0 * R_max;           // particles are grouped into chunks of cells of this size
+  p_parameters->archive_tol_r = 1e-3 * R_min;          // tolerance of archived positions and radii
+  p_parameters->archive_tol_v = 1e-4;                  // tolerance of archived velocities (m/s)
+  p_parameters->archive_tol_omega = 1e-2;              // tolerance of archived angular velocities (rad/s)
+  p_parameters->archive_tol_f = 1e-7;                  // tolerance of archived forces (N)
+  p_parameters->traj_adaptive = false;                 // frames every num_dt_traj steps; true: spacing follows the particle motion
+  p_parameters->traj_num_dt_min = 5;                   // minimum number of time steps between adaptive frames
+  p_parameters->traj_num_dt_max = 1000;                // maximum number of time steps between adaptive frames (pile at rest)
+  p_parameters->traj_disp = 0.2 * R_min;               // displacement of the fastest particle between adaptive frames
+  p_parameters->num_dt_profiles = 50;                  // samples of the averaged profiles data/dens_radial_avg.csv and data/dens_axial_avg.csv
+  p_parameters->profile_num_bins_r = 50;               // radial bins (0..R_cyl) of the averaged profiles
+  p_parameters->profile_num_bins_z = 50;               // axial bins (0..L.z) of the averaged profiles
+  p_parameters->profile_final_num_bins_r = 25;         // radial bins of the final profiles data/dens_radial.csv and data/dens_radial_center.csv
+  p_parameters->profile_final_num_bins_z = 25;         // axial bins of the final profile data/dens_axial.csv
   p_parameters->load_restart = 0;                      //if equal 1 restart file is loaded
   strcpy(p_parameters->restart_in_filename, "restart.dat");  //filename for loaded restart file
   p_parameters->num_dt_restart = 10000;                      // number of time steps between saves
   strcpy(p_parameters->restart_out_filename, "restart.dat"); //filename for saved restart file
+  p_parameters->restart_async = true;                        // write restart files in the background while stepping continues
+  p_parameters->output_async = true;                         // write trajectories, profile samples and status lines in the background
+  p_parameters->output_num_slots = 8;                        // number of snapshot buffers of the output pipeline
+  p_parameters->output_backpressure = OUTPUT_BACKPRESSURE_BLOCK; // OUTPUT_BACKPRESSURE_DROP drops (and counts) frames, archives and status lines when all buffers are in use
 
   double mass_ref = p_parameters->density * (4.0 / 3.0) * PI * R_min * R_min * R_min; //mass_ref of a particle (later coefficients are corrected for real particle mass)
   double tcontact = sqrt(0.5 * mass_ref * (PI * PI + pow(log(e_n_pp), 2)) / kn); //computed contact time
@@ -48,15 +88,10 @@ void set_parameters(struct Parameters *p_parameters)
   p_parameters->k_t_pp = (mass_ref / 7.0) * (PI * PI + pow(log(e_t_pp), 2)) / (tcontact * tcontact); //tangential elastic spring constant for particle-particle interactions
   p_parameters->eta_t_pp = -2.0 * log(e_t_pp) * (mass_ref / 7.0) / tcontact;     //tangential dashpot damping coeff. for particle-particle interactions
   p_parameters->fric_pp = muf;                                                   //friction coefficient for particle-particle interactions
-  for(int i=0; i< p_parameters->num_walls; ++i)
-  {
-    p_parameters->k_n_pw[i] = mass_ref * (PI * PI + pow(log(e_n_pw[i]), 2)) / (tcontact * tcontact);               //normal elastic spring constant for particle-wall interactions
-    p_parameters->eta_n_pw[i] = -2.0 * log(e_n_pw[i]) * (mass_ref) / tcontact;                                     //normal dashpot damping coeff. for particle-wall interactions
-    p_parameters->k_t_pw[i] = (2.0 * mass_ref / 7.0) * (PI * PI + pow(log(e_t_pw[i]), 2)) / (tcontact * tcontact); //tangential elastic spring constant for particle-wall interactions
-    p_parameters->eta_t_pw[i] = -2.0 * log(e_t_pw[i]) * (2.0 * mass_ref / 7.0) / tcontact;                         //tangential dashpot damping coeff. for particle-wall interactions
-    p_parameters->fric_pw[i] = muf_w[i];
-  }
   p_parameters->mass_ref = mass_ref; //mass_ref of a particle (later coefficients are corrected for real particle mass)
+  p_parameters->t_contact = tcontact;
+  for(int i=0; i< p_parameters->num_walls; ++i)
+    set_wall_coefficients(p_parameters, i, e_n_pw[i], e_t_pw[i], muf_w[i]);
                                                                        
   double v_small = 1e-2 * R_max/tcontact;          //a velocity scale
   p_parameters->Tg = 0.5 * mass_ref * v_small * v_small; //here Tg denotes the granular temperature, an average kinetic energy used for initialization
@@ -78,12 +113,84 @@ void set_parameters(struct Parameters *p_parameters)
   p_parameters->L.x = 10.0 * p_parameters->R_cyl;       // box length in x direction
   p_parameters->L.y = 10.0 * p_parameters->R_cyl;       // box length in y direction
   p_parameters->L.z = p_parameters->H_R_ratio * p_parameters->R_cyl * 10.0;     // height of cylindrical wall
+  p_parameters->init_positions = INIT_POSITIONS_LATTICE; // settled by dynamics to phi ~0.63; INIT_POSITIONS_DEPOSITION: no overlaps, but phi ~0.57
 
-  // Collapse / wall removal defaults
-  p_parameters->collapse_start_step = 10000;// change as needed (when to remove cylinder)
-  p_parameters->cyl_wall_index = 2;         // index used above for cylindrical_wall
-  p_parameters->settle_pers_steps = 10;     // number of consecutive steps below kinetic energy tolerance before wall removal
-  p_parameters->Ekin_tol = 1;               // kinetic energy per particle tolerance for settling
+  // Coarse-grained fields (data/cg_fields.csv every num_dt_cg steps, time average in data/cg_fields_avg.csv)
+  p_parameters->num_dt_cg = 0;                                 // 0: off, e.g. 500 during collapse runs
+  p_parameters->cg_grid = CG_GRID_RZ;                          // CG_GRID_XYZ for a 3D grid over cg_lo..cg_hi
+  p_parameters->cg_size = (struct Index3D){60, 1, 24};         // grid nodes (RZ: radial, -, axial)
+  p_parameters->cg_r_max = 3.0 * p_parameters->R_cyl;          // radial extent of the RZ grid
+  p_parameters->cg_lo = (struct Vec3D){0.0, 0.0, 0.0};         // lower corner of the grid region
+  p_parameters->cg_hi = (struct Vec3D){p_parameters->L.x, p_parameters->L.y, 2.0 * p_parameters->H_R_ratio * p_parameters->R_cyl}; // upper corner
+  p_parameters->cg_width = 4.0 * R_max;                        // cutoff radius of the smoothing kernel, at least the node spacing
+
+  // Phases: settling inside the cylinder, early spreading after wall removal, late runout
+  unsigned int walls_all = WALL_BIT(0) | WALL_BIT(1) | WALL_BIT(2);
+  unsigned int walls_collapse = WALL_BIT(0) | WALL_BIT(1);  // cylindrical wall (2) removed
+  p_parameters->num_phases = 3;
+  p_parameters->phases[0] = (struct Phase){"settle", PHASE_TRIGGER_STEP, 10000, 0,
+                                           250, p_parameters->r_shell, 0.0, walls_all, false, INTEGRATOR_VERLET};
+  p_parameters->phases[1] = (struct Phase){"spread", PHASE_TRIGGER_STEP, 2500, 0,
+                                           10, p_parameters->r_shell, 0.0, walls_collapse, false, INTEGRATOR_VERLET};
+  p_parameters->phases[2] = (struct Phase){"runout", PHASE_TRIGGER_NONE, 0, 0,
+                                           50, p_parameters->r_shell, 0.0, walls_collapse, true, INTEGRATOR_VERLET};
+  // Alternative settle trigger: end when Ekin per particle < 1e-7 for 10 consecutive steps
+  // p_parameters->phases[0].trigger = PHASE_TRIGGER_EKIN;
+  // p_parameters->phases[0].trigger_value = 1e-7;
+  // p_parameters->phases[0].trigger_pers_steps = 10;
+  // Alternative settling by energy minimization: compact by dynamics, then relax with FIRE until no net force
+  // exceeds 2% of a particle weight for 100 steps (static after ~10k instead of ~28k steps, same packing fraction)
+  // p_parameters->phases[0].integrator = INTEGRATOR_FIRE;
+  // p_parameters->phases[0].trigger = PHASE_TRIGGER_FORCE;
+  // p_parameters->phases[0].trigger_value = 0.02;
+  // p_parameters->phases[0].trigger_pers_steps = 100;
+  p_parameters->wall_mask = WALL_MASK_ALL;  // overwritten by phases_init
+  p_parameters->damping = 0.0;              // overwritten by phases_init
   p_parameters->reset_final_pile = false;   // characterize final pile after collapse
+  p_parameters->num_dt_heightmap = 50;      // surface height map: data/runout.csv and data/surface_profile.csv
+  p_parameters->hm_cell = 2.0 * R_max;      // columns of one particle diameter
+  p_parameters->hm_coverage = 0.5;          // runout: outermost radial bin (from the axis on) with half its columns covered
+  p_parameters->hm_fit_lo = 0.2;            // slope fitted to the surface between 20% ...
+  p_parameters->hm_fit_hi = 0.8;            // ... and 80% of the peak height
+  p_parameters->num_dt_stress = 100;        // bulk stress tensor of the packing in data/stress.csv
+  p_parameters->num_dt_contacts = 100;      // contact network statistics in data/contact_network.csv
+  p_parameters->contact_fn_num_bins = 50;   // normal force distribution ...
+  p_parameters->contact_fn_max = 5.0;       // ... up to 5 times the mean normal force
+  p_parameters->chain_fn_ratio = 1.0;       // force chains: clusters of particles linked by contacts stronger than the mean ...
+  p_parameters->chain_min_size = 3;         // ... of at least 3 particles
+  p_parameters->num_dt_veldist = 100;       // velocity distributions in data/velocity_pdf.csv and data/speed_pdf.csv
+  p_parameters->veldist_num_bins = 200;
+  p_parameters->veldist_v_max = 2.0 * sqrt(2.0 * g * p_parameters->H_R_ratio * p_parameters->R_cyl); // twice the free-fall speed from the column top
+  p_parameters->veldist_split = VELDIST_SPLIT_PHASE; // VELDIST_SPLIT_REGION: annuli around the axis, VELDIST_SPLIT_NONE: all particles
+  p_parameters->veldist_num_regions = 6;
+  p_parameters->veldist_r_max = 3.0 * p_parameters->R_cyl;
+  p_parameters->num_dt_rdf = 500;           // radial distribution function in data/rdf.csv
+  p_parameters->rdf_num_bins = 50;
+  p_parameters->rdf_r_max = 3.0 * p_parameters->r_cut; // up to r_cut the neighbor list pairs are binned, beyond a cell-list pass runs
+  p_parameters->rdf_density_cell = 8.0 * R_max; // cells of the local density reference
+  p_parameters->num_dt_corr = 50;           // mean-squared displacement and velocity autocorrelation in data/msd_vacf.csv
+  p_parameters->corr_num_levels = 8;        // longest lag: corr_p * corr_m^(corr_num_levels - 1) samples
+  p_parameters->corr_p = 8;
+  p_parameters->corr_m = 2;
+  p_parameters->corr_num_groups = 1;        // all particles; > 1: one group per particle type
+  p_parameters->num_dt_timing = 0;          // 0: off, e.g. 1000: time per part of the step in data/timing.csv, summary per phase at the end
+  p_parameters->use_packing_cache = false;  // true: reuse the settled packing of an earlier run with the same settling parameters (settle-phase output is then skipped)
+  strcpy(p_parameters->packing_cache_dir, "data/"); // directory of the packing cache files
+
+  // FIRE minimizer, used by phases with INTEGRATOR_FIRE (e.g. to relax the initial column quickly)
+  p_parameters->fire_Ekin_ratio = 0.02;                // FIRE starts when Ekin < 2% of its peak; larger values freeze a looser packing
+  p_parameters->fire_dt_max = 4.0 * p_parameters->dt;  // maximum time step
+  p_parameters->fire_N_min = 5;                        // steps with positive power before dt may grow
+  p_parameters->fire_f_inc = 1.1;                      // time step increase factor
+  p_parameters->fire_f_dec = 0.5;                      // time step decrease factor
+  p_parameters->fire_alpha_start = 0.1;                // initial velocity mixing parameter
+  p_parameters->fire_f_alpha = 0.99;                   // decrease factor of the mixing parameter
+
+  // Steady-state detection: stop when the pile has stopped moving during a phase with detect_steady
+  p_parameters->num_dt_steady = 100;        // number of time steps between samples
+  p_parameters->steady_window = 20;         // number of samples in the sliding window
+  p_parameters->steady_Ekin_tol = 1e-9;     // kinetic energy per particle tolerance
+  p_parameters->steady_v_tol = 5e-3;        // maximum particle speed tolerance
+  p_parameters->steady_dh_tol = 0.5 * R_min;// tolerance on the change of h_max and R_base over the window
 
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -9,4 +9,16 @@
  */
 void set_parameters(struct Parameters * p_parameters);
 
+/**
+ * @brief Set the particle-wall contact coefficients of wall i from restitution and friction coefficients.
+ * Uses mass_ref and t_contact, so set_parameters must have been called.
+ * 
+ * @param[in,out] p_parameters Parameters of the simulation, members set: k_n_pw, eta_n_pw, k_t_pw, eta_t_pw, fric_pw
+ * @param[in] i index of the wall
+ * @param[in] e_n normal restitution coefficient
+ * @param[in] e_t tangential restitution coefficient
+ * @param[in] muf friction coefficient
+ */
+void set_wall_coefficients(struct Parameters *p_parameters, unsigned int i, double e_n, double e_t, double muf);
+
 #endif /* SETPARAMETERS_H_ */
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "steadystate.h"
+
+void steady_state_init(struct Parameters *p_parameters, struct SteadyState *p_steady)
+{
+    size_t window = (p_parameters->steady_window > 0 ? p_parameters->steady_window : 1);
+    p_steady->window = window;
+    p_steady->num_samples = 0;
+    p_steady->Ekin = (double *)malloc(window * sizeof(double));
+    p_steady->v_max = (double *)malloc(window * sizeof(double));
+    p_steady->h_max = (double *)malloc(window * sizeof(double));
+    p_steady->R_base = (double *)malloc(window * sizeof(double));
+    p_steady->reached = false;
+    p_steady->reason[0] = '\0';
+}
+
+// Range (max - min) of the values in a full window
+static double window_range(const double *x, size_t n)
+{
+    double x_min = x[0], x_max = x[0];
+    for (size_t k = 1; k < n; ++k)
+    {
+        x_min = (x[k] < x_min ? x[k] : x_min);
+        x_max = (x[k] > x_max ? x[k] : x_max);
+    }
+    return x_max - x_min;
+}
+
+static double window_max(const double *x, size_t n)
+{
+    double x_max = x[0];
+    for (size_t k = 1; k < n; ++k)
+        x_max = (x[k] > x_max ? x[k] : x_max);
+    return x_max;
+}
+
+bool steady_state_update(struct Parameters *p_parameters, struct Vectors *p_vectors, double Ekin, struct SteadyState *p_steady)
+{
+    size_t num_part = p_parameters->num_part;
+    struct Vec3D *r = p_vectors->r;
+    struct Vec3D *v = p_vectors->v;
+    double *R = p_vectors->radius;
+    double cx = 0.5 * p_parameters->L.x;
+    double cy = 0.5 * p_parameters->L.y;
+    double v_sq_max = 0.0, h_max = 0.0, r_sq_max = 0.0, R_edge = 0.0;
+
+    // one pass over the particles for the maximum speed and the pile extent
+    for (size_t i = 0; i < num_part; ++i)
+    {
+        double v_sq = v[i].x * v[i].x + v[i].y * v[i].y + v[i].z * v[i].z;
+        double dx = r[i].x - cx;
+        double dy = r[i].y - cy;
+        double r_sq = dx * dx + dy * dy;
+        v_sq_max = (v_sq > v_sq_max ? v_sq : v_sq_max);
+        h_max = (r[i].z + R[i] > h_max ? r[i].z + R[i] : h_max);
+        if (r_sq > r_sq_max)
+        {
+            r_sq_max = r_sq;
+            R_edge = R[i];
+        }
+    }
+
+    size_t window = p_steady->window;
+    size_t k = p_steady->num_samples % window;
+    p_steady->Ekin[k] = Ekin / (double)num_part;
+    p_steady->v_max[k] = sqrt(v_sq_max);
+    p_steady->h_max[k] = h_max;
+    p_steady->R_base[k] = sqrt(r_sq_max) + R_edge;
+    p_steady->num_samples++;
+    if (p_steady->num_samples < window)
+        return false;
+
+    double Ekin_max = window_max(p_steady->Ekin, window);
+    double v_max = window_max(p_steady->v_max, window);
+    double dh = window_range(p_steady->h_max, window);
+    double dR = window_range(p_steady->R_base, window);
+    if (Ekin_max < p_parameters->steady_Ekin_tol && v_max < p_parameters->steady_v_tol &&
+        dh < p_parameters->steady_dh_tol && dR < p_parameters->steady_dh_tol)
+    {
+        p_steady->reached = true;
+        snprintf(p_steady->reason, sizeof(p_steady->reason),
+                 "steady state over %lu samples: max Ekin/part %g < %g, max speed %g < %g, dh_max %g and dR_base %g < %g",
+                 (long unsigned)window, Ekin_max, p_parameters->steady_Ekin_tol, v_max, p_parameters->steady_v_tol,
+                 dh, dR, p_parameters->steady_dh_tol);
+    }
+    return p_steady->reached;
+}
+
+void steady_state_free(struct SteadyState *p_steady)
+{
+    free(p_steady->Ekin);
+    p_steady->Ekin = NULL;
+    free(p_steady->v_max);
+    p_steady->v_max = NULL;
+    free(p_steady->h_max);
+    p_steady->h_max = NULL;
+    free(p_steady->R_base);
+    p_steady->R_base = NULL;
+}
@@ -0,0 +1,34 @@
+#ifndef STEADYSTATE_H_
+#define STEADYSTATE_H_
+
+#include <stdbool.h>
+
+/**
+ * @brief Allocate the sliding window of the steady-state detector
+ * 
+ * @param p_parameters used members: steady_window
+ * @param p_steady detector state
+ */
+void steady_state_init(struct Parameters *p_parameters, struct SteadyState *p_steady);
+
+/**
+ * @brief Add a sample to the sliding window and check the steady-state criteria.
+ * The system is steady when, over the full window, the kinetic energy per particle and the maximum speed 
+ * stay below their tolerances and h_max and R_base of the pile change less than steady_dh_tol.
+ * 
+ * @param p_parameters used members: num_part, L, steady_Ekin_tol, steady_v_tol, steady_dh_tol
+ * @param p_vectors used members: r, v, radius
+ * @param Ekin kinetic energy of the system
+ * @param p_steady detector state; reason is filled when the steady state is reached
+ * @return bool true if the steady state has been reached
+ */
+bool steady_state_update(struct Parameters *p_parameters, struct Vectors *p_vectors, double Ekin, struct SteadyState *p_steady);
+
+/**
+ * @brief Free the sliding window of the steady-state detector
+ * 
+ * @param p_steady 
+ */
+void steady_state_free(struct SteadyState *p_steady);
+
+#endif /* STEADYSTATE_H_ */
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "analysis.h"
+#include "stress.h"
+
+static size_t stress_index(double x, double cell, size_t num)
+{
+    long i = (long)floor(x / cell);
+    if (i < 0)
+        return 0;
+    if ((size_t)i >= num)
+        return num - 1;
+    return (size_t)i;
+}
+
+// Volume of the region the packing occupies: its footprint of columns times their height above the floor
+static double stress_region_volume(struct StressState *p_state, const struct Snapshot *p_snap)
+{
+    for (size_t k = 0; k < p_state->num_touched; ++k)
+        p_state->h[p_state->touched[k]] = 0.0;
+    p_state->num_touched = 0;
+    for (size_t i = 0; i < p_snap->num_part; ++i)
+    {
+        size_t c = stress_index(p_snap->r[i].x, p_state->cell, p_state->num_x) * p_state->num_y +
+                   stress_index(p_snap->r[i].y, p_state->cell, p_state->num_y);
+        double top = p_snap->r[i].z + p_snap->radius[i];
+        if (p_state->h[c] == 0.0)
+            p_state->touched[p_state->num_touched++] = c;
+        if (top > p_state->h[c])
+            p_state->h[c] = top;
+    }
+    double volume = 0.0;
+    for (size_t k = 0; k < p_state->num_touched; ++k)
+        volume += p_state->h[p_state->touched[k]];
+    return volume * p_state->cell * p_state->cell;
+}
+
+static void stress_sample(struct Analysis *p_analysis, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    struct StressState *p_state = (struct StressState *)p_analysis->state;
+    if (p_snap->stress == NULL)
+        return;
+    struct SymTensor s = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    double p_kin = 0.0;
+    double vol_tot = 0.0;
+    double volume = stress_region_volume(p_state, p_snap);
+    for (size_t i = 0; i < p_snap->num_part; ++i)
+    {
+        double R = p_snap->radius[i];
+        double vol = (4.0 / 3.0) * PI * R * R * R;
+        double m = p_parameters->density * vol;
+        const struct SymTensor *si = &p_snap->stress[i];
+        const struct Vec3D *v = &p_snap->v[i];
+        s.xx += vol * si->xx + m * v->x * v->x;
+        s.yy += vol * si->yy + m * v->y * v->y;
+        s.zz += vol * si->zz + m * v->z * v->z;
+        s.xy += vol * si->xy + m * v->x * v->y;
+        s.xz += vol * si->xz + m * v->x * v->z;
+        s.yz += vol * si->yz + m * v->y * v->z;
+        p_kin += m * (v->x * v->x + v->y * v->y + v->z * v->z);
+        vol_tot += vol;
+    }
+    if (volume <= 0.0)
+        return;
+    s.xx /= volume;
+    s.yy /= volume;
+    s.zz /= volume;
+    s.xy /= volume;
+    s.xz /= volume;
+    s.yz /= volume;
+    p_kin /= 3.0 * volume;
+    p_state->num_samples++;
+    p_state->sum.xx += s.xx;
+    p_state->sum.yy += s.yy;
+    p_state->sum.zz += s.zz;
+    p_state->sum.xy += s.xy;
+    p_state->sum.xz += s.xz;
+    p_state->sum.yz += s.yz;
+    if (p_state->fp)
+    {
+        fprintf(p_state->fp, "%lu,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g\n", (long unsigned)p_snap->step, p_snap->time,
+                s.xx, s.yy, s.zz, s.xy, s.xz, s.yz, (s.xx + s.yy + s.zz) / 3.0, p_kin, volume, vol_tot / volume);
+        fflush(p_state->fp);
+    }
+}
+
+static void stress_finish(struct Analysis *p_analysis, struct Parameters *p_parameters)
+{
+    struct StressState *p_state = (struct StressState *)p_analysis->state;
+    if (p_state->num_samples == 0)
+        return;
+    double n = (double)p_state->num_samples;
+    printf("Mean stress of the packing over %lu samples: p = %g (Pa), sigma_zz = %g (Pa)\n",
+           (long unsigned)p_state->num_samples, (p_state->sum.xx + p_state->sum.yy + p_state->sum.zz) / (3.0 * n),
+           p_state->sum.zz / n);
+}
+
+static void stress_free(void *state)
+{
+    struct StressState *p_state = (struct StressState *)state;
+    if (p_state == NULL)
+        return;
+    if (p_state->fp)
+        fclose(p_state->fp);
+    free(p_state->h);
+    free(p_state->touched);
+    free(p_state);
+}
+
+void stress_register(struct Parameters *p_parameters, struct AnalysisSet *p_set)
+{
+    if (p_parameters->num_dt_stress == 0)
+        return;
+    struct StressState *p_state = (struct StressState *)calloc(1, sizeof(struct StressState));
+    if (p_state == NULL)
+        return;
+    p_state->cell = p_parameters->hm_cell > 0.0 ? p_parameters->hm_cell : 2.0 * p_parameters->R_max;
+    p_state->num_x = (size_t)ceil(p_parameters->L.x / p_state->cell);
+    p_state->num_y = (size_t)ceil(p_parameters->L.y / p_state->cell);
+    p_state->h = (double *)calloc(p_state->num_x * p_state->num_y, sizeof(double));
+    p_state->touched = (size_t *)malloc(p_state->num_x * p_state->num_y * sizeof(size_t));
+    if (p_state->h == NULL || p_state->touched == NULL)
+    {
+        fprintf(stderr, "Error: failed to allocate the contact stress analysis\n");
+        stress_free(p_state);
+        return;
+    }
+    p_state->fp = fopen("data/stress.csv", "w");
+    if (p_state->fp)
+        fprintf(p_state->fp, "step,time,sxx,syy,szz,sxy,sxz,syz,p,p_kin,volume,phi\n");
+    else
+        fprintf(stderr, "Error: cannot open data/stress.csv for writing\n");
+
+    struct Analysis analysis = {.name = "contact stress", .num_dt = p_parameters->num_dt_stress, .final = false,
+                                .fields = SNAPSHOT_FIELD_STRESS, .contacts = false, .state = p_state,
+                                .sample = stress_sample, .finish = stress_finish, .free = stress_free, .merge = NULL};
+    analysis_add(p_set, &analysis);
+}
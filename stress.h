@@ -0,0 +1,21 @@
+#ifndef STRESS_H_
+#define STRESS_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Register the contact stress as an analysis (if num_dt_stress > 0). On its sampling steps
+ * @ref calculate_forces accumulates the stress of every particle from the branch vectors and forces of its
+ * particle and wall contacts (positive in compression). Each sample appends to data/stress.csv the bulk stress tensor
+ * of the packing, sum(V_i sigma_i + m_i v_i v_i) / V, and the pressure p (a third of its trace, p_kin of the kinetic
+ * part). V is the volume of the region the packing occupies: the columns of edge hm_cell holding a particle, each
+ * up to the top of its highest particle above the floor z = 0. The volume and the solid fraction phi = sum(V_i) / V
+ * are written as well; the mean stress inside the grains is the bulk stress divided by phi.
+ * 
+ * @param[in] p_parameters used members: num_dt_stress, density, hm_cell (2 R_max if not positive), R_max, L
+ * @param[in,out] p_set 
+ */
+void stress_register(struct Parameters *p_parameters, struct AnalysisSet *p_set);
+
+#endif /* STRESS_H_ */
@@ -1,6 +1,10 @@
 #ifndef TYPES_MD_H_
 #define TYPES_MD_H_
+#include <stdio.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "constants.h"
 
 /* This header file contains definitions of struct types used in the molecular dynamics code */
@@ -14,6 +18,15 @@ struct Index3D
     size_t i, j, k; //!< 3 indices: i,j, k
 };
 
+/**
+ * @brief Struct to store the periodic image of a particle: how many box lengths it was shifted back into the box
+ * 
+ */
+struct Image3D
+{
+    int32_t x, y, z; //!< image counters in x, y and z
+};
+
 /**
  * @brief Struct to store x, y, and z component of a 3D vector.
  * 
@@ -23,6 +36,15 @@ struct Vec3D
     double x, y, z; //!< Three three coordinates of a 3D vector
 };
 
+/**
+ * @brief Struct to store a symmetric 3x3 tensor, e.g. a stress
+ * 
+ */
+struct SymTensor
+{
+    double xx, yy, zz, xy, xz, yz; //!< the six independent components
+};
+
 /**
  * @brief Struct to store a 3D vector and its square length. This is expecially useful for connecting vectors in e.g. neighbor lists.
  * 
@@ -34,6 +56,220 @@ struct DeltaR
     double sq;      //!< square length
 };
 
+/**
+ * @brief Conditions that end a simulation phase, see @ref phases_update
+ * 
+ */
+enum PhaseTrigger
+{
+    PHASE_TRIGGER_NONE, //!< phase lasts until the end of the simulation
+    PHASE_TRIGGER_STEP, //!< phase ends after trigger_value time steps
+    PHASE_TRIGGER_TIME, //!< phase ends after trigger_value simulated time
+    PHASE_TRIGGER_EKIN, //!< phase ends when the kinetic energy per particle stays below trigger_value for trigger_pers_steps steps
+    PHASE_TRIGGER_FORCE //!< phase ends when the largest net force on a particle, relative to its weight, stays below trigger_value for trigger_pers_steps steps
+};
+
+/**
+ * @brief Integrators that can be used during a phase
+ * 
+ */
+enum Integrator
+{
+    INTEGRATOR_VERLET, //!< velocity-Verlet dynamics
+    INTEGRATOR_FIRE    //!< velocity-Verlet until the collapse has compacted the column, then FIRE velocity mixing and adaptive time step to relax it to mechanical equilibrium
+};
+
+/**
+ * @brief Struct to store the settings of one phase of the simulation (e.g. settling, spreading).
+ * A phase is active from the moment the previous phase ended until its own trigger fires.
+ * 
+ */
+struct Phase
+{
+    char name[32];               //!< name used in screen output
+    enum PhaseTrigger trigger;   //!< condition that ends this phase
+    double trigger_value;        //!< number of steps, time span or kinetic energy per particle, depending on trigger
+    size_t trigger_pers_steps;   //!< number of consecutive steps the energy criterion must hold
+    size_t num_dt_traj;          //!< number of time steps between trajectory saves during this phase
+    double r_shell;              //!< shell thickness for neighbor list during this phase
+    double damping;              //!< background damping rate (1/s), adds a force -damping*m*v
+    unsigned int wall_mask;      //!< walls active during this phase, see WALL_BIT
+    bool detect_steady;          //!< if true the run ends early when a steady state is detected during this phase
+    enum Integrator integrator;  //!< integrator used during this phase
+};
+
+/**
+ * @brief Struct to store the state of the FIRE minimizer
+ * 
+ */
+struct FireState
+{
+    double dt_md;     //!< time step of normal dynamics, restored when a FIRE phase ends
+    double alpha;     //!< current velocity mixing parameter
+    size_t n_pos;     //!< number of consecutive steps with positive power F.v
+    double Ekin_max;  //!< largest kinetic energy of the phase so far, see fire_Ekin_ratio
+    bool active;      //!< false while the column still compacts by normal dynamics
+};
+
+/**
+ * @brief Struct to store the progress through the list of phases
+ * 
+ */
+struct PhaseState
+{
+    size_t current;      //!< index of the active phase
+    size_t step_start;   //!< time step at which the active phase started
+    double time_start;   //!< time at which the active phase started
+    size_t counter;      //!< consecutive steps for which the energy criterion held
+};
+
+/**
+ * @brief Struct to store the sliding window of the steady-state detector
+ * 
+ */
+struct SteadyState
+{
+    size_t window;       //!< number of samples in the window
+    size_t num_samples;  //!< number of samples taken so far
+    double *Ekin;        //!< kinetic energy per particle of the samples (ring buffer)
+    double *v_max;       //!< maximum particle speed of the samples (ring buffer)
+    double *h_max;       //!< pile height of the samples (ring buffer)
+    double *R_base;      //!< pile base radius of the samples (ring buffer)
+    bool reached;        //!< true once the steady-state criteria hold
+    char reason[256];    //!< description of the criteria values when the steady state was reached
+};
+
+/**
+ * @brief Methods to place the particles at the start of a simulation
+ * 
+ */
+enum InitPositions
+{
+    INIT_POSITIONS_LATTICE,   //!< loose hexagonal lattice inside the cylinder, see @ref initialise_positions_cylinder
+    INIT_POSITIONS_DEPOSITION //!< random loose packing by drop-and-roll deposition, see @ref initialise_positions_deposition
+};
+
+/**
+ * @brief File formats for trajectory output
+ * 
+ */
+enum TrajFormat
+{
+    TRAJ_FORMAT_XYZ,   //!< text xyz file, one file opened per frame, see @ref record_trajectories_xyz
+    TRAJ_FORMAT_BINARY, //!< binary frames with a frame index, see @ref trajectory_write_frame
+    TRAJ_FORMAT_VTU     //!< one VTU file per frame tied together by a .pvd series, see @ref vtk_write_frame
+};
+
+/**
+ * @brief Behaviour of the output pipeline when all snapshot buffers are in use
+ * 
+ */
+enum OutputBackpressure
+{
+    OUTPUT_BACKPRESSURE_BLOCK, //!< the time loop waits for the writer thread
+    OUTPUT_BACKPRESSURE_DROP   //!< snapshots without OUTPUT_TASK_ANALYSIS are dropped and counted per task, analysis samples wait
+};
+
+/**
+ * @brief Grids of the coarse-grained fields
+ * 
+ */
+enum CgGrid
+{
+    CG_GRID_RZ,  //!< axisymmetric (r, z) grid around the cylinder axis, vectors and tensors in cylindrical components
+    CG_GRID_XYZ  //!< 3D Cartesian grid
+};
+
+/**
+ * @brief Groups of particles with separate velocity distributions
+ * 
+ */
+enum VelDistSplit
+{
+    VELDIST_SPLIT_NONE,    //!< all particles
+    VELDIST_SPLIT_REGION,  //!< annuli of equal width around the cylinder axis
+    VELDIST_SPLIT_PHASE    //!< the phase the sample was taken in
+};
+
+/**
+ * @brief Header at the start of a binary trajectory file
+ * 
+ */
+struct TrajFileHeader
+{
+    char magic[8];         //!< "PBSTRAJ"
+    uint32_t version;      //!< format version
+    uint32_t size_header;  //!< size of this header in bytes
+    uint32_t endian_tag;   //!< 0x01020304 written in the byte order of the writer
+    uint32_t fields;       //!< fields stored in every frame, see TRAJ_FIELD_POSITION etc.
+    uint32_t size_real;    //!< bytes per stored real number: 4 (float) or 8 (double)
+    uint32_t reserved;     //!< zero
+    uint64_t num_part;     //!< number of particles in every frame
+};
+
+/**
+ * @brief Header of a frame in a binary trajectory file. It is followed by one block per field in the order
+ * position (3 reals per particle), radius (1), velocity (3), omega (3), force (3); every block is padded to 8 bytes.
+ * 
+ */
+struct TrajFrameHeader
+{
+    char magic[4];         //!< "FRM"
+    uint32_t fields;       //!< fields stored in this frame
+    uint64_t index;        //!< frame number, starting at 0
+    uint64_t step;         //!< time step of the frame
+    double time;           //!< time of the frame
+    uint64_t size_frame;   //!< size of the frame including this header in bytes
+};
+
+/**
+ * @brief Header following the frame header of a delta frame ("DLT"). A delta frame stores only the positions of the
+ * particles that moved more than the tolerance since their last record: num_moved uint32_t particle indices, then
+ * num_moved*3 int32_t positions in units of quantum; both blocks are padded to 8 bytes. Radius, velocity, omega and
+ * force are only stored in keyframes, since the values of the particles left out would be stale.
+ * 
+ */
+struct TrajDeltaHeader
+{
+    uint64_t num_moved;    //!< number of particles stored in this frame
+    double quantum;        //!< position of a stored particle = quantum * stored integer coordinate
+};
+
+/**
+ * @brief Trailer at the end of a closed binary trajectory file, pointing to the frame index.
+ * The index is a uint64_t with the number of frames followed by the file offsets of all frames.
+ * 
+ */
+struct TrajTrailer
+{
+    uint64_t offset_index; //!< file offset of the frame index
+    char magic[8];         //!< "PBSTEND"
+};
+
+/**
+ * @brief Struct to store the state of an open trajectory
+ * 
+ */
+struct Trajectory
+{
+    enum TrajFormat format;      //!< file format
+    FILE *p_file;                //!< file handle, kept open during the whole run (binary format)
+    unsigned int fields;         //!< fields written in every frame
+    size_t size_real;            //!< bytes per stored real number
+    uint64_t offset;             //!< number of bytes written so far
+    size_t num_frames;           //!< number of frames written
+    size_t num_frames_max;       //!< number of frame offsets allocated
+    uint64_t *frame_offset;      //!< file offsets of the frames
+    float *buffer;               //!< conversion buffer for single precision output
+    bool delta;                  //!< if true keyframes are followed by delta frames
+    size_t num_frames_key;       //!< number of frames from one keyframe to the next
+    double delta_tol;            //!< a particle is stored in a delta frame if it moved more than this distance
+    double quantum;              //!< resolution of the positions in delta frames
+    struct Vec3D *r_ref;         //!< positions as a reader reconstructs them from the frames written so far
+    uint32_t *moved;             //!< indices of the particles stored in the current delta frame
+    void *delta_buffer;          //!< gather buffer for the fields of the moved particles
+};
+
 /**
  * @brief Struct to store all parameters. These parameters are set by the function @ref set_parameters.
  * 
@@ -47,6 +283,7 @@ struct Parameters
     double Tg;             //!< Granular temperature. Can be used to initialize velocities. 1.5Tg is the average kinetic energy per particle.
     double density;        //!< Density of particles
     double mass_ref;       //!< Reference mass used for collision parameters
+    double t_contact;      //!< contact time of two particles of mass_ref, used for collision parameters
     double R_max;          //!< Maximum sphere radius
     double R_min;          //!< Minumum sphere radius 
     struct Vec3D g;        //!< gravitational acceleration vector
@@ -67,21 +304,659 @@ struct Parameters
     size_t num_dt_printf;            //!< Number of time steps between prints to screen
     size_t num_dt_traj;              //!< Number of time steps between trajectory saves
     char filename_xyz[1024];         //!< filename (without extension) for pdb file
+    enum TrajFormat traj_format;     //!< file format of the trajectory
+    unsigned int traj_fields;        //!< fields stored in binary trajectory frames, see TRAJ_FIELD_POSITION etc.
+    bool traj_single_precision;      //!< if true binary trajectory frames store floats instead of doubles
+    bool traj_delta;                 //!< if true binary trajectories store keyframes and delta frames of the moved particles
+    size_t traj_num_frames_key;      //!< number of frames from one keyframe to the next
+    double traj_delta_tol;           //!< positions in delta frames are reconstructed to within this distance
+    char filename_archive[1024];     //!< filename (without step and extension) of archives
+    size_t num_dt_archive;           //!< number of time steps between archives, 0: only the final state is archived
+    unsigned int archive_fields;     //!< fields stored in archives, see TRAJ_FIELD_POSITION etc.
+    double archive_cell;             //!< edge length of the cells that group archived particles into chunks
+    double archive_tol_r;            //!< tolerance of archived positions and radii
+    double archive_tol_v;            //!< tolerance of archived velocity components
+    double archive_tol_omega;        //!< tolerance of archived angular velocity components
+    double archive_tol_f;            //!< tolerance of archived force components
+    bool vtk_contacts;               //!< if true VTU frames are accompanied by the contact network (filename_xyz + "_contacts")
+    bool traj_adaptive;              //!< if true the spacing of trajectory frames follows the particle motion instead of num_dt_traj
+    size_t traj_num_dt_min;          //!< minimum number of time steps between adaptive frames
+    size_t traj_num_dt_max;          //!< maximum number of time steps between adaptive frames
+    double traj_disp;                //!< a frame is written once a particle may have moved this distance since the last frame
+    size_t num_dt_profiles;          //!< number of time steps between samples of the averaged volume fraction profiles
+    size_t profile_num_bins_r;       //!< number of radial bins of the averaged profiles
+    size_t profile_num_bins_z;       //!< number of axial bins of the averaged profiles
+    size_t profile_final_num_bins_r; //!< number of radial bins of the profiles of the final pile
+    size_t profile_final_num_bins_z; //!< number of axial bins of the profiles of the final pile
+    size_t num_dt_cg;                //!< number of time steps between coarse-grained fields, 0: off
+    enum CgGrid cg_grid;             //!< grid of the coarse-grained fields
+    struct Index3D cg_size;          //!< number of grid nodes in each direction (RZ grids: i radial, k axial)
+    struct Vec3D cg_lo, cg_hi;       //!< region covered by the grid; RZ grids use cg_lo.z and cg_hi.z
+    double cg_r_max;                 //!< radial extent of RZ grids
+    double cg_width;                 //!< cutoff radius of the smoothing kernel of the coarse-grained fields
+    size_t num_dt_heightmap;         //!< number of time steps between samples of the surface height map, 0: final pile only
+    double hm_cell;                  //!< edge length of the columns of the height map (and of the footprint of the bulk stress) and width of its radial bins
+    double hm_coverage;              //!< minimum fraction of covered columns of a radial bin inside the runout radius
+    double hm_fit_lo, hm_fit_hi;     //!< the slope is fitted to the surface between these fractions of the peak height
+    size_t num_dt_stress;            //!< number of time steps between samples of the contact stress (data/stress.csv), 0: off
+    size_t num_dt_contacts;          //!< number of time steps between samples of the contact network statistics, 0: off
+    size_t contact_fn_num_bins;      //!< number of bins of the normal force distribution
+    double contact_fn_max;           //!< upper end of the normal force distribution in units of the mean normal force
+    double chain_fn_ratio;           //!< contacts with a normal force above this times the mean are strong (force chains)
+    size_t chain_min_size;           //!< minimum number of particles of a force chain
+    size_t num_dt_veldist;           //!< number of time steps between samples of the velocity distributions, 0: off
+    size_t veldist_num_bins;         //!< number of bins of the velocity distributions
+    double veldist_v_max;            //!< velocity components are binned in -veldist_v_max..veldist_v_max, speeds in 0..veldist_v_max
+    enum VelDistSplit veldist_split; //!< groups of particles with separate distributions
+    size_t veldist_num_regions;      //!< number of annuli for VELDIST_SPLIT_REGION
+    double veldist_r_max;            //!< outer radius of the annuli for VELDIST_SPLIT_REGION
+    size_t num_dt_rdf;               //!< number of time steps between samples of the radial distribution function, 0: off
+    size_t rdf_num_bins;             //!< number of bins of the radial distribution function
+    double rdf_r_max;                //!< range of the radial distribution function; up to r_cut the neighbor list pairs are binned
+    double rdf_density_cell;         //!< edge of the cells of the local number density that normalizes the radial distribution function
+    size_t num_dt_corr;              //!< number of time steps between samples of the MSD and VACF correlators, 0: off
+    size_t corr_num_levels;          //!< number of levels of the multi-tau correlators
+    size_t corr_p;                   //!< number of lags per level, a multiple of corr_m
+    size_t corr_m;                   //!< number of samples of a level averaged into one of the next level
+    size_t corr_num_groups;          //!< number of particle groups of the correlators, by type; higher types count in the last group
+    size_t num_dt_timing;            //!< number of time steps between rows of data/timing.csv, 0: no timing instrumentation
     char load_restart;               //!< if equal 1 restart file is loaded
     size_t num_dt_restart;           //!< Number of time steps between saves of restart file
     char restart_in_filename[1024];  //!< filename for loaded restart file
     char restart_out_filename[1024]; //!< filename for saved restart file
+    bool restart_async;              //!< if true restart files are written by a background thread
+    bool output_async;               //!< if true trajectory frames, profile samples and status lines are written by a background thread
+    size_t output_num_slots;         //!< number of snapshot buffers of the output pipeline
+    enum OutputBackpressure output_backpressure; //!< behaviour when all snapshot buffers are in use
 
     // Parameters for cylindrical wall
     double H_R_ratio;                //!< height to radius ratio of cylindrical wall
     double R_cyl;                    //!< radius of cylindrical wall
+    enum InitPositions init_positions; //!< method used to place the particles inside the cylinder
+
+    // Parameters for the phases of the simulation (settling, collapse, ...)
+    size_t num_phases;                    //!< number of phases
+    struct Phase phases[NUM_PHASES_MAX];  //!< settings and triggers of the phases, executed in order
+    unsigned int wall_mask;               //!< walls currently active, set from the active phase
+    double damping;                       //!< background damping rate currently applied, set from the active phase
+    bool reset_final_pile;           //!< if true data/final_pile_surface.csv is started anew, else the final pile is appended
+    bool use_packing_cache;          //!< if true the state at the end of the first phase is loaded from / stored in the packing cache
+    char packing_cache_dir[1024];    //!< directory (with trailing separator) of the packing cache files
+
+    // Parameters for the FIRE minimizer (used in phases with INTEGRATOR_FIRE)
+    double fire_Ekin_ratio;          //!< FIRE takes over from normal dynamics once the kinetic energy dropped below this fraction of its peak
+    double fire_dt_max;              //!< maximum time step
+    size_t fire_N_min;               //!< number of steps with positive power before the time step may grow
+    double fire_f_inc;               //!< time step increase factor
+    double fire_f_dec;               //!< time step decrease factor after an uphill step
+    double fire_alpha_start;         //!< initial velocity mixing parameter
+    double fire_f_alpha;             //!< decrease factor of the mixing parameter
+
+    // Parameters for steady-state detection (early termination)
+    size_t num_dt_steady;            //!< number of time steps between samples of the steady-state detector
+    size_t steady_window;            //!< number of samples in the sliding window
+    double steady_Ekin_tol;          //!< kinetic energy per particle below which the system may be steady
+    double steady_v_tol;             //!< maximum particle speed below which the system may be steady
+    double steady_dh_tol;            //!< maximum change of h_max and R_base over the window
+};
+
+/**
+ * @brief Identifiers of the sections of a restart file, see @ref restart_serialize
+ * 
+ */
+enum RestartSectionId
+{
+    RESTART_SECTION_PARAMETERS = 1, //!< one struct RestartParameters
+    RESTART_SECTION_RUN_STATE,      //!< one struct RestartRunState
+    RESTART_SECTION_TYPE,           //!< int per particle
+    RESTART_SECTION_RADIUS,         //!< double per particle
+    RESTART_SECTION_MASS,           //!< double per particle
+    RESTART_SECTION_R,              //!< struct Vec3D per particle
+    RESTART_SECTION_DR,             //!< struct Vec3D per particle
+    RESTART_SECTION_V,              //!< struct Vec3D per particle
+    RESTART_SECTION_OMEGA,          //!< struct Vec3D per particle
+    RESTART_SECTION_F,              //!< struct Vec3D per particle
+    RESTART_SECTION_T,              //!< struct Vec3D per particle
+    RESTART_SECTION_NBR,            //!< struct Pair per neighbor pair
+    RESTART_SECTION_NBR_DR,         //!< struct DeltaR per particle, displacement since the neighbor list was built
+    RESTART_SECTION_COLL,           //!< struct Pair per particle-particle contact
+    RESTART_SECTION_COLL_TIJ,       //!< struct DeltaR per particle-particle contact
+    RESTART_SECTION_WALL_INDCS,     //!< size_t particle index per wall contact
+    RESTART_SECTION_WALL_ID,        //!< unsigned int wall index per wall contact
+    RESTART_SECTION_WALL_RIW,       //!< struct DeltaR per wall contact
+    RESTART_SECTION_WALL_TIW,       //!< struct DeltaR per wall contact
+    RESTART_SECTION_WALL_VW,        //!< struct Vec3D per wall contact
+    RESTART_SECTION_STEADY_EKIN,    //!< double per sample in the steady-state window
+    RESTART_SECTION_STEADY_V_MAX,   //!< double per sample in the steady-state window
+    RESTART_SECTION_STEADY_H_MAX,   //!< double per sample in the steady-state window
+    RESTART_SECTION_STEADY_R_BASE,  //!< double per sample in the steady-state window
+    RESTART_SECTION_IMAGE           //!< struct Image3D per particle; optional, images start at zero without it
+};
+
+/**
+ * @brief Header at the start of a restart file. It is followed by the section table and the sections,
+ * each starting at a multiple of RESTART_ALIGN bytes so that a memory-mapped file can be used without copying.
+ * 
+ */
+struct RestartHeader
+{
+    char magic[8];          //!< "PBSRST"
+    uint32_t version;       //!< format version
+    uint32_t size_header;   //!< size of this header in bytes
+    uint32_t endian_tag;    //!< 0x01020304 written in the byte order of the writer
+    uint32_t num_sections;  //!< number of entries in the section table
+    uint64_t size_file;     //!< total size of the file in bytes
+    uint64_t key;           //!< user key, e.g. the packing cache key; 0 for normal restart files
+    uint64_t checksum;      //!< FNV-1a hash of the section table
+};
+
+/**
+ * @brief Entry of the section table of a restart file
+ * 
+ */
+struct RestartSection
+{
+    uint32_t id;            //!< section identifier, see enum RestartSectionId
+    uint32_t size_elem;     //!< size of one element in bytes
+    uint64_t num_elem;      //!< number of elements
+    uint64_t offset;        //!< offset of the section from the start of the file
+    uint64_t checksum;      //!< FNV-1a hash of the section data
+};
+
+/**
+ * @brief Parameters that define the physics of a run, stored in restart files to check continuations
+ * 
+ */
+struct RestartParameters
+{
+    uint64_t num_part;                 //!< number of particles
+    uint32_t num_walls;                //!< number of walls
+    uint32_t seed;                     //!< seed of the random generator
+    double density, mass_ref, R_min, R_max;           //!< particle properties
+    double L[3], g[3];                 //!< box size and gravity
+    double k_n_pp, eta_n_pp, k_t_pp, eta_t_pp, fric_pp; //!< particle-particle contact coefficients
+    double k_n_pw[NUM_WALLS_MAX], eta_n_pw[NUM_WALLS_MAX], k_t_pw[NUM_WALLS_MAX], eta_t_pw[NUM_WALLS_MAX], fric_pw[NUM_WALLS_MAX]; //!< particle-wall contact coefficients
+    double r_cut;                      //!< cut-off distance
+    double R_cyl;                      //!< radius of the cylindrical wall
+};
+
+/**
+ * @brief State of the time loop stored in restart files: step, phase, FIRE and steady-state progress and
+ * the parameters that are changed while running
+ * 
+ */
+struct RestartRunState
+{
+    uint64_t step;              //!< time step
+    double time;                //!< time
+    double dt;                  //!< current time step size (changed by FIRE)
+    double r_shell;             //!< current shell thickness
+    double damping;             //!< current background damping rate
+    uint64_t num_dt_traj;       //!< current number of time steps between trajectory saves
+    uint32_t wall_mask;         //!< walls currently active
+    uint32_t steady_reached;    //!< 1 if a steady state was reached
+    uint64_t phase_current;     //!< see struct PhaseState
+    uint64_t phase_step_start;  //!< see struct PhaseState
+    double phase_time_start;    //!< see struct PhaseState
+    uint64_t phase_counter;     //!< see struct PhaseState
+    double fire_dt_md;          //!< see struct FireState
+    double fire_alpha;          //!< see struct FireState
+    uint64_t fire_n_pos;        //!< see struct FireState
+    double fire_Ekin_max;       //!< see struct FireState
+    uint64_t fire_active;       //!< see struct FireState
+    uint64_t steady_num_samples;//!< number of steady-state samples taken so far
+};
+
+/**
+ * @brief A file mapped read-only into memory, see @ref pbsmap_traj_open and @ref pbsmap_restart_open
+ * 
+ */
+struct MappedFile
+{
+    const uint8_t *data;         //!< start of the mapping
+    size_t size;                 //!< size of the file in bytes
+    void *handle_file;           //!< file handle (Windows)
+    void *handle_map;            //!< mapping handle (Windows)
+};
+
+/**
+ * @brief A binary trajectory mapped into memory with the offsets of all frames
+ * 
+ */
+struct MappedTrajectory
+{
+    struct MappedFile file;                //!< the mapped file
+    const struct TrajFileHeader *header;   //!< file header in the mapping
+    size_t num_frames;                     //!< number of complete frames
+    const uint64_t *frame_offset;          //!< file offsets of the frames: the index in the mapping or frame_offset_scan
+    uint64_t *frame_offset_scan;           //!< frame offsets found by scanning a file without index, NULL otherwise
+};
+
+/**
+ * @brief A restart file mapped into memory
+ * 
+ */
+struct MappedRestart
+{
+    struct MappedFile file;                //!< the mapped file
+    const struct RestartHeader *header;    //!< file header in the mapping
+    const struct RestartSection *table;    //!< section table in the mapping
+};
+
+/**
+ * @brief An offline re-analysis of a mapped trajectory, see tools/reanalyze.c. The frames are split into blocks
+ * of a size that depends only on the trajectory; worker threads take the blocks from a shared counter.
+ * 
+ */
+struct Reanalysis
+{
+    struct Parameters parameters;          //!< parameters of the analyses, read-only while the workers run
+    const struct MappedTrajectory *p_traj; //!< the trajectory
+    size_t num_part;                       //!< number of particles
+    size_t num_frames;                     //!< number of frames
+    double *radius;                        //!< particle radii of the first keyframe (radii do not change)
+    int *type;                             //!< particle types, not stored in trajectories: all 0
+    bool velocities;                       //!< keyframes store velocities
+    bool all_frames;                       //!< sample every frame, regardless of the num_dt_* of the analyses
+    size_t num_frames_block;               //!< number of frames per block
+    size_t num_blocks;                     //!< number of blocks
+    atomic_size_t next_block;              //!< next block to be taken by a worker
+    struct AnalysisSet *blocks;            //!< sets of the order-independent modules per block and module
+    atomic_bool failed;                    //!< a frame could not be decoded
+};
+
+/**
+ * @brief Struct to store the state of the background checkpoint writer.
+ * The time loop copies the run state into one of two buffers while the writer thread writes the other one.
+ * 
+ */
+struct Checkpoint
+{
+    pthread_t thread;           //!< writer thread
+    pthread_mutex_t mutex;      //!< protects the members below
+    pthread_cond_t cond;        //!< signals changes of pending, writing and stop
+    char *buffer[2];            //!< restart images
+    size_t capacity[2];         //!< allocated sizes of the buffers
+    size_t size[2];             //!< sizes of the images in the buffers
+    int pending;                //!< buffer waiting to be written, -1 if none
+    int writing;                //!< buffer being written, -1 if none
+    bool stop;                  //!< asks the writer thread to finish
+    size_t num_written;         //!< number of restart files written
+    char filename[1024];        //!< restart file
+};
+
+/**
+ * @brief Header of an archive file, see @ref archive_write. It is followed by the chunk table and the blocks.
+ * 
+ */
+struct ArchiveHeader
+{
+    char magic[8];                        //!< "PBSARCH"
+    uint32_t version;                     //!< format version
+    uint32_t size_header;                 //!< size of this header in bytes
+    uint32_t endian_tag;                  //!< 0x01020304 written in the byte order of the writer
+    uint32_t fields;                      //!< fields stored for every particle, see TRAJ_FIELD_POSITION etc.
+    uint64_t num_part;                    //!< number of particles
+    uint64_t step;                        //!< time step of the snapshot
+    double time;                          //!< time of the snapshot
+    struct Vec3D origin;                  //!< lower corner of the chunk grid
+    double cell;                          //!< edge length of the chunk cells
+    uint32_t num_cells[3];                //!< number of cells of the chunk grid in x, y and z
+    uint32_t num_chunks;                  //!< number of chunks (non-empty cells)
+    double quantum[ARCHIVE_NUM_FIELDS];   //!< stored value = quantum * stored integer, per field in TRAJ_FIELD order
+    uint64_t checksum;                    //!< FNV-1a hash of the chunk table
+};
+
+/**
+ * @brief Location and encoding of one block of an archive chunk
+ * 
+ */
+struct ArchiveBlock
+{
+    uint64_t offset;       //!< file offset of the block
+    uint32_t size;         //!< size of the block in the file in bytes
+    uint32_t size_raw;     //!< size of the block before compression in bytes
+    uint32_t width;        //!< bytes per stored integer: 2, 4 or 8
+    uint32_t codec;        //!< 1: compressed with @ref codec_compress, 0: stored as is
+    uint64_t checksum;     //!< FNV-1a hash of the stored block
+};
 
-    // Parameters for collapse / wall removal
-    size_t collapse_start_step;      //!< time step at which the cylindrical wall is removed
-    size_t cyl_wall_index;           //!< index of the cylindrical wall in the wall arrays
-    size_t settle_pers_steps;        //!< number of consecutive steps below kinetic energy tolerance before wall removal
-    double Ekin_tol;                 //!< kinetic energy per particle tolerance for settling
-    bool reset_final_pile;           //!< filename for saved final pile characterization
+/**
+ * @brief Entry of the chunk table of an archive: the particles in one cell of the chunk grid
+ * 
+ */
+struct ArchiveChunk
+{
+    uint32_t cell[3];                              //!< cell indices in x, y and z
+    uint32_t num_part;                             //!< number of particles in the chunk
+    struct ArchiveBlock block[ARCHIVE_NUM_BLOCKS]; //!< particle indices, then one block per field in TRAJ_FIELD order
+};
+
+/**
+ * @brief Particles read from an archive by @ref archive_read. Fields that were not read are NULL.
+ * 
+ */
+struct ArchiveData
+{
+    size_t num_part;       //!< number of particles read
+    size_t step;           //!< time step of the snapshot
+    double time;           //!< time of the snapshot
+    size_t *id;            //!< particle indices in the simulation
+    double *radius;        //!< radii
+    struct Vec3D *r;       //!< positions
+    struct Vec3D *v;       //!< velocities
+    struct Vec3D *omega;   //!< angular velocities
+    struct Vec3D *f;       //!< forces
+};
+
+/**
+ * @brief Struct to store the state of an open VTU series
+ * 
+ */
+struct VtkSeries
+{
+    FILE *p_pvd;                 //!< .pvd series of the particle frames
+    FILE *p_pvd_contacts;        //!< .pvd series of the contact network frames, NULL if not written
+    size_t num_frames;           //!< number of frames written
+    void *buffer;                //!< conversion buffer
+    size_t capacity;             //!< size of the conversion buffer in bytes
+};
+
+/**
+ * @brief Description of a data array appended to a VTU file
+ * 
+ */
+struct VtkArray
+{
+    const char *type;            //!< VTK data type, e.g. "Float32"
+    const char *name;            //!< name of the array
+    size_t ncomp;                //!< number of components
+    size_t size;                 //!< size of the data in bytes
+};
+
+/**
+ * @brief Struct to store the state of the adaptive trajectory cadence, see @ref output_frame_due
+ * 
+ */
+struct OutputSchedule
+{
+    size_t step_last;       //!< time step of the last frame
+    double disp_max;        //!< upper bound of the largest particle displacement since the last frame
+};
+
+/**
+ * @brief Copy of the particle data of one time step, handed from the time loop to the output writer
+ * 
+ */
+struct Snapshot
+{
+    size_t step;            //!< time step
+    size_t phase;           //!< index of the active phase
+    double time;            //!< time
+    double Ekin, Epot;      //!< kinetic and potential energy
+    size_t num_contacts;    //!< number of particle-particle contacts
+    unsigned int tasks;     //!< output to produce, see OUTPUT_TASK_STATUS etc.
+    unsigned int analyses;  //!< analyses that sample the snapshot (bit k for analysis k), fixed when it is published
+    size_t num_part;        //!< number of particles
+    double *radius;         //!< radii
+    struct Vec3D *r;        //!< positions
+    struct Vec3D *v;        //!< velocities
+    struct Vec3D *omega;    //!< angular velocities, only if stored in the trajectory
+    struct Vec3D *f;        //!< forces, only if stored in the trajectory
+    struct SymTensor *stress; //!< contact stress per particle, only for analyses with SNAPSHOT_FIELD_STRESS
+    struct Image3D *image;  //!< periodic images, only for analyses with SNAPSHOT_FIELD_IMAGE
+    int *type;              //!< particle types
+    struct Pair *contacts;  //!< particle pairs in contact, only for VTU frames with vtk_contacts
+    double *fn_sq, *ft_sq;  //!< squared normal and tangential forces of the contacts
+    struct Vec3D *fij;      //!< contact forces on particle i of the pairs
+    size_t num_contacts_max; //!< number of contacts allocated
+    struct Pair *nbrs;      //!< neighbor list pairs with their current connecting vectors, only for analyses with SNAPSHOT_FIELD_NBRS
+    size_t num_nbrs;        //!< number of neighbor list pairs
+    size_t num_nbrs_max;    //!< number of neighbor list pairs allocated
+};
+
+/**
+ * @brief An in-situ analysis (observer). It samples read-only snapshots with its own cadence, keeps its
+ * results in state allocated once at registration, and writes them at the end of the run, see analysis.h
+ * 
+ */
+struct Analysis
+{
+    const char *name;       //!< name used in messages
+    size_t num_dt;          //!< number of time steps between samples, 0: no samples during the run
+    bool final;             //!< also sample the final state of the run
+    unsigned int fields;    //!< snapshot fields needed besides r, radius, v and type: TRAJ_FIELD_OMEGA, TRAJ_FIELD_FORCE, SNAPSHOT_FIELD_STRESS, SNAPSHOT_FIELD_NBRS and/or SNAPSHOT_FIELD_IMAGE
+    bool contacts;          //!< the snapshots must contain the particle-particle contacts
+    void *state;            //!< preallocated state, owned by the analysis
+    size_t num_samples;     //!< number of snapshots sampled
+    void (*sample)(struct Analysis *p_analysis, struct Parameters *p_parameters, const struct Snapshot *p_snap); //!< add one snapshot
+    void (*finish)(struct Analysis *p_analysis, struct Parameters *p_parameters); //!< merge the samples and write the results
+    void (*free)(void *state); //!< free the state
+    void (*merge)(struct Analysis *p_analysis, const struct Analysis *p_other); //!< add the samples of another instance registered with the same parameters, NULL if the results depend on the order of the samples
+};
+
+/**
+ * @brief The analyses of a run
+ * 
+ */
+struct AnalysisSet
+{
+    size_t num;                                //!< number of registered analyses
+    struct Analysis analyses[ANALYSIS_NUM_MAX]; //!< registered analyses
+    unsigned int fields;                       //!< union of the fields the analyses need
+    bool contacts;                             //!< some analysis needs the contacts
+};
+
+/**
+ * @brief State of a volume fraction profile analysis: radial (around the cylinder axis) and axial bins,
+ * see profiles.h
+ * 
+ */
+struct ProfileState
+{
+    size_t num_bins_r, num_bins_z; //!< number of radial and axial bins
+    double dr, dz;                 //!< bin widths; radial bins cover 0..R_cyl, axial bins 0..L.z
+    double *vol_r, *vol_z;         //!< particle volume per bin of the current snapshot
+    size_t *count_r;               //!< number of particle centres per radial bin of the current snapshot
+    double *vol_r_tot, *vol_z_tot; //!< geometric volumes of the bins
+    double *phi_r_sum, *phi_z_sum; //!< volume fractions summed over the snapshots
+    double *count_r_sum;           //!< counts per radial bin summed over the snapshots
+    double solid_vol_sum;          //!< total particle volume summed over the snapshots
+    size_t num_part_sum;           //!< number of particles summed over the snapshots
+    const char *filename_r;        //!< output file of the radial profile
+    const char *filename_z;        //!< output file of the axial profile, NULL if not written
+    const char *column;            //!< name of the volume fraction column
+};
+
+/**
+ * @brief State of the coarse-grained fields analysis, see coarsegrain.h
+ * 
+ */
+struct CoarseGrainState
+{
+    enum CgGrid grid;       //!< grid type
+    struct Index3D size;    //!< number of nodes in each direction; RZ grids use i (radial) and k (axial), j = 1
+    struct Vec3D lo;        //!< lower corner of the grid; the radial coordinate of RZ grids starts at the axis
+    struct Vec3D h;         //!< node spacing; nodes are at the centres of the grid cells
+    struct Vec3D axis;      //!< x and y of the axis of RZ grids
+    double width;           //!< cutoff radius of the smoothing kernel
+    double density;         //!< particle mass density
+    size_t num_nodes;       //!< number of nodes
+    double *sum;            //!< CG_NUM_SUMS sums per node of the current snapshot
+    double *sum_total;      //!< sums accumulated over all snapshots
+    FILE *fp;               //!< fields of every snapshot
+};
+
+/**
+ * @brief State of the contact network analysis, see contactnet.h
+ * 
+ */
+struct ContactNetState
+{
+    size_t num_part;        //!< number of particles
+    unsigned int *z;        //!< number of contacts per particle of the current snapshot
+    size_t *parent;         //!< union-find forest over the particles, linked by strong contacts
+    size_t *size;           //!< number of particles of the trees with a root at this particle
+    double *z_sum;          //!< summed coordination distribution, contacts 0..CONTACTNET_Z_MAX
+    size_t fn_num_bins;     //!< number of bins of the normal force distribution
+    double fn_max;          //!< upper end of the normal force distribution in units of the mean
+    double *fn_sum;         //!< summed normal force distribution
+    FILE *fp;               //!< time series of the network statistics
+};
+
+/**
+ * @brief Struct to store data for a histogram
+ * 
+ */
+struct Histogram
+{
+    size_t nbins;               //!< Number of bins
+    double min, max;            //!< Range in speed units
+    double bin_width;           //!< Width of the bins
+    size_t *counts;             //!< Counts per bin
+    double *bin_centers;        //!< Center bins
+    double total_counts;        //!< Total samples added
+    double delta;               //!< Change in velocity
+};
+
+/**
+ * @brief Sums of one group of the velocity distribution analysis
+ * 
+ */
+struct VelDistGroup
+{
+    struct Histogram component[3]; //!< distributions of vx, vy and vz
+    struct Histogram speed;        //!< distribution of the speed
+    double num;                    //!< number of sampled particle velocities
+    double mass;                   //!< sum of the masses
+    struct Vec3D momentum;         //!< sum of m v
+    double m_v_sq;                 //!< sum of m v^2
+};
+
+/**
+ * @brief State of the velocity distribution analysis, see veldist.h
+ * 
+ */
+struct VelDistState
+{
+    enum VelDistSplit split;       //!< grouping of the particles
+    size_t num_groups;             //!< number of groups
+    double r_max;                  //!< outer radius of the annuli of VELDIST_SPLIT_REGION
+    struct VelDistGroup *groups;   //!< distributions per group
+};
+
+/**
+ * @brief State of the radial distribution function analysis, see rdf.h
+ * 
+ */
+struct RdfState
+{
+    size_t num_bins;            //!< number of bins
+    double r_max;               //!< range
+    bool use_nbrlist;           //!< bin the neighbor list pairs instead of a cell-list pass
+    double *pairs;              //!< summed number of neighbors per bin (every pair counts for both particles)
+    double rho_sum;             //!< summed local number densities of the reference particles
+    struct Index3D size_density; //!< number of density cells in each direction
+    struct Vec3D density_cell;  //!< edges of the density cells
+    size_t *density_count;      //!< number of particles per density cell of the current snapshot
+    struct Index3D size_grid;   //!< number of cells of the cell list of the long-range pass in each direction
+    size_t *head;               //!< first particle per cell of the long-range pass, SIZE_MAX if empty
+    size_t *list;               //!< next particle in the same cell, SIZE_MAX at the end
+};
+
+/**
+ * @brief State of the multi-tau MSD and VACF correlators, see correlator.h. Sample buffers are indexed
+ * [level][particle][slot], the sums [group][level][lag].
+ * 
+ */
+struct CorrelatorState
+{
+    size_t num_part;        //!< number of particles
+    size_t num_groups;      //!< number of particle groups
+    size_t num_levels;      //!< number of levels
+    size_t p;               //!< number of lags (and buffered samples) per level
+    size_t m;               //!< number of samples of a level averaged into one of the next level
+    struct Vec3D *pos;      //!< unwrapped positions of the last p samples per level and particle
+    struct Vec3D *vel;      //!< velocities (block averages above level 0) of the last p samples per level and particle
+    struct Vec3D *vel_acc;  //!< velocities summed per level and particle for the next level
+    struct Vec3D *unwrapped; //!< unwrapped positions of the current snapshot
+    struct Vec3D *vel_next; //!< block-averaged velocities passed to the next level
+    size_t *num_inserted;   //!< number of samples inserted per level
+    double *slot_time;      //!< time of the buffered samples per level
+    double *lag_time;       //!< summed lag times per level and lag
+    double *lag_count;      //!< number of summed lag times per level and lag
+    double *msd;            //!< summed squared displacements per group, level and lag
+    double *vacf;           //!< summed velocity products per group, level and lag
+    double *num_corr;       //!< number of products per group, level and lag
+};
+
+/**
+ * @brief State of the contact stress analysis, see stress.h
+ * 
+ */
+struct StressState
+{
+    FILE *fp;               //!< time series of the stress tensor
+    struct SymTensor sum;   //!< sum of the sampled stress tensors
+    size_t num_samples;     //!< number of samples in sum
+    size_t num_x, num_y;    //!< number of columns in x and y of the footprint of the packing
+    double cell;            //!< edge length of the columns
+    double *h;              //!< top of the highest particle per column, 0 if empty
+    size_t *touched;        //!< columns with a particle, reset before the next sample
+    size_t num_touched;     //!< number of touched columns
+};
+
+/**
+ * @brief State of the free-surface height map analysis, see heightmap.h
+ * 
+ */
+struct HeightMapState
+{
+    size_t num_x, num_y;    //!< number of columns in x and y
+    double cell;            //!< edge length of the columns
+    struct Vec3D axis;      //!< x and y of the axis of the pile
+    double *h;              //!< surface height (top of the highest particle) per column, 0 if empty
+    size_t *touched;        //!< columns with a particle, reset before the next snapshot
+    size_t num_touched;     //!< number of touched columns
+    size_t *bin;            //!< radial bin of every column
+    size_t num_bins;        //!< number of radial bins
+    size_t *num_columns;    //!< number of columns per radial bin
+    double *h_r;            //!< azimuthally averaged surface height per radial bin
+    double *coverage;       //!< fraction of covered columns per radial bin
+    double h_peak;          //!< peak of h_r of the last snapshot
+    double R_runout;        //!< runout radius of the last snapshot
+    double slope;           //!< slope angle (rad) of the surface of the last snapshot
+    size_t step;            //!< time step of the last snapshot
+    FILE *fp_runout;        //!< time series of h_peak, R_runout and slope
+    FILE *fp_profile;       //!< time series of h_r
+};
+
+/**
+ * @brief Struct to store the output pipeline: a single-producer single-consumer ring of snapshot buffers
+ * filled by the time loop and written by a writer thread
+ * 
+ */
+struct OutputPipeline
+{
+    bool async;                       //!< if false snapshots are written directly by the time loop
+    enum OutputBackpressure backpressure; //!< behaviour when the ring is full
+    size_t num_slots;                 //!< number of snapshot buffers in the ring
+    struct Snapshot *slots;           //!< snapshot buffers
+    atomic_size_t head;               //!< number of snapshots published by the time loop
+    atomic_size_t tail;               //!< number of snapshots finished by the writer
+    atomic_bool writer_waiting;       //!< writer sleeps until a snapshot is published
+    atomic_bool producer_waiting;     //!< time loop sleeps until a buffer is free
+    atomic_bool stop;                 //!< asks the writer to finish
+    size_t num_dropped_frames;        //!< number of trajectory frames dropped because the ring was full
+    size_t num_dropped_archives;      //!< number of archive snapshots dropped because the ring was full
+    size_t num_dropped_status;        //!< number of status lines dropped because the ring was full
+    pthread_t thread;                 //!< writer thread
+    pthread_mutex_t mutex;            //!< only used to sleep and wake up
+    pthread_cond_t cond;              //!< only used to sleep and wake up
+    struct Parameters *p_parameters;  //!< parameters (only members that do not change during the run are used)
+    struct AnalysisSet *p_analyses;   //!< analyses sampled by the writer, see OUTPUT_TASK_ANALYSIS
+    struct Trajectory traj;           //!< trajectory written by the writer
+    struct VtkSeries vtk;             //!< VTU series written by the writer
 };
 
 /**
@@ -100,11 +975,8 @@ struct Vectors
     struct Vec3D *omega; //!< angular-velocity */
     struct Vec3D *f;     //!< forces
     struct Vec3D *T;     //!< torques
-    double *hist_vol_r;    // accumulated particle volume per radial bin
-    double *hist_vol_z;    // accumulated particle volume per axial bin
-    size_t hist_num_bins_r;
-    size_t hist_num_bins_z;
-    size_t hist_samples;   // number of samples accumulated
+    struct SymTensor *stress; //!< contact stress per particle, set by @ref calculate_forces on steps an analysis samples it, NULL if none does
+    struct Image3D *image; //!< periodic images, counted by @ref boundary_conditions; unwrapped position: r + image * L
 };
 
 /**
@@ -142,6 +1014,8 @@ struct Nbrlist
     struct DeltaR *dr;             //!< displacements particles with respect to nbrlist creation time
     size_t *nbr_cnt;               //!< counts number of neighbors of i with j<i. Used for sorting.
     //    size_t *nbr_cnt_tmp;  //!< counts number of neighbors of i with j<i. Used for sorting.
+    size_t num_builds;             //!< number of builds since allocation
+    size_t num_allocs;             //!< number of (re)allocations of the lists since allocation
 };
 
 /**
@@ -158,6 +1032,8 @@ struct Colllist
     struct Pair *nbr_tmp;          //!< collision list for internal use
     struct DeltaR *tij;            //!< tangential displacements of pairs in collision list
     struct DeltaR *tij_tmp;        //!< tangential displacements for internal use
+    double *fn_sq, *ft_sq;         //!< squared normal and tangential contact forces of the pairs, set by @ref calculate_forces_pp
+    struct Vec3D *fij;             //!< contact force on particle i of the pair exerted by j, set by @ref calculate_forces_pp
     size_t num_w;                  //!< number of collisions with wall
     size_t num_w_max;              //!< maximum number of array members allocated
     size_t *indcs_w;               //!< particle indices that experience a wall collision
@@ -168,21 +1044,101 @@ struct Colllist
     struct DeltaR *tiw;            //!< tangential displacement vector for wall collision
     struct DeltaR *tiw_tmp;        //!<  array with tangential displacements for internal use
     struct Vec3D *vw;              //!< local velocity of wall at collision point
+    size_t num_allocs;             //!< number of reallocations of the lists since allocation
 };
 
 /**
- * @brief Struct to store data for a histogram
+ * @brief Parts of a time step measured by the timing instrumentation, see timing.h
  * 
  */
-struct Histogram
+enum TimerSection
 {
-    size_t nbins;               //!< Number of bins
-    double min, max;            //!< Range in speed units
-    double bin_width;           //!< Width of the bins
-    size_t *counts;             //!< Counts per bin
-    double *bin_centers;        //!< Center bins
-    double total_counts;        //!< Total samples added
-    double delta;               //!< Change in velocity
+    TIMER_VELOCITIES,  //!< both half steps of update_velocities_half_dt
+    TIMER_POSITIONS,   //!< update_positions
+    TIMER_TANGENTIAL,  //!< update_tangential_displacements
+    TIMER_BOUNDARY,    //!< boundary_conditions
+    TIMER_NBRLIST,     //!< update_nbrlist, including rebuilds by build_nbrlist
+    TIMER_COLLLIST,    //!< update_colllist
+    TIMER_FORCES_PP,   //!< calculate_forces_pp
+    TIMER_FORCES_PW,   //!< calculate_forces_pw
+    TIMER_OUTPUT,      //!< publishing snapshots and writing restart files
+    TIMER_OTHER,       //!< the rest: gravity and damping, FIRE, phase changes, steady-state detection
+    TIMER_NUM_SECTIONS //!< number of sections
+};
+
+/**
+ * @brief Times and counters of the timing instrumentation, summed over steps
+ * 
+ */
+struct TimingCounts
+{
+    double seconds[TIMER_NUM_SECTIONS]; //!< wall-clock time per section
+    size_t num_steps;       //!< number of time steps
+    size_t num_builds;      //!< number of neighbor list builds
+    double num_nbrs;        //!< summed number of neighbor pairs
+    double num_contacts;    //!< summed number of particle-particle and particle-wall contacts
+    size_t num_allocs;      //!< number of (re)allocations of the neighbor and collision lists
+};
+
+/**
+ * @brief State of the timing instrumentation, see timing.h
+ * 
+ */
+struct Timing
+{
+    bool enabled;           //!< num_dt_timing > 0
+    size_t num_dt;          //!< number of time steps between rows of the time series
+    FILE *fp;               //!< time series data/timing.csv
+    double t_last;          //!< end of the last measured section (monotonic clock, s)
+    size_t phase;           //!< phase of the current time step
+    size_t step;            //!< last measured time step
+    size_t num_builds_last; //!< neighbor list builds counted so far
+    size_t num_allocs_last; //!< list (re)allocations counted so far
+    struct TimingCounts interval;                //!< sums since the last row of the time series
+    struct TimingCounts phases[NUM_PHASES_MAX];  //!< sums per phase
+};
+
+/**
+ * @brief Particle arrays exposed by @ref pbs_array
+ * 
+ */
+enum PbsArrayId
+{
+    PBS_ARRAY_POSITION,  //!< struct Vec3D per particle
+    PBS_ARRAY_VELOCITY,  //!< struct Vec3D per particle
+    PBS_ARRAY_OMEGA,     //!< struct Vec3D per particle
+    PBS_ARRAY_FORCE,     //!< struct Vec3D per particle
+    PBS_ARRAY_TORQUE,    //!< struct Vec3D per particle
+    PBS_ARRAY_RADIUS,    //!< double per particle
+    PBS_ARRAY_MASS,      //!< double per particle
+    PBS_ARRAY_TYPE,      //!< int per particle
+    PBS_ARRAY_STRESS,    //!< struct SymTensor per particle, only if an analysis samples the contact stress
+    PBS_ARRAY_IMAGE      //!< struct Image3D per particle
+};
+
+/**
+ * @brief Complete state of a simulation driven through the library API, see pbs.h
+ * 
+ */
+struct Simulation
+{
+    struct Parameters parameters;  //!< parameters, copied at creation
+    struct Vectors vectors;        //!< particle data
+    struct Nbrlist nbrlist;        //!< neighbor list
+    struct Colllist colllist;      //!< collision list
+    struct PhaseState phase_state; //!< active phase and its trigger
+    struct FireState fire;         //!< FIRE minimizer state
+    struct SteadyState steady;     //!< early-termination detector
+    struct AnalysisSet analyses;   //!< in-situ analyses, sampled by the output pipeline
+    struct OutputPipeline output;  //!< trajectory, analysis and status output
+    struct OutputSchedule schedule;//!< adaptive trajectory cadence
+    struct Checkpoint checkpoint;  //!< background restart writer, used if restart_async
+    struct Timing timing;          //!< timing instrumentation of the time step
+    size_t step;                   //!< number of the last time step
+    double Ekin, Epot;             //!< kinetic and potential energy after the last time step
+    bool cache_packing;            //!< store the packing when the settling phase ends
+    bool stopped;                  //!< the steady-state detector has ended the run
+    bool finished;                 //!< @ref pbs_finish has written the final output
 };
 
 #endif /* TYPES_MD_H_ */
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "constants.h"
+#include "structs.h"
+#include "timing.h"
+
+static const char *timing_names[TIMER_NUM_SECTIONS] = {"velocities", "positions", "tangential", "boundary", "nbrlist",
+                                                       "colllist", "forces_pp", "forces_pw", "output", "other"};
+
+static double timing_now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+}
+
+static void timing_add(struct TimingCounts *p_sum, const struct TimingCounts *p_step)
+{
+    for (int s = 0; s < TIMER_NUM_SECTIONS; ++s)
+        p_sum->seconds[s] += p_step->seconds[s];
+    p_sum->num_steps += p_step->num_steps;
+    p_sum->num_builds += p_step->num_builds;
+    p_sum->num_nbrs += p_step->num_nbrs;
+    p_sum->num_contacts += p_step->num_contacts;
+    p_sum->num_allocs += p_step->num_allocs;
+}
+
+static double timing_total(const struct TimingCounts *p_counts)
+{
+    double total = 0.0;
+    for (int s = 0; s < TIMER_NUM_SECTIONS; ++s)
+        total += p_counts->seconds[s];
+    return total;
+}
+
+// write a row of the time series and add the interval to its phase
+static void timing_close_interval(struct Timing *p_timing)
+{
+    struct TimingCounts *p_interval = &p_timing->interval;
+    if (p_interval->num_steps == 0)
+        return;
+    if (p_timing->fp)
+    {
+        double ms = 1e3 / (double)p_interval->num_steps;
+        fprintf(p_timing->fp, "%lu,%lu,%lu", (long unsigned)p_timing->step, (long unsigned)p_timing->phase,
+                (long unsigned)p_interval->num_steps);
+        for (int s = 0; s < TIMER_NUM_SECTIONS; ++s)
+            fprintf(p_timing->fp, ",%g", p_interval->seconds[s] * ms);
+        fprintf(p_timing->fp, ",%g,%lu,%g,%g,%lu\n", timing_total(p_interval) * ms, (long unsigned)p_interval->num_builds,
+                p_interval->num_nbrs / (double)p_interval->num_steps, p_interval->num_contacts / (double)p_interval->num_steps,
+                (long unsigned)p_interval->num_allocs);
+        fflush(p_timing->fp);
+    }
+    timing_add(&p_timing->phases[p_timing->phase], p_interval);
+    memset(p_interval, 0, sizeof(*p_interval));
+}
+
+void timing_init(struct Parameters *p_parameters, struct Timing *p_timing)
+{
+    memset(p_timing, 0, sizeof(*p_timing));
+    if (p_parameters->num_dt_timing == 0)
+        return;
+    p_timing->enabled = true;
+    p_timing->num_dt = p_parameters->num_dt_timing;
+    p_timing->fp = fopen("data/timing.csv", "w");
+    if (p_timing->fp == NULL)
+    {
+        fprintf(stderr, "Error: cannot open data/timing.csv for writing\n");
+        return;
+    }
+    fprintf(p_timing->fp, "step,phase,steps");
+    for (int s = 0; s < TIMER_NUM_SECTIONS; ++s)
+        fprintf(p_timing->fp, ",%s_ms", timing_names[s]);
+    fprintf(p_timing->fp, ",total_ms,builds,nbrs,contacts,allocs\n");
+}
+
+void timing_start_step(struct Timing *p_timing, size_t phase)
+{
+    if (!p_timing->enabled)
+        return;
+    if (phase >= NUM_PHASES_MAX)
+        phase = NUM_PHASES_MAX - 1;
+    if (phase != p_timing->phase) // every row belongs to one phase
+        timing_close_interval(p_timing);
+    p_timing->phase = phase;
+    p_timing->t_last = timing_now();
+}
+
+void timing_lap(struct Timing *p_timing, enum TimerSection section)
+{
+    if (p_timing == NULL || !p_timing->enabled)
+        return;
+    double t = timing_now();
+    p_timing->interval.seconds[section] += t - p_timing->t_last;
+    p_timing->t_last = t;
+}
+
+void timing_end_step(struct Timing *p_timing, size_t step, const struct Nbrlist *p_nbrlist, const struct Colllist *p_colllist)
+{
+    if (!p_timing->enabled)
+        return;
+    size_t num_allocs = p_nbrlist->num_allocs + p_colllist->num_allocs;
+    struct TimingCounts *p_interval = &p_timing->interval;
+    p_interval->num_steps++;
+    // the counters restart when the lists are reallocated, e.g. by loading a restart file
+    if (p_nbrlist->num_builds >= p_timing->num_builds_last)
+        p_interval->num_builds += p_nbrlist->num_builds - p_timing->num_builds_last;
+    if (num_allocs >= p_timing->num_allocs_last)
+        p_interval->num_allocs += num_allocs - p_timing->num_allocs_last;
+    p_interval->num_nbrs += (double)p_nbrlist->num_nbrs;
+    p_interval->num_contacts += (double)(p_colllist->num_nbrs + p_colllist->num_w);
+    p_timing->num_builds_last = p_nbrlist->num_builds;
+    p_timing->num_allocs_last = num_allocs;
+    p_timing->step = step;
+    if (step % p_timing->num_dt == 0)
+        timing_close_interval(p_timing);
+}
+
+void timing_finish(struct Timing *p_timing)
+{
+    if (!p_timing->enabled)
+        return;
+    timing_close_interval(p_timing); // steps after the last row
+    FILE *fp = fopen("data/timing_summary.csv", "w");
+    if (fp == NULL)
+        fprintf(stderr, "Error: cannot open data/timing_summary.csv for writing\n");
+    else
+    {
+        fprintf(fp, "phase,steps");
+        for (int s = 0; s < TIMER_NUM_SECTIONS; ++s)
+            fprintf(fp, ",%s_s", timing_names[s]);
+        fprintf(fp, ",total_s,ms_per_step,builds,nbrs,contacts,allocs\n");
+    }
+
+    printf("\nTiming per phase (ms per step, share of the step in %%)\n");
+    printf("%-12s", "section");
+    for (size_t k = 0; k < NUM_PHASES_MAX; ++k)
+        if (p_timing->phases[k].num_steps > 0)
+            printf("          phase %lu", (long unsigned)k);
+    printf("\n");
+    for (int s = 0; s <= TIMER_NUM_SECTIONS; ++s)
+    {
+        printf("%-12s", s < TIMER_NUM_SECTIONS ? timing_names[s] : "total");
+        for (size_t k = 0; k < NUM_PHASES_MAX; ++k)
+        {
+            const struct TimingCounts *p_phase = &p_timing->phases[k];
+            if (p_phase->num_steps == 0)
+                continue;
+            double total = timing_total(p_phase);
+            double seconds = s < TIMER_NUM_SECTIONS ? p_phase->seconds[s] : total;
+            printf(" %8.4f (%5.1f)", 1e3 * seconds / (double)p_phase->num_steps, total > 0.0 ? 100.0 * seconds / total : 0.0);
+        }
+        printf("\n");
+    }
+    for (size_t k = 0; k < NUM_PHASES_MAX; ++k)
+    {
+        const struct TimingCounts *p_phase = &p_timing->phases[k];
+        if (p_phase->num_steps == 0)
+            continue;
+        double num_steps = (double)p_phase->num_steps;
+        printf("phase %lu: %lu steps, %lu neighbor list builds, %g neighbor pairs and %g contacts per step, %lu list (re)allocations\n",
+               (long unsigned)k, (long unsigned)p_phase->num_steps, (long unsigned)p_phase->num_builds,
+               p_phase->num_nbrs / num_steps, p_phase->num_contacts / num_steps, (long unsigned)p_phase->num_allocs);
+        if (fp)
+        {
+            fprintf(fp, "%lu,%lu", (long unsigned)k, (long unsigned)p_phase->num_steps);
+            for (int s = 0; s < TIMER_NUM_SECTIONS; ++s)
+                fprintf(fp, ",%g", p_phase->seconds[s]);
+            fprintf(fp, ",%g,%g,%lu,%g,%g,%lu\n", timing_total(p_phase), 1e3 * timing_total(p_phase) / num_steps,
+                    (long unsigned)p_phase->num_builds, p_phase->num_nbrs / num_steps, p_phase->num_contacts / num_steps,
+                    (long unsigned)p_phase->num_allocs);
+        }
+    }
+    if (fp)
+        fclose(fp);
+    timing_free(p_timing);
+}
+
+void timing_free(struct Timing *p_timing)
+{
+    if (p_timing->fp)
+        fclose(p_timing->fp);
+    p_timing->fp = NULL;
+    p_timing->enabled = false;
+}
@@ -0,0 +1,59 @@
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Start the timing instrumentation if num_dt_timing > 0 and open data/timing.csv. Every row of the time series
+ * holds, over the steps since the previous row, the milliseconds per step spent in each enum TimerSection, the
+ * neighbor list builds, the mean numbers of neighbor pairs and contacts and the list (re)allocations. Sections are
+ * measured with the monotonic clock; when off, every call returns after one test.
+ *
+ * @param[in] p_parameters used members: num_dt_timing
+ * @param[out] p_timing
+ */
+void timing_init(struct Parameters *p_parameters, struct Timing *p_timing);
+
+/**
+ * @brief Start the measurement of a time step
+ *
+ * @param[in,out] p_timing
+ * @param[in] phase index of the phase the step belongs to
+ */
+void timing_start_step(struct Timing *p_timing, size_t phase);
+
+/**
+ * @brief Add the time since the start of the step or the last lap to a section
+ *
+ * @param[in,out] p_timing NULL: nothing is measured
+ * @param[in] section
+ */
+void timing_lap(struct Timing *p_timing, enum TimerSection section);
+
+/**
+ * @brief End the measurement of a time step: count the neighbor list builds, pairs, contacts and list (re)allocations,
+ * and write a row of the time series every num_dt_timing steps
+ *
+ * @param[in,out] p_timing
+ * @param[in] step time step
+ * @param[in] p_nbrlist used members: num_nbrs, num_builds, num_allocs
+ * @param[in] p_colllist used members: num_nbrs, num_w, num_allocs
+ */
+void timing_end_step(struct Timing *p_timing, size_t step, const struct Nbrlist *p_nbrlist, const struct Colllist *p_colllist);
+
+/**
+ * @brief Print the summary per phase, write it to data/timing_summary.csv and close the time series
+ *
+ * @param[in,out] p_timing
+ */
+void timing_finish(struct Timing *p_timing);
+
+/**
+ * @brief Close the time series without a summary
+ *
+ * @param[in,out] p_timing
+ */
+void timing_free(struct Timing *p_timing);
+
+#endif /* TIMING_H_ */
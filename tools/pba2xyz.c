@@ -0,0 +1,59 @@
+/**
+ * @file pba2xyz.c
+ * @brief Convert an archive (.pba) into the xyz format, optionally only the particles inside a box.
+ * 
+ * Build from the main directory: gcc -O3 -I. tools/pba2xyz.c archive.c codec.c checksum.c -o pba2xyz -lm
+ * Usage: pba2xyz archive.pba output.xyz [xlo ylo zlo xhi yhi zhi]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "structs.h"
+#include "archive.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3 && argc != 9)
+    {
+        fprintf(stderr, "Usage: %s archive.pba output.xyz [xlo ylo zlo xhi yhi zhi]\n", argv[0]);
+        return 1;
+    }
+    struct Vec3D lo, hi;
+    bool region = (argc == 9);
+    if (region)
+    {
+        lo = (struct Vec3D){atof(argv[3]), atof(argv[4]), atof(argv[5])};
+        hi = (struct Vec3D){atof(argv[6]), atof(argv[7]), atof(argv[8])};
+    }
+    struct ArchiveData data;
+    long num_part = archive_read(argv[1], TRAJ_FIELD_POSITION | TRAJ_FIELD_RADIUS | TRAJ_FIELD_VELOCITY,
+                                 region ? &lo : NULL, region ? &hi : NULL, &data);
+    if (num_part < 0)
+        return 1;
+    if (data.r == NULL)
+    {
+        fprintf(stderr, "Error: %s has no positions\n", argv[1]);
+        archive_data_free(&data);
+        return 1;
+    }
+    FILE *p_out = fopen(argv[2], "w");
+    if (p_out == NULL)
+    {
+        fprintf(stderr, "Error: cannot open %s for writing\n", argv[2]);
+        archive_data_free(&data);
+        return 1;
+    }
+    // same layout as record_trajectories_xyz: position, radius and speed
+    fprintf(p_out, "%ld\n", num_part);
+    fprintf(p_out, "time = %f\n", data.time);
+    for (long k = 0; k < num_part; k++)
+    {
+        double radius = (data.radius != NULL ? data.radius[k] : 0.0);
+        double speed = (data.v != NULL ? sqrt(data.v[k].x * data.v[k].x + data.v[k].y * data.v[k].y + data.v[k].z * data.v[k].z) : 0.0);
+        fprintf(p_out, "  C        %10.5f %10.5f %10.5f %10.5f %10.5f\n", data.r[k].x, data.r[k].y, data.r[k].z, radius, speed);
+    }
+    fclose(p_out);
+    printf("Converted %ld particles of step %lu\n", num_part, (long unsigned)data.step);
+    archive_data_free(&data);
+    return 0;
+}
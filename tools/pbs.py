@@ -0,0 +1,164 @@
+"""Drive the simulation in-process through the libpbs shared library, with numpy views of the particle arrays.
+
+Build the library from the main directory first (all sources except main.c):
+    gcc -O3 -shared -fPIC $(ls *.c | grep -v main.c) -o libpbs.so -lm -lpthread    (libpbs.dll on Windows)
+
+Example:
+    from pbs import Simulation
+    with Simulation(num_dt_steps=20000, **{"g.x": 1.0}) as sim:
+        r = sim.array("position")          # (num_part, 3) view, follows the simulation without copying
+        while sim.step(1000) == 1000:
+            print(sim.time, r[:, 2].max())
+        sim.remove_wall(2)
+        pairs, fn_sq, ft_sq = sim.contacts()
+        sim.finish()
+
+Output files are written to the working directory as configured in set_parameters.
+"""
+import ctypes
+import os
+import sys
+
+import numpy as np
+
+# element dtype and components of the arrays of enum PbsArrayId in structs.h
+ARRAYS = {
+    "position": (0, np.float64, 3), "velocity": (1, np.float64, 3), "omega": (2, np.float64, 3),
+    "force": (3, np.float64, 3), "torque": (4, np.float64, 3), "radius": (5, np.float64, 1),
+    "mass": (6, np.float64, 1), "type": (7, np.int32, 1),
+    "stress": (8, np.float64, 6),  # xx, yy, zz, xy, xz, yz; empty unless num_dt_stress > 0
+    "image": (9, np.int32, 3),  # periodic images; unwrapped position: position + image * L
+}
+PAIR = np.dtype([("i", np.uint64), ("j", np.uint64), ("rij", np.float64, 4)])  # struct Pair
+
+
+def _load_library():
+    here = os.path.dirname(os.path.abspath(__file__))
+    names = ["libpbs.dll"] if sys.platform == "win32" else ["libpbs.so", "libpbs.dylib"]
+    for directory in (here, os.path.dirname(here), os.getcwd()):
+        for name in names:
+            path = os.path.join(directory, name)
+            if os.path.exists(path):
+                return ctypes.CDLL(path)
+    raise OSError("libpbs not found, see the build command at the top of pbs.py")
+
+
+_lib = _load_library()
+_ptr, _size = ctypes.c_void_p, ctypes.c_size_t
+_dbl_p = ctypes.POINTER(ctypes.c_double)
+for _name, _res, _args in [
+    ("pbs_parameters_create", _ptr, []), ("pbs_parameters_destroy", None, [_ptr]),
+    ("pbs_parameters_set", ctypes.c_bool, [_ptr, ctypes.c_char_p, ctypes.c_double]),
+    ("pbs_parameters_get", ctypes.c_bool, [_ptr, ctypes.c_char_p, _dbl_p]),
+    ("pbs_create", _ptr, [_ptr]), ("pbs_step", _size, [_ptr, _size]), ("pbs_finish", None, [_ptr]),
+    ("pbs_destroy", None, [_ptr]), ("pbs_step_count", _size, [_ptr]), ("pbs_time", ctypes.c_double, [_ptr]),
+    ("pbs_energies", None, [_ptr, _dbl_p, _dbl_p]), ("pbs_stopped", ctypes.c_bool, [_ptr]),
+    ("pbs_parameters", _ptr, [_ptr]), ("pbs_wall_function", _ptr, [ctypes.c_char_p]),
+    ("pbs_wall_add", ctypes.c_int, [_ptr, _ptr, ctypes.c_double, ctypes.c_double, ctypes.c_double]),
+    ("pbs_wall_remove", ctypes.c_bool, [_ptr, ctypes.c_uint]),
+    ("pbs_array", _ptr, [_ptr, ctypes.c_int, ctypes.POINTER(_size)]),
+    ("pbs_contacts", _ptr, [_ptr, ctypes.POINTER(_size), ctypes.POINTER(_ptr), ctypes.POINTER(_ptr)]),
+]:
+    getattr(_lib, _name).restype = _res
+    getattr(_lib, _name).argtypes = _args
+
+
+def _view(address, dtype, count, shape):
+    """Read-only array of count elements of dtype at address, without copying."""
+    if count == 0 or not address:
+        return np.empty(shape, dtype)
+    buffer = (ctypes.c_char * (count * np.dtype(dtype).itemsize)).from_address(address)
+    array = np.frombuffer(buffer, dtype, count).reshape(shape)
+    array.flags.writeable = False
+    return array
+
+
+class Simulation:
+    """A simulation created from the defaults of set_parameters, with scalar parameters overridden by name."""
+
+    def __init__(self, **parameters):
+        handle = _lib.pbs_parameters_create()
+        try:
+            for name, value in parameters.items():
+                if not _lib.pbs_parameters_set(handle, name.encode(), float(value)):
+                    raise KeyError(f"unknown parameter {name}")
+            self._handle = _lib.pbs_create(handle)
+        finally:
+            _lib.pbs_parameters_destroy(handle)
+        if not self._handle:
+            raise RuntimeError("cannot create the simulation")
+
+    def close(self):
+        if self._handle:
+            _lib.pbs_destroy(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def parameter(self, name):
+        value = ctypes.c_double()
+        if not _lib.pbs_parameters_get(_lib.pbs_parameters(self._handle), name.encode(), value):
+            raise KeyError(f"unknown parameter {name}")
+        return value.value
+
+    def step(self, num_steps=1):
+        """Advance num_steps time steps; returns the number done (fewer once the run is stopped)."""
+        return _lib.pbs_step(self._handle, num_steps)
+
+    def finish(self):
+        """Write the final output (profiles, pile characterization, archive, restart file)."""
+        _lib.pbs_finish(self._handle)
+
+    @property
+    def step_count(self):
+        return _lib.pbs_step_count(self._handle)
+
+    @property
+    def time(self):
+        return _lib.pbs_time(self._handle)
+
+    @property
+    def stopped(self):
+        return _lib.pbs_stopped(self._handle)
+
+    def energies(self):
+        Ekin, Epot = ctypes.c_double(), ctypes.c_double()
+        _lib.pbs_energies(self._handle, Ekin, Epot)
+        return Ekin.value, Epot.value
+
+    def add_wall(self, model, e_n, e_t, muf):
+        """Add a wall model of walls.h ("bottom", "top" or "cylindrical"); returns its index."""
+        function = _lib.pbs_wall_function(model.encode())
+        if not function:
+            raise KeyError(f"unknown wall model {model}")
+        index = _lib.pbs_wall_add(self._handle, function, e_n, e_t, muf)
+        if index < 0:
+            raise RuntimeError("too many walls")
+        return index
+
+    def remove_wall(self, index):
+        if not _lib.pbs_wall_remove(self._handle, index):
+            raise IndexError(f"no wall {index}")
+
+    def array(self, name):
+        """Read-only view of a particle array; it stays valid and up to date until close()."""
+        array_id, dtype, ncomp = ARRAYS[name]
+        num = _size()
+        address = _lib.pbs_array(self._handle, array_id, num)
+        n = num.value
+        return _view(address, dtype, n * ncomp, (n, ncomp) if ncomp > 1 else (n,))
+
+    def contacts(self):
+        """Read-only views (pairs, fn_sq, ft_sq) of the particle-particle contacts, valid until the next step()."""
+        num, fn_sq, ft_sq = _size(), _ptr(), _ptr()
+        address = _lib.pbs_contacts(self._handle, num, fn_sq, ft_sq)
+        n = num.value
+        return (_view(address, PAIR, n, (n,)), _view(fn_sq.value, np.float64, n, (n,)),
+                _view(ft_sq.value, np.float64, n, (n,)))
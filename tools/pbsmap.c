@@ -0,0 +1,384 @@
+/**
+ * @file pbsmap.c
+ * @brief Memory-mapped reader for binary trajectories and restart files, see pbsmap.h.
+ * 
+ * Build from the main directory as shared library:
+ * gcc -O3 -shared -fPIC -I. tools/pbsmap.c checksum.c -o libpbsmap.so (pbsmap.dll on Windows)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "constants.h"
+#include "structs.h"
+#include "checksum.h"
+#include "pbsmap.h"
+
+// Order of the field blocks in a frame and the number of components of each field, as in trajectory.c
+static const uint32_t pbsmap_field_order[] = {TRAJ_FIELD_POSITION, TRAJ_FIELD_RADIUS, TRAJ_FIELD_VELOCITY,
+                                              TRAJ_FIELD_OMEGA, TRAJ_FIELD_FORCE};
+static const size_t pbsmap_field_ncomp[] = {3, 1, 3, 3, 3};
+#define PBSMAP_NUM_FIELDS (sizeof(pbsmap_field_order) / sizeof(pbsmap_field_order[0]))
+
+static size_t pbsmap_padded(size_t num, size_t size_elem)
+{
+    return (num * size_elem + 7) & ~(size_t)7;
+}
+
+static bool pbsmap_map(const char *filename, struct MappedFile *p_file)
+{
+    memset(p_file, 0, sizeof(*p_file));
+#ifdef _WIN32
+    HANDLE handle_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle_file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    HANDLE handle_map = NULL;
+    if (!GetFileSizeEx(handle_file, &size) || size.QuadPart == 0 ||
+        (handle_map = CreateFileMappingA(handle_file, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL)
+    {
+        CloseHandle(handle_file);
+        return false;
+    }
+    p_file->data = (const uint8_t *)MapViewOfFile(handle_map, FILE_MAP_READ, 0, 0, 0);
+    if (p_file->data == NULL)
+    {
+        CloseHandle(handle_map);
+        CloseHandle(handle_file);
+        return false;
+    }
+    p_file->size = (size_t)size.QuadPart;
+    p_file->handle_file = handle_file;
+    p_file->handle_map = handle_map;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (data == MAP_FAILED)
+        return false;
+    p_file->data = (const uint8_t *)data;
+    p_file->size = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+static void pbsmap_unmap(struct MappedFile *p_file)
+{
+    if (p_file->data == NULL)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(p_file->data);
+    CloseHandle(p_file->handle_map);
+    CloseHandle(p_file->handle_file);
+#else
+    munmap((void *)p_file->data, p_file->size);
+#endif
+    memset(p_file, 0, sizeof(*p_file));
+}
+
+// Frame offsets from the index written at close; false if the file has no valid index
+static bool pbsmap_traj_index(struct MappedTrajectory *p_traj)
+{
+    const struct MappedFile *p_file = &p_traj->file;
+    size_t size_header = sizeof(struct TrajFileHeader);
+    if (p_file->size < size_header + sizeof(uint64_t) + sizeof(struct TrajTrailer))
+        return false;
+    const struct TrajTrailer *p_trailer = (const struct TrajTrailer *)(p_file->data + p_file->size - sizeof(struct TrajTrailer));
+    if (memcmp(p_trailer->magic, TRAJ_END_MAGIC, sizeof(TRAJ_END_MAGIC)) != 0 || p_trailer->offset_index < size_header ||
+        p_trailer->offset_index % 8 != 0 || p_trailer->offset_index > p_file->size - sizeof(struct TrajTrailer) - sizeof(uint64_t))
+        return false;
+    uint64_t num_frames = *(const uint64_t *)(p_file->data + p_trailer->offset_index);
+    if (num_frames != (p_file->size - sizeof(struct TrajTrailer) - p_trailer->offset_index - sizeof(uint64_t)) / sizeof(uint64_t))
+        return false;
+    p_traj->num_frames = num_frames;
+    p_traj->frame_offset = (const uint64_t *)(p_file->data + p_trailer->offset_index + sizeof(uint64_t));
+    return true;
+}
+
+// Frame offsets of a file without index, found by stepping from frame header to frame header
+static void pbsmap_traj_scan(struct MappedTrajectory *p_traj)
+{
+    const struct MappedFile *p_file = &p_traj->file;
+    size_t num_max = 0;
+    uint64_t offset = sizeof(struct TrajFileHeader);
+    while (offset + sizeof(struct TrajFrameHeader) <= p_file->size)
+    {
+        const struct TrajFrameHeader *p_frame = (const struct TrajFrameHeader *)(p_file->data + offset);
+        if ((memcmp(p_frame->magic, TRAJ_FRAME_MAGIC, sizeof(p_frame->magic)) != 0 &&
+             memcmp(p_frame->magic, TRAJ_DELTA_MAGIC, sizeof(p_frame->magic)) != 0) ||
+            p_frame->size_frame < sizeof(struct TrajFrameHeader) || p_frame->size_frame > p_file->size - offset)
+            break; // end of the frames or truncated last frame
+        if (p_traj->num_frames == num_max)
+        {
+            num_max = (num_max == 0 ? 1024 : 2 * num_max);
+            p_traj->frame_offset_scan = (uint64_t *)realloc(p_traj->frame_offset_scan, num_max * sizeof(uint64_t));
+        }
+        p_traj->frame_offset_scan[p_traj->num_frames++] = offset;
+        offset += p_frame->size_frame;
+    }
+    p_traj->frame_offset = p_traj->frame_offset_scan;
+}
+
+struct MappedTrajectory *pbsmap_traj_open(const char *filename)
+{
+    struct MappedTrajectory *p_traj = (struct MappedTrajectory *)calloc(1, sizeof(struct MappedTrajectory));
+    if (!pbsmap_map(filename, &p_traj->file))
+    {
+        fprintf(stderr, "Error: cannot map %s\n", filename);
+        free(p_traj);
+        return NULL;
+    }
+    const struct TrajFileHeader *p_header = (const struct TrajFileHeader *)p_traj->file.data;
+    if (p_traj->file.size < sizeof(*p_header) || memcmp(p_header->magic, TRAJ_MAGIC, sizeof(TRAJ_MAGIC)) != 0 ||
+        p_header->endian_tag != TRAJ_ENDIAN_TAG || p_header->size_header != sizeof(*p_header) || p_header->version > TRAJ_VERSION ||
+        (p_header->size_real != sizeof(float) && p_header->size_real != sizeof(double)))
+    {
+        fprintf(stderr, "Error: %s is not a binary trajectory of this version and byte order\n", filename);
+        pbsmap_traj_close(p_traj);
+        return NULL;
+    }
+    p_traj->header = p_header;
+    if (!pbsmap_traj_index(p_traj))
+        pbsmap_traj_scan(p_traj);
+    return p_traj;
+}
+
+void pbsmap_traj_close(struct MappedTrajectory *p_traj)
+{
+    if (p_traj == NULL)
+        return;
+    pbsmap_unmap(&p_traj->file);
+    free(p_traj->frame_offset_scan);
+    free(p_traj);
+}
+
+uint64_t pbsmap_traj_num_frames(const struct MappedTrajectory *p_traj)
+{
+    return p_traj->num_frames;
+}
+
+uint64_t pbsmap_traj_num_part(const struct MappedTrajectory *p_traj)
+{
+    return p_traj->header->num_part;
+}
+
+uint32_t pbsmap_traj_fields(const struct MappedTrajectory *p_traj)
+{
+    return p_traj->header->fields;
+}
+
+uint32_t pbsmap_traj_size_real(const struct MappedTrajectory *p_traj)
+{
+    return p_traj->header->size_real;
+}
+
+const struct TrajFrameHeader *pbsmap_traj_frame(const struct MappedTrajectory *p_traj, uint64_t index)
+{
+    if (index >= p_traj->num_frames)
+        return NULL;
+    uint64_t offset = p_traj->frame_offset[index];
+    if (offset > p_traj->file.size - sizeof(struct TrajFrameHeader))
+        return NULL;
+    const struct TrajFrameHeader *p_frame = (const struct TrajFrameHeader *)(p_traj->file.data + offset);
+    if (p_frame->size_frame < sizeof(struct TrajFrameHeader) || p_frame->size_frame > p_traj->file.size - offset)
+        return NULL;
+    return p_frame;
+}
+
+uint64_t pbsmap_traj_step(const struct MappedTrajectory *p_traj, uint64_t index)
+{
+    const struct TrajFrameHeader *p_frame = pbsmap_traj_frame(p_traj, index);
+    return (p_frame != NULL ? p_frame->step : 0);
+}
+
+double pbsmap_traj_time(const struct MappedTrajectory *p_traj, uint64_t index)
+{
+    const struct TrajFrameHeader *p_frame = pbsmap_traj_frame(p_traj, index);
+    return (p_frame != NULL ? p_frame->time : 0.0);
+}
+
+int pbsmap_traj_is_keyframe(const struct MappedTrajectory *p_traj, uint64_t index)
+{
+    const struct TrajFrameHeader *p_frame = pbsmap_traj_frame(p_traj, index);
+    if (p_frame == NULL)
+        return -1;
+    return memcmp(p_frame->magic, TRAJ_FRAME_MAGIC, sizeof(p_frame->magic)) == 0;
+}
+
+const void *pbsmap_traj_field(const struct MappedTrajectory *p_traj, uint64_t index, uint32_t field)
+{
+    if (pbsmap_traj_is_keyframe(p_traj, index) != 1)
+        return NULL;
+    const struct TrajFrameHeader *p_frame = pbsmap_traj_frame(p_traj, index);
+    size_t num_part = p_traj->header->num_part, size_real = p_traj->header->size_real;
+    size_t offset = sizeof(struct TrajFrameHeader);
+    for (size_t ifield = 0; ifield < PBSMAP_NUM_FIELDS; ++ifield)
+    {
+        if (!(p_frame->fields & pbsmap_field_order[ifield]))
+            continue;
+        size_t size = pbsmap_padded(num_part * pbsmap_field_ncomp[ifield], size_real);
+        if (pbsmap_field_order[ifield] == field)
+            return (offset + size <= p_frame->size_frame ? (const uint8_t *)p_frame + offset : NULL);
+        offset += size;
+    }
+    return NULL;
+}
+
+int pbsmap_traj_delta(const struct MappedTrajectory *p_traj, uint64_t index, uint64_t *p_num_moved, double *p_quantum,
+                      const uint32_t **p_ids, const int32_t **p_positions)
+{
+    if (pbsmap_traj_is_keyframe(p_traj, index) != 0)
+        return -1;
+    const struct TrajFrameHeader *p_frame = pbsmap_traj_frame(p_traj, index);
+    if (p_frame->size_frame < sizeof(*p_frame) + sizeof(struct TrajDeltaHeader))
+        return -1;
+    const uint8_t *p = (const uint8_t *)p_frame + sizeof(*p_frame);
+    const struct TrajDeltaHeader *p_delta = (const struct TrajDeltaHeader *)p;
+    size_t num_moved = p_delta->num_moved;
+    if (num_moved > p_traj->header->num_part ||
+        sizeof(*p_frame) + sizeof(*p_delta) + pbsmap_padded(num_moved, sizeof(uint32_t)) +
+                pbsmap_padded(3 * num_moved, sizeof(int32_t)) > p_frame->size_frame)
+        return -1;
+    *p_num_moved = num_moved;
+    *p_quantum = p_delta->quantum;
+    *p_ids = (const uint32_t *)(p + sizeof(*p_delta));
+    *p_positions = (const int32_t *)(p + sizeof(*p_delta) + pbsmap_padded(num_moved, sizeof(uint32_t)));
+    return 0;
+}
+
+int pbsmap_traj_advance(const struct MappedTrajectory *p_traj, uint64_t index, double *positions)
+{
+    size_t num_part = p_traj->header->num_part;
+    int keyframe = pbsmap_traj_is_keyframe(p_traj, index);
+    if (keyframe == 1)
+    {
+        const void *block = pbsmap_traj_field(p_traj, index, TRAJ_FIELD_POSITION);
+        if (block == NULL)
+            return -1;
+        if (p_traj->header->size_real == sizeof(double))
+            memcpy(positions, block, 3 * num_part * sizeof(double));
+        else
+            for (size_t k = 0; k < 3 * num_part; ++k)
+                positions[k] = (double)((const float *)block)[k];
+        return 0;
+    }
+    uint64_t num_moved;
+    double quantum;
+    const uint32_t *ids;
+    const int32_t *q;
+    if (keyframe != 0 || pbsmap_traj_delta(p_traj, index, &num_moved, &quantum, &ids, &q) != 0)
+        return -1;
+    for (size_t k = 0; k < num_moved; ++k)
+    {
+        if (ids[k] >= num_part)
+            return -1;
+        for (size_t icomp = 0; icomp < 3; ++icomp)
+            positions[3 * (size_t)ids[k] + icomp] = q[3 * k + icomp] * quantum;
+    }
+    return 0;
+}
+
+int pbsmap_traj_positions(const struct MappedTrajectory *p_traj, uint64_t index, double *positions)
+{
+    if (index >= p_traj->num_frames)
+        return -1;
+    uint64_t key = index;
+    while (key > 0 && pbsmap_traj_is_keyframe(p_traj, key) == 0)
+        key--;
+    for (uint64_t k = key; k <= index; ++k)
+        if (pbsmap_traj_advance(p_traj, k, positions) != 0)
+            return -1;
+    return 0;
+}
+
+struct MappedRestart *pbsmap_restart_open(const char *filename)
+{
+    struct MappedRestart *p_restart = (struct MappedRestart *)calloc(1, sizeof(struct MappedRestart));
+    if (!pbsmap_map(filename, &p_restart->file))
+    {
+        fprintf(stderr, "Error: cannot map %s\n", filename);
+        free(p_restart);
+        return NULL;
+    }
+    const struct MappedFile *p_file = &p_restart->file;
+    const struct RestartHeader *p_header = (const struct RestartHeader *)p_file->data;
+    const char *error = NULL;
+    if (p_file->size < sizeof(*p_header) || memcmp(p_header->magic, RESTART_MAGIC, sizeof(RESTART_MAGIC)) != 0)
+        error = "not a restart file of this format";
+    else if (p_header->endian_tag != RESTART_ENDIAN_TAG)
+        error = "written with a different byte order";
+    else if (p_header->version != RESTART_VERSION || p_header->size_header != sizeof(*p_header))
+        error = "unsupported version";
+    else if (p_header->size_file != p_file->size ||
+             p_header->num_sections > (p_file->size - sizeof(*p_header)) / sizeof(struct RestartSection))
+        error = "corrupt header or truncated file";
+    else
+    {
+        const struct RestartSection *table = (const struct RestartSection *)(p_file->data + sizeof(*p_header));
+        if (fnv1a_64(FNV1A_64_OFFSET, table, p_header->num_sections * sizeof(struct RestartSection)) != p_header->checksum)
+            error = "section table checksum mismatch";
+        for (size_t k = 0; k < p_header->num_sections && error == NULL; ++k)
+            if (table[k].offset > p_file->size || table[k].size_elem * table[k].num_elem > p_file->size - table[k].offset)
+                error = "section out of bounds";
+        p_restart->table = table;
+    }
+    if (error != NULL)
+    {
+        fprintf(stderr, "Error: restart file %s: %s\n", filename, error);
+        pbsmap_restart_close(p_restart);
+        return NULL;
+    }
+    p_restart->header = p_header;
+    return p_restart;
+}
+
+void pbsmap_restart_close(struct MappedRestart *p_restart)
+{
+    if (p_restart == NULL)
+        return;
+    pbsmap_unmap(&p_restart->file);
+    free(p_restart);
+}
+
+int pbsmap_restart_verify(const struct MappedRestart *p_restart)
+{
+    for (size_t k = 0; k < p_restart->header->num_sections; ++k)
+    {
+        const struct RestartSection *p_section = &p_restart->table[k];
+        if (fnv1a_64(FNV1A_64_OFFSET, p_restart->file.data + p_section->offset, p_section->size_elem * p_section->num_elem) !=
+            p_section->checksum)
+            return -1;
+    }
+    return 0;
+}
+
+const void *pbsmap_restart_section(const struct MappedRestart *p_restart, uint32_t id, uint64_t *p_num_elem, uint32_t *p_size_elem)
+{
+    for (size_t k = 0; k < p_restart->header->num_sections; ++k)
+        if (p_restart->table[k].id == id)
+        {
+            *p_num_elem = p_restart->table[k].num_elem;
+            *p_size_elem = p_restart->table[k].size_elem;
+            return p_restart->file.data + p_restart->table[k].offset;
+        }
+    *p_num_elem = 0;
+    *p_size_elem = 0;
+    return NULL;
+}
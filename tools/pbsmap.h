@@ -0,0 +1,161 @@
+#ifndef PBSMAP_H_
+#define PBSMAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file pbsmap.h
+ * @brief Read binary trajectories (.pbt) and restart files by mapping them into memory. Frames and sections are
+ * returned as pointers into the mapping, so nothing is read before it is used and nothing is copied.
+ * The pointers stay valid until the file is closed. tools/pbsmap.py wraps this library for numpy.
+ */
+
+/**
+ * @brief Map a binary trajectory and locate its frames: through the frame index of a closed file,
+ * or by stepping over the frame headers of a file without index (interrupted run)
+ * 
+ * @param[in] filename 
+ * @return struct MappedTrajectory* NULL on error
+ */
+struct MappedTrajectory *pbsmap_traj_open(const char *filename);
+
+/**
+ * @brief Unmap a trajectory
+ * 
+ * @param[in] p_traj 
+ */
+void pbsmap_traj_close(struct MappedTrajectory *p_traj);
+
+/**
+ * @brief Number of complete frames
+ * 
+ */
+uint64_t pbsmap_traj_num_frames(const struct MappedTrajectory *p_traj);
+
+/**
+ * @brief Number of particles in every frame
+ * 
+ */
+uint64_t pbsmap_traj_num_part(const struct MappedTrajectory *p_traj);
+
+/**
+ * @brief Fields stored in keyframes, see TRAJ_FIELD_POSITION etc.
+ * 
+ */
+uint32_t pbsmap_traj_fields(const struct MappedTrajectory *p_traj);
+
+/**
+ * @brief Bytes per stored real number: 4 (float) or 8 (double)
+ * 
+ */
+uint32_t pbsmap_traj_size_real(const struct MappedTrajectory *p_traj);
+
+/**
+ * @brief Header of a frame, found in O(1)
+ * 
+ * @param[in] p_traj 
+ * @param[in] index frame number
+ * @return const struct TrajFrameHeader* NULL if index is out of range
+ */
+const struct TrajFrameHeader *pbsmap_traj_frame(const struct MappedTrajectory *p_traj, uint64_t index);
+
+/**
+ * @brief Time step of a frame, 0 if index is out of range
+ * 
+ */
+uint64_t pbsmap_traj_step(const struct MappedTrajectory *p_traj, uint64_t index);
+
+/**
+ * @brief Time of a frame, 0 if index is out of range
+ * 
+ */
+double pbsmap_traj_time(const struct MappedTrajectory *p_traj, uint64_t index);
+
+/**
+ * @brief Whether a frame is a keyframe holding all particles (1) or a delta frame (0); -1 if out of range
+ * 
+ */
+int pbsmap_traj_is_keyframe(const struct MappedTrajectory *p_traj, uint64_t index);
+
+/**
+ * @brief Field block of a keyframe: num_part * ncomp reals of pbsmap_traj_size_real bytes, 8-byte aligned
+ * 
+ * @param[in] p_traj 
+ * @param[in] index frame number
+ * @param[in] field one of TRAJ_FIELD_POSITION etc.
+ * @return const void* NULL for delta frames, fields that are not stored and invalid indices
+ */
+const void *pbsmap_traj_field(const struct MappedTrajectory *p_traj, uint64_t index, uint32_t field);
+
+/**
+ * @brief Blocks of a delta frame, see @ref TrajDeltaHeader
+ * 
+ * @param[in] p_traj 
+ * @param[in] index frame number
+ * @param[out] p_num_moved number of particles in the frame
+ * @param[out] p_quantum position of a stored particle = quantum * stored integer coordinate
+ * @param[out] p_ids num_moved particle indices
+ * @param[out] p_positions num_moved * 3 integer coordinates
+ * @return int 0 if successful, -1 if the frame is not a delta frame
+ */
+int pbsmap_traj_delta(const struct MappedTrajectory *p_traj, uint64_t index, uint64_t *p_num_moved, double *p_quantum,
+                      const uint32_t **p_ids, const int32_t **p_positions);
+
+/**
+ * @brief Positions of all particles in a frame. Delta frames are applied to the preceding keyframe, so the cost
+ * grows with the distance to that keyframe (at most traj_num_frames_key frames).
+ * 
+ * @param[in] p_traj 
+ * @param[in] index frame number
+ * @param[out] positions num_part * 3 doubles
+ * @return int 0 if successful, -1 on error
+ */
+int pbsmap_traj_positions(const struct MappedTrajectory *p_traj, uint64_t index, double *positions);
+
+/**
+ * @brief Apply a delta frame to positions of the preceding frame; a keyframe replaces all positions.
+ * Used to stream through a trajectory frame by frame.
+ * 
+ * @param[in] p_traj 
+ * @param[in] index frame number
+ * @param[in,out] positions num_part * 3 doubles
+ * @return int 0 if successful, -1 on error
+ */
+int pbsmap_traj_advance(const struct MappedTrajectory *p_traj, uint64_t index, double *positions);
+
+/**
+ * @brief Map a restart file and check its header and section table (not the section checksums)
+ * 
+ * @param[in] filename 
+ * @return struct MappedRestart* NULL on error
+ */
+struct MappedRestart *pbsmap_restart_open(const char *filename);
+
+/**
+ * @brief Unmap a restart file
+ * 
+ * @param[in] p_restart 
+ */
+void pbsmap_restart_close(struct MappedRestart *p_restart);
+
+/**
+ * @brief Verify the checksums of all sections, which touches the whole file
+ * 
+ * @param[in] p_restart 
+ * @return int 0 if all sections are intact, -1 otherwise
+ */
+int pbsmap_restart_verify(const struct MappedRestart *p_restart);
+
+/**
+ * @brief Section of a restart file
+ * 
+ * @param[in] p_restart 
+ * @param[in] id section identifier, see enum RestartSectionId
+ * @param[out] p_num_elem number of elements
+ * @param[out] p_size_elem bytes per element
+ * @return const void* start of the section, 64-byte aligned; NULL if the file has no such section
+ */
+const void *pbsmap_restart_section(const struct MappedRestart *p_restart, uint32_t id, uint64_t *p_num_elem, uint32_t *p_size_elem);
+
+#endif /* PBSMAP_H_ */
@@ -0,0 +1,182 @@
+"""numpy views of binary trajectories (.pbt) and restart files through the memory-mapped reader libpbsmap.
+
+Build the library from the main directory first:
+    gcc -O3 -shared -fPIC -I. tools/pbsmap.c checksum.c -o libpbsmap.so    (pbsmap.dll on Windows)
+
+Example:
+    from pbsmap import Trajectory, Restart
+    with Trajectory("trajectories.pbt") as traj:
+        r = traj.field(0, "position")      # (num_part, 3) view into the file, no copy
+        for step, time, r in traj.positions_iter():
+            ...
+    with Restart("restart.dat") as rst:
+        v = rst.section("v")               # (num_part, 3) float64 view
+
+Arrays returned by field() and section() point into the mapping and are only valid until close().
+"""
+import ctypes
+import os
+import sys
+
+import numpy as np
+
+TRAJ_FIELDS = {"position": (0x01, 3), "radius": (0x02, 1), "velocity": (0x04, 3), "omega": (0x08, 3), "force": (0x10, 3)}
+
+# section id, dtype and components per element of restart sections, see enum RestartSectionId in structs.h
+_PAIR = np.dtype([("i", np.uint64), ("j", np.uint64), ("rij", np.float64, 4)])
+RESTART_SECTIONS = {
+    "type": (3, np.int32, 1), "radius": (4, np.float64, 1), "mass": (5, np.float64, 1),
+    "r": (6, np.float64, 3), "dr": (7, np.float64, 3), "v": (8, np.float64, 3), "omega": (9, np.float64, 3),
+    "f": (10, np.float64, 3), "T": (11, np.float64, 3), "nbr": (12, _PAIR, 1), "nbr_dr": (13, np.float64, 4),
+    "coll": (14, _PAIR, 1), "coll_tij": (15, np.float64, 4), "wall_indcs": (16, np.uint64, 1),
+    "wall_id": (17, np.uint32, 1), "wall_riw": (18, np.float64, 4), "wall_tiw": (19, np.float64, 4),
+    "wall_vw": (20, np.float64, 3), "steady_ekin": (21, np.float64, 1), "steady_v_max": (22, np.float64, 1),
+    "steady_h_max": (23, np.float64, 1), "steady_r_base": (24, np.float64, 1), "image": (25, np.int32, 3),
+}
+
+
+def _load_library():
+    here = os.path.dirname(os.path.abspath(__file__))
+    names = ["pbsmap.dll"] if sys.platform == "win32" else ["libpbsmap.so", "libpbsmap.dylib"]
+    for directory in (here, os.path.dirname(here), os.getcwd()):
+        for name in names:
+            path = os.path.join(directory, name)
+            if os.path.exists(path):
+                return ctypes.CDLL(path)
+    raise OSError("libpbsmap not found, see the build command at the top of pbsmap.py")
+
+
+_lib = _load_library()
+_u64, _u32, _ptr = ctypes.c_uint64, ctypes.c_uint32, ctypes.c_void_p
+for _name, _res, _args in [
+    ("pbsmap_traj_open", _ptr, [ctypes.c_char_p]), ("pbsmap_traj_close", None, [_ptr]),
+    ("pbsmap_traj_num_frames", _u64, [_ptr]), ("pbsmap_traj_num_part", _u64, [_ptr]),
+    ("pbsmap_traj_fields", _u32, [_ptr]), ("pbsmap_traj_size_real", _u32, [_ptr]),
+    ("pbsmap_traj_step", _u64, [_ptr, _u64]), ("pbsmap_traj_time", ctypes.c_double, [_ptr, _u64]),
+    ("pbsmap_traj_is_keyframe", ctypes.c_int, [_ptr, _u64]), ("pbsmap_traj_field", _ptr, [_ptr, _u64, _u32]),
+    ("pbsmap_traj_delta", ctypes.c_int, [_ptr, _u64, ctypes.POINTER(_u64), ctypes.POINTER(ctypes.c_double),
+                                         ctypes.POINTER(_ptr), ctypes.POINTER(_ptr)]),
+    ("pbsmap_traj_positions", ctypes.c_int, [_ptr, _u64, _ptr]), ("pbsmap_traj_advance", ctypes.c_int, [_ptr, _u64, _ptr]),
+    ("pbsmap_restart_open", _ptr, [ctypes.c_char_p]), ("pbsmap_restart_close", None, [_ptr]),
+    ("pbsmap_restart_verify", ctypes.c_int, [_ptr]),
+    ("pbsmap_restart_section", _ptr, [_ptr, _u32, ctypes.POINTER(_u64), ctypes.POINTER(_u32)]),
+]:
+    getattr(_lib, _name).restype = _res
+    getattr(_lib, _name).argtypes = _args
+
+
+def _view(address, dtype, count, shape):
+    """Array of count elements of dtype at address, without copying."""
+    if count == 0:
+        return np.empty(shape, dtype)
+    buffer = (ctypes.c_char * (count * np.dtype(dtype).itemsize)).from_address(address)
+    return np.frombuffer(buffer, dtype, count).reshape(shape)
+
+
+class Trajectory:
+    """A binary trajectory mapped into memory; frames are found in O(1)."""
+
+    def __init__(self, filename):
+        self._handle = _lib.pbsmap_traj_open(os.fsencode(filename))
+        if not self._handle:
+            raise OSError(f"cannot open trajectory {filename}")
+        self.num_part = _lib.pbsmap_traj_num_part(self._handle)
+        self.fields = _lib.pbsmap_traj_fields(self._handle)
+        self.dtype = np.float32 if _lib.pbsmap_traj_size_real(self._handle) == 4 else np.float64
+
+    def close(self):
+        if self._handle:
+            _lib.pbsmap_traj_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def __len__(self):
+        return _lib.pbsmap_traj_num_frames(self._handle)
+
+    def step(self, index):
+        return _lib.pbsmap_traj_step(self._handle, index)
+
+    def time(self, index):
+        return _lib.pbsmap_traj_time(self._handle, index)
+
+    def is_keyframe(self, index):
+        return _lib.pbsmap_traj_is_keyframe(self._handle, index) == 1
+
+    def field(self, index, name):
+        """View of a field of a keyframe, shape (num_part, 3) or (num_part,); None for delta frames."""
+        bit, ncomp = TRAJ_FIELDS[name]
+        address = _lib.pbsmap_traj_field(self._handle, index, bit)
+        if not address:
+            return None
+        shape = (self.num_part, ncomp) if ncomp > 1 else (self.num_part,)
+        return _view(address, self.dtype, self.num_part * ncomp, shape)
+
+    def delta(self, index):
+        """Views (ids, integer positions, quantum) of a delta frame; None for keyframes."""
+        num, quantum, ids, positions = _u64(), ctypes.c_double(), _ptr(), _ptr()
+        if _lib.pbsmap_traj_delta(self._handle, index, num, quantum, ids, positions) != 0:
+            return None
+        n = num.value
+        return (_view(ids.value, np.uint32, n, (n,)), _view(positions.value, np.int32, 3 * n, (n, 3)), quantum.value)
+
+    def positions(self, index):
+        """Positions of all particles as a new (num_part, 3) float64 array; delta frames are resolved."""
+        out = np.empty((self.num_part, 3), np.float64)
+        if _lib.pbsmap_traj_positions(self._handle, index, out.ctypes.data) != 0:
+            raise IndexError(f"cannot reconstruct frame {index}")
+        return out
+
+    def positions_iter(self, start=0):
+        """Yield (step, time, positions) of all frames from start on; the positions array is reused."""
+        out = self.positions(start)
+        yield self.step(start), self.time(start), out
+        for index in range(start + 1, len(self)):
+            if _lib.pbsmap_traj_advance(self._handle, index, out.ctypes.data) != 0:
+                raise IndexError(f"cannot reconstruct frame {index}")
+            yield self.step(index), self.time(index), out
+
+
+class Restart:
+    """A restart file mapped into memory; sections are returned as views."""
+
+    def __init__(self, filename, verify=False):
+        self._handle = _lib.pbsmap_restart_open(os.fsencode(filename))
+        if not self._handle:
+            raise OSError(f"cannot open restart file {filename}")
+        if verify and _lib.pbsmap_restart_verify(self._handle) != 0:
+            self.close()
+            raise OSError(f"restart file {filename} fails its checksums")
+
+    def close(self):
+        if self._handle:
+            _lib.pbsmap_restart_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def section(self, name):
+        """View of a section by name, see RESTART_SECTIONS; None if the file does not have it."""
+        section_id, dtype, ncomp = RESTART_SECTIONS[name]
+        num, size = _u64(), _u32()
+        address = _lib.pbsmap_restart_section(self._handle, section_id, num, size)
+        if not address:
+            return None
+        if size.value != np.dtype(dtype).itemsize * ncomp:
+            raise ValueError(f"section {name} has {size.value} bytes per element")
+        n = num.value
+        return _view(address, dtype, n * ncomp, (n, ncomp) if ncomp > 1 else (n,))
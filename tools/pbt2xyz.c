@@ -0,0 +1,24 @@
+/**
+ * @file pbt2xyz.c
+ * @brief Convert a binary trajectory (.pbt) into the xyz format, e.g. for viewing in Ovito or VMD.
+ * 
+ * Build from the main directory: gcc -O3 -I. tools/pbt2xyz.c trajectory.c -o pbt2xyz -lm
+ * Usage: pbt2xyz trajectories.pbt trajectories.xyz
+ */
+#include <stdio.h>
+#include "structs.h"
+#include "trajectory.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s input.pbt output.xyz\n", argv[0]);
+        return 1;
+    }
+    long num_frames = trajectory_export_xyz(argv[1], argv[2]);
+    if (num_frames < 0)
+        return 1;
+    printf("Converted %ld frames\n", num_frames);
+    return 0;
+}
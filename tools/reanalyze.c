@@ -0,0 +1,283 @@
+/**
+ * @file reanalyze.c
+ * @brief Run the in-situ analyses offline on a binary trajectory (.pbt), e.g. after adding a metric.
+ *
+ * The analyses are registered with the parameters of setparameters.c, as in the run that wrote the trajectory,
+ * and sample the frames whose time step is on their cadence (with -a: every frame). Analyses whose results do
+ * not depend on the order of the samples (profiles, velocity distributions, radial distribution function) run on
+ * worker threads: the frames are split into blocks, every block gets its own instances, and the blocks are merged
+ * in frame order, so the results do not depend on the number of threads. The other analyses (surface height map
+ * and final pile) stream through the frames in order on the main thread meanwhile. Trajectories store no contacts,
+ * contact stress or periodic images, so the analyses that need them are not available. Results go to data/.
+ *
+ * Build from the main directory:
+ * gcc -O3 -I. tools/reanalyze.c tools/pbsmap.c analysis.c profiles.c heightmap.c veldist.c rdf.c histogram.c
+ *     fileoutput.c setparameters.c walls.c checksum.c -o reanalyze -lm -lpthread
+ * Usage: reanalyze trajectories.pbt [num_threads] [-a]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "constants.h"
+#include "structs.h"
+#include "analysis.h"
+#include "setparameters.h"
+#include "profiles.h"
+#include "heightmap.h"
+#include "veldist.h"
+#include "rdf.h"
+#include "pbsmap.h"
+
+/// Upper limit of the number of blocks; the states of all blocks are kept until the merge
+#define REANALYZE_NUM_BLOCKS_MAX 256
+
+// Analysis modules that can be computed from trajectory frames; velocity: only frames that store velocities
+static const struct
+{
+    void (*register_analyses)(struct Parameters *, struct AnalysisSet *);
+    bool velocity;
+} reanalyze_modules[] = {{profiles_register, false}, {heightmap_register, false}, {veldist_register, true}, {rdf_register, false}};
+#define REANALYZE_NUM_MODULES (sizeof(reanalyze_modules) / sizeof(reanalyze_modules[0]))
+
+static void reanalyze_register(struct Reanalysis *p_run, size_t module, struct AnalysisSet *p_set)
+{
+    analysis_init(p_set);
+    reanalyze_modules[module].register_analyses(&p_run->parameters, p_set);
+    if (p_run->all_frames)
+        for (size_t k = 0; k < p_set->num; ++k)
+            if (p_set->analyses[k].num_dt > 0)
+                p_set->analyses[k].num_dt = 1;
+}
+
+// Modules with merge functions for all their analyses run in blocks on the workers
+static bool reanalyze_parallel(const struct AnalysisSet *p_set)
+{
+    for (size_t k = 0; k < p_set->num; ++k)
+        if (p_set->analyses[k].merge == NULL)
+            return false;
+    return p_set->num > 0;
+}
+
+// Copy a field block of a keyframe into doubles
+static bool reanalyze_field(const struct MappedTrajectory *p_traj, uint64_t index, uint32_t field, size_t num, double *dest)
+{
+    const void *block = pbsmap_traj_field(p_traj, index, field);
+    if (block == NULL)
+        return false;
+    if (pbsmap_traj_size_real(p_traj) == sizeof(double))
+        memcpy(dest, block, num * sizeof(double));
+    else
+        for (size_t k = 0; k < num; ++k)
+            dest[k] = (double)((const float *)block)[k];
+    return true;
+}
+
+// Decode a frame into a snapshot; positions must hold the preceding frame (or any frame for keyframes)
+static bool reanalyze_frame(struct Reanalysis *p_run, uint64_t index, struct Vec3D *r, struct Vec3D *v, struct Snapshot *p_snap)
+{
+    if (pbsmap_traj_advance(p_run->p_traj, index, (double *)r) != 0)
+        return false;
+    bool velocity = p_run->velocities && reanalyze_field(p_run->p_traj, index, TRAJ_FIELD_VELOCITY, 3 * p_run->num_part, (double *)v);
+    *p_snap = (struct Snapshot){.step = pbsmap_traj_step(p_run->p_traj, index), .time = pbsmap_traj_time(p_run->p_traj, index),
+                                .tasks = OUTPUT_TASK_ANALYSIS, .num_part = p_run->num_part, .radius = p_run->radius, .r = r,
+                                .v = velocity ? v : NULL, .type = p_run->type};
+    return true;
+}
+
+// Sample frames first..last-1 with the analyses of the modules in sets (empty sets are skipped)
+static bool reanalyze_frames(struct Reanalysis *p_run, uint64_t first, uint64_t last, struct Vec3D *r, struct Vec3D *v,
+                             struct AnalysisSet *sets)
+{
+    if (first < last && pbsmap_traj_positions(p_run->p_traj, first, (double *)r) != 0)
+        return false;
+    for (uint64_t index = first; index < last; ++index)
+    {
+        struct Snapshot snap;
+        if (!reanalyze_frame(p_run, index, r, v, &snap))
+            return false;
+        for (size_t m = 0; m < REANALYZE_NUM_MODULES; ++m)
+            if (sets[m].num > 0 && (snap.v != NULL || !reanalyze_modules[m].velocity))
+            {
+                snap.analyses = analysis_mask_due(&sets[m], snap.step);
+                analysis_sample(&sets[m], &p_run->parameters, &snap);
+            }
+    }
+    return true;
+}
+
+static void *reanalyze_worker(void *arg)
+{
+    struct Reanalysis *p_run = (struct Reanalysis *)arg;
+    struct Vec3D *r = (struct Vec3D *)malloc(p_run->num_part * sizeof(struct Vec3D));
+    struct Vec3D *v = (struct Vec3D *)malloc(p_run->num_part * sizeof(struct Vec3D));
+    if (r == NULL || v == NULL)
+        atomic_store(&p_run->failed, true);
+    while (!atomic_load(&p_run->failed))
+    {
+        size_t block = atomic_fetch_add(&p_run->next_block, 1);
+        if (block >= p_run->num_blocks)
+            break;
+        uint64_t first = block * p_run->num_frames_block;
+        uint64_t last = first + p_run->num_frames_block < p_run->num_frames ? first + p_run->num_frames_block : p_run->num_frames;
+        if (!reanalyze_frames(p_run, first, last, r, v, &p_run->blocks[block * REANALYZE_NUM_MODULES]))
+            atomic_store(&p_run->failed, true);
+    }
+    free(r);
+    free(v);
+    return NULL;
+}
+
+// Number of online processors, the default number of threads
+static long reanalyze_num_cpus(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (long)info.dwNumberOfProcessors;
+#else
+    return sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    struct Reanalysis run = {0};
+    long num_threads = reanalyze_num_cpus();
+    const char *filename = NULL;
+    for (int k = 1; k < argc; ++k)
+    {
+        if (strcmp(argv[k], "-a") == 0)
+            run.all_frames = true;
+        else if (filename == NULL)
+            filename = argv[k];
+        else
+            num_threads = atol(argv[k]);
+    }
+    if (filename == NULL || num_threads < 1)
+    {
+        fprintf(stderr, "Usage: %s trajectories.pbt [num_threads] [-a]\n", argv[0]);
+        return 1;
+    }
+    struct MappedTrajectory *p_traj = pbsmap_traj_open(filename);
+    if (p_traj == NULL)
+        return 1;
+    run.p_traj = p_traj;
+    run.num_part = pbsmap_traj_num_part(p_traj);
+    run.num_frames = pbsmap_traj_num_frames(p_traj);
+    run.velocities = (pbsmap_traj_fields(p_traj) & TRAJ_FIELD_VELOCITY) != 0;
+    run.radius = (double *)malloc(run.num_part * sizeof(double));
+    run.type = (int *)calloc(run.num_part, sizeof(int));
+    if (run.num_frames == 0 || run.radius == NULL || run.type == NULL ||
+        !reanalyze_field(p_traj, 0, TRAJ_FIELD_RADIUS, run.num_part, run.radius))
+    {
+        fprintf(stderr, "Error: %s has no frames or its first frame stores no radii\n", filename);
+        pbsmap_traj_close(p_traj);
+        return 1;
+    }
+
+    // trajectories hold neither neighbor lists nor phases: the radial distribution function takes its cell-list
+    // pass and the velocity distributions are not split by phase
+    set_parameters(&run.parameters);
+    run.parameters.num_part = run.num_part;
+    run.parameters.r_cut = 0.0;
+    if (run.parameters.veldist_split == VELDIST_SPLIT_PHASE)
+        run.parameters.veldist_split = VELDIST_SPLIT_NONE;
+
+    struct AnalysisSet sets[REANALYZE_NUM_MODULES];
+    bool parallel[REANALYZE_NUM_MODULES];
+    for (size_t m = 0; m < REANALYZE_NUM_MODULES; ++m)
+    {
+        reanalyze_register(&run, m, &sets[m]);
+        parallel[m] = reanalyze_parallel(&sets[m]);
+    }
+    run.num_blocks = run.num_frames < REANALYZE_NUM_BLOCKS_MAX ? run.num_frames : REANALYZE_NUM_BLOCKS_MAX;
+    run.num_frames_block = (run.num_frames + run.num_blocks - 1) / run.num_blocks;
+    run.num_blocks = (run.num_frames + run.num_frames_block - 1) / run.num_frames_block;
+    run.blocks = (struct AnalysisSet *)calloc(run.num_blocks * REANALYZE_NUM_MODULES, sizeof(struct AnalysisSet));
+    if (run.blocks == NULL)
+    {
+        fprintf(stderr, "Error: failed to allocate the analyses of %lu blocks\n", (long unsigned)run.num_blocks);
+        return 1;
+    }
+    for (size_t b = 0; b < run.num_blocks; ++b)
+        for (size_t m = 0; m < REANALYZE_NUM_MODULES; ++m)
+            if (parallel[m])
+                reanalyze_register(&run, m, &run.blocks[b * REANALYZE_NUM_MODULES + m]);
+    atomic_init(&run.next_block, 0);
+    atomic_init(&run.failed, false);
+
+    struct timespec t_start, t_end;
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    pthread_t *threads = (pthread_t *)malloc((size_t)num_threads * sizeof(pthread_t));
+    long num_started = 0;
+    while (threads != NULL && num_started < num_threads &&
+           pthread_create(&threads[num_started], NULL, reanalyze_worker, &run) == 0)
+        num_started++;
+    if (num_started == 0)
+        reanalyze_worker(&run);
+
+    // order-dependent modules stream through all frames here; the last frame is the final state
+    struct AnalysisSet ordered[REANALYZE_NUM_MODULES];
+    for (size_t m = 0; m < REANALYZE_NUM_MODULES; ++m)
+        ordered[m] = parallel[m] ? (struct AnalysisSet){0} : sets[m];
+    struct Vec3D *r = (struct Vec3D *)malloc(run.num_part * sizeof(struct Vec3D));
+    struct Vec3D *v = (struct Vec3D *)calloc(run.num_part, sizeof(struct Vec3D));
+    struct Snapshot snap_last;
+    bool ok = r != NULL && v != NULL && reanalyze_frames(&run, 0, run.num_frames - 1, r, v, ordered) &&
+              reanalyze_frame(&run, run.num_frames - 1, r, v, &snap_last);
+    if (ok)
+        for (size_t m = 0; m < REANALYZE_NUM_MODULES; ++m)
+            if (ordered[m].num > 0 && (snap_last.v != NULL || !reanalyze_modules[m].velocity))
+            {
+                snap_last.analyses = analysis_mask_due(&ordered[m], snap_last.step);
+                analysis_sample(&ordered[m], &run.parameters, &snap_last);
+            }
+    for (size_t m = 0; m < REANALYZE_NUM_MODULES; ++m)
+        if (!parallel[m])
+            sets[m] = ordered[m];
+    for (long k = 0; k < num_started; ++k)
+        pthread_join(threads[k], NULL);
+    free(threads);
+    if (!ok || atomic_load(&run.failed))
+    {
+        fprintf(stderr, "Error: cannot decode the frames of %s\n", filename);
+        return 1;
+    }
+
+    for (size_t m = 0; m < REANALYZE_NUM_MODULES; ++m)
+        if (parallel[m])
+            for (size_t b = 0; b < run.num_blocks; ++b)
+            {
+                analysis_merge(&sets[m], &run.blocks[b * REANALYZE_NUM_MODULES + m]);
+                analysis_free(&run.blocks[b * REANALYZE_NUM_MODULES + m]);
+            }
+    struct Vectors vectors = {0};
+    struct Colllist colllist = {0};
+    vectors.time = snap_last.time;
+    vectors.radius = run.radius;
+    vectors.r = r;
+    vectors.v = v;
+    vectors.type = run.type;
+    for (size_t m = 0; m < REANALYZE_NUM_MODULES; ++m)
+        analysis_finish(&sets[m], &run.parameters, &vectors, &colllist, snap_last.step, 0);
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    double seconds = (double)(t_end.tv_sec - t_start.tv_sec) + 1e-9 * (double)(t_end.tv_nsec - t_start.tv_nsec);
+    printf("Re-analysed %lu frames of %lu particles in %lu blocks with %ld threads in %g s\n", (long unsigned)run.num_frames,
+           (long unsigned)run.num_part, (long unsigned)run.num_blocks, num_started > 0 ? num_started : 1L, seconds);
+
+    free(r);
+    free(v);
+    free(run.blocks);
+    free(run.radius);
+    free(run.type);
+    pbsmap_traj_close(p_traj);
+    return 0;
+}
@@ -0,0 +1,368 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "trajectory.h"
+
+#define TRAJ_BUFFER_SIZE (1u << 20)
+
+// Order of the field blocks in a frame and the number of components of each field
+static const unsigned int traj_field_order[] = {TRAJ_FIELD_POSITION, TRAJ_FIELD_RADIUS, TRAJ_FIELD_VELOCITY,
+                                                TRAJ_FIELD_OMEGA, TRAJ_FIELD_FORCE};
+static const size_t traj_field_ncomp[] = {3, 1, 3, 3, 3};
+#define TRAJ_NUM_FIELDS (sizeof(traj_field_order) / sizeof(traj_field_order[0]))
+
+// Size of a block of num elements of size_elem bytes padded to a multiple of 8 bytes, so blocks stay aligned in a memory-mapped file
+static size_t traj_padded(size_t num, size_t size_elem)
+{
+    return (num * size_elem + 7) & ~(size_t)7;
+}
+
+// Size of a field block
+static size_t traj_block_size(size_t num_part, size_t ncomp, size_t size_real)
+{
+    return traj_padded(num_part * ncomp, size_real);
+}
+
+static size_t traj_frame_size(unsigned int fields, size_t num_part, size_t size_real)
+{
+    size_t size = sizeof(struct TrajFrameHeader);
+    for (size_t ifield = 0; ifield < TRAJ_NUM_FIELDS; ++ifield)
+        if (fields & traj_field_order[ifield])
+            size += traj_block_size(num_part, traj_field_ncomp[ifield], size_real);
+    return size;
+}
+
+static void traj_write(struct Trajectory *p_traj, const void *data, size_t size)
+{
+    if (fwrite(data, 1, size, p_traj->p_file) != size)
+        fprintf(stderr, "Error: writing trajectory failed\n");
+    p_traj->offset += size;
+}
+
+// Pad a block of size bytes that has just been written to a multiple of 8 bytes
+static void traj_write_padding(struct Trajectory *p_traj, size_t size)
+{
+    static const char zeros[8] = {0};
+    size_t padding = traj_padded(size, 1) - size;
+    if (padding > 0)
+        traj_write(p_traj, zeros, padding);
+}
+
+bool trajectory_open(struct Parameters *p_parameters, struct Trajectory *p_traj)
+{
+    memset(p_traj, 0, sizeof(*p_traj));
+    p_traj->format = p_parameters->traj_format;
+    if (p_traj->format != TRAJ_FORMAT_BINARY)
+        return true;
+
+    char filename[1100];
+    snprintf(filename, sizeof(filename), "%s%s", p_parameters->filename_xyz, ".pbt");
+    p_traj->p_file = fopen(filename, "wb");
+    if (p_traj->p_file == NULL)
+    {
+        fprintf(stderr, "Error: cannot open %s for writing\n", filename);
+        return false;
+    }
+    setvbuf(p_traj->p_file, NULL, _IOFBF, TRAJ_BUFFER_SIZE);
+    p_traj->fields = p_parameters->traj_fields & TRAJ_FIELD_ALL;
+    p_traj->size_real = p_parameters->traj_single_precision ? sizeof(float) : sizeof(double);
+    if (p_traj->size_real == sizeof(float))
+        p_traj->buffer = (float *)malloc(3 * p_parameters->num_part * sizeof(float));
+
+    // A stored delta coordinate is off by at most quantum/2 per component, i.e. 0.87 delta_tol in distance
+    p_traj->delta = p_parameters->traj_delta && (p_traj->fields & TRAJ_FIELD_POSITION) && p_parameters->traj_num_frames_key > 1;
+    if (p_traj->delta)
+    {
+        p_traj->num_frames_key = p_parameters->traj_num_frames_key;
+        p_traj->delta_tol = p_parameters->traj_delta_tol;
+        p_traj->quantum = p_parameters->traj_delta_tol;
+        double L_max = fmax(p_parameters->L.x, fmax(p_parameters->L.y, p_parameters->L.z));
+        if (!(p_traj->quantum > 0.0) || 2.0 * L_max / p_traj->quantum > (double)INT32_MAX)
+        {
+            fprintf(stderr, "Warning: traj_delta_tol does not fit the box into 32 bit coordinates, writing keyframes only\n");
+            p_traj->delta = false;
+        }
+        else
+        {
+            p_traj->r_ref = (struct Vec3D *)malloc(p_parameters->num_part * sizeof(struct Vec3D));
+            p_traj->moved = (uint32_t *)malloc(p_parameters->num_part * sizeof(uint32_t));
+            p_traj->delta_buffer = malloc(3 * p_parameters->num_part * sizeof(double));
+        }
+    }
+
+    struct TrajFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRAJ_MAGIC, sizeof(header.magic));
+    header.version = TRAJ_VERSION;
+    header.size_header = sizeof(header);
+    header.endian_tag = TRAJ_ENDIAN_TAG;
+    header.fields = p_traj->fields;
+    header.size_real = (uint32_t)p_traj->size_real;
+    header.num_part = p_parameters->num_part;
+    traj_write(p_traj, &header, sizeof(header));
+    return true;
+}
+
+// Write num_part*ncomp doubles as a block of the trajectory precision
+static void traj_write_block(struct Trajectory *p_traj, const double *data, size_t num_part, size_t ncomp)
+{
+    size_t n = num_part * ncomp;
+    if (p_traj->size_real == sizeof(float))
+    {
+        for (size_t i = 0; i < n; ++i)
+            p_traj->buffer[i] = (float)data[i];
+        traj_write(p_traj, p_traj->buffer, n * sizeof(float));
+    }
+    else
+        traj_write(p_traj, data, n * sizeof(double));
+    traj_write_padding(p_traj, n * p_traj->size_real);
+}
+
+// Write the positions of the particles that moved more than delta_tol since their last record and update the
+// reference positions. Velocity, omega and force of particles that are not stored would be stale, so they are only
+// stored in keyframes.
+static void traj_write_delta(struct Parameters *p_parameters, struct Trajectory *p_traj, struct Vectors *p_vectors, size_t step)
+{
+    size_t num_part = p_parameters->num_part;
+    struct Vec3D *r = p_vectors->r;
+    struct Vec3D *r_ref = p_traj->r_ref;
+    double tol_sq = p_traj->delta_tol * p_traj->delta_tol;
+    size_t num_moved = 0;
+    for (size_t i = 0; i < num_part; ++i)
+    {
+        double dx = r[i].x - r_ref[i].x, dy = r[i].y - r_ref[i].y, dz = r[i].z - r_ref[i].z;
+        if (dx * dx + dy * dy + dz * dz > tol_sq)
+            p_traj->moved[num_moved++] = (uint32_t)i;
+    }
+
+    struct TrajFrameHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRAJ_DELTA_MAGIC, sizeof(header.magic));
+    header.fields = TRAJ_FIELD_POSITION;
+    header.index = p_traj->num_frames;
+    header.step = step;
+    header.time = p_vectors->time;
+    header.size_frame = sizeof(header) + sizeof(struct TrajDeltaHeader) + traj_padded(num_moved, sizeof(uint32_t)) +
+                        traj_padded(3 * num_moved, sizeof(int32_t));
+    traj_write(p_traj, &header, sizeof(header));
+
+    struct TrajDeltaHeader delta = {num_moved, p_traj->quantum};
+    traj_write(p_traj, &delta, sizeof(delta));
+    traj_write(p_traj, p_traj->moved, num_moved * sizeof(uint32_t));
+    traj_write_padding(p_traj, num_moved * sizeof(uint32_t));
+
+    // the reference positions become exactly what a reader reconstructs
+    int32_t *q = (int32_t *)p_traj->delta_buffer;
+    for (size_t k = 0; k < num_moved; ++k)
+    {
+        size_t i = p_traj->moved[k];
+        q[3 * k] = (int32_t)lrint(r[i].x / p_traj->quantum);
+        q[3 * k + 1] = (int32_t)lrint(r[i].y / p_traj->quantum);
+        q[3 * k + 2] = (int32_t)lrint(r[i].z / p_traj->quantum);
+        r_ref[i] = (struct Vec3D){q[3 * k] * p_traj->quantum, q[3 * k + 1] * p_traj->quantum, q[3 * k + 2] * p_traj->quantum};
+    }
+    traj_write(p_traj, q, 3 * num_moved * sizeof(int32_t));
+    traj_write_padding(p_traj, 3 * num_moved * sizeof(int32_t));
+}
+
+void trajectory_write_frame(struct Parameters *p_parameters, struct Trajectory *p_traj, struct Vectors *p_vectors, size_t step)
+{
+    if (p_traj->p_file == NULL)
+        return;
+
+    size_t num_part = p_parameters->num_part;
+    if (p_traj->num_frames == p_traj->num_frames_max)
+    {
+        p_traj->num_frames_max = (p_traj->num_frames_max == 0 ? 1024 : 2 * p_traj->num_frames_max);
+        p_traj->frame_offset = (uint64_t *)realloc(p_traj->frame_offset, p_traj->num_frames_max * sizeof(uint64_t));
+    }
+    p_traj->frame_offset[p_traj->num_frames] = p_traj->offset;
+
+    if (p_traj->delta && p_traj->num_frames % p_traj->num_frames_key != 0)
+    {
+        traj_write_delta(p_parameters, p_traj, p_vectors, step);
+        p_traj->num_frames++;
+        return;
+    }
+
+    // struct Vec3D consists of 3 doubles, so the vector arrays are written as flat arrays
+    const double *data[TRAJ_NUM_FIELDS] = {(const double *)p_vectors->r, p_vectors->radius, (const double *)p_vectors->v,
+                                           (const double *)p_vectors->omega, (const double *)p_vectors->f};
+
+    struct TrajFrameHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRAJ_FRAME_MAGIC, sizeof(header.magic));
+    header.fields = p_traj->fields;
+    header.index = p_traj->num_frames;
+    header.step = step;
+    header.time = p_vectors->time;
+    header.size_frame = traj_frame_size(p_traj->fields, num_part, p_traj->size_real);
+    traj_write(p_traj, &header, sizeof(header));
+    for (size_t ifield = 0; ifield < TRAJ_NUM_FIELDS; ++ifield)
+        if (p_traj->fields & traj_field_order[ifield])
+            traj_write_block(p_traj, data[ifield], num_part, traj_field_ncomp[ifield]);
+
+    // delta frames refer to the positions as stored in this keyframe
+    if (p_traj->delta)
+        for (size_t i = 0; i < num_part; ++i)
+            p_traj->r_ref[i] = (p_traj->size_real == sizeof(float)
+                                    ? (struct Vec3D){(float)p_vectors->r[i].x, (float)p_vectors->r[i].y, (float)p_vectors->r[i].z}
+                                    : p_vectors->r[i]);
+    p_traj->num_frames++;
+}
+
+void trajectory_close(struct Trajectory *p_traj)
+{
+    if (p_traj->p_file != NULL)
+    {
+        struct TrajTrailer trailer;
+        memset(&trailer, 0, sizeof(trailer));
+        trailer.offset_index = p_traj->offset;
+        memcpy(trailer.magic, TRAJ_END_MAGIC, sizeof(trailer.magic));
+        uint64_t num_frames = p_traj->num_frames;
+        traj_write(p_traj, &num_frames, sizeof(num_frames));
+        traj_write(p_traj, p_traj->frame_offset, p_traj->num_frames * sizeof(uint64_t));
+        traj_write(p_traj, &trailer, sizeof(trailer));
+        if (fclose(p_traj->p_file) != 0)
+            fprintf(stderr, "Error: closing trajectory failed\n");
+    }
+    free(p_traj->frame_offset);
+    free(p_traj->buffer);
+    free(p_traj->r_ref);
+    free(p_traj->moved);
+    free(p_traj->delta_buffer);
+    memset(p_traj, 0, sizeof(*p_traj));
+}
+
+// Read n reals of size size_real from p_file into the doubles out
+static int traj_read_block(FILE *p_file, double *out, size_t n, size_t size_real, size_t size_block)
+{
+    if (size_real == sizeof(double))
+    {
+        if (fread(out, sizeof(double), n, p_file) != n)
+            return -1;
+    }
+    else
+    {
+        float *tmp = (float *)out; // converted in place from the back, a double takes two floats
+        if (fread(tmp, sizeof(float), n, p_file) != n)
+            return -1;
+        for (size_t i = n; i-- > 0;)
+            out[i] = (double)tmp[i];
+    }
+    return fseek(p_file, (long)(size_block - n * size_real), SEEK_CUR);
+}
+
+// Read n elements of size_elem bytes and skip the padding of the block
+static int traj_read_raw(FILE *p_file, void *out, size_t n, size_t size_elem)
+{
+    if (fread(out, size_elem, n, p_file) != n)
+        return -1;
+    return fseek(p_file, (long)(traj_padded(n, size_elem) - n * size_elem), SEEK_CUR);
+}
+
+// Apply a delta frame to the positions of the last frame read
+static int traj_read_delta(FILE *p_file, const struct TrajFrameHeader *p_frame, double *positions, size_t num_part,
+                           uint32_t *moved, double *buffer)
+{
+    struct TrajDeltaHeader delta;
+    if (fread(&delta, sizeof(delta), 1, p_file) != 1 || delta.num_moved > num_part)
+        return -1;
+    size_t n = delta.num_moved;
+    if (traj_read_raw(p_file, moved, n, sizeof(uint32_t)) != 0)
+        return -1;
+    for (size_t k = 0; k < n; ++k)
+        if (moved[k] >= num_part)
+            return -1;
+    int32_t *q = (int32_t *)buffer;
+    if (traj_read_raw(p_file, q, 3 * n, sizeof(int32_t)) != 0)
+        return -1;
+    for (size_t k = 0; k < 3 * n; ++k)
+        positions[3 * (size_t)moved[k / 3] + k % 3] = q[k] * delta.quantum;
+    // earlier files also stored further fields of the moved particles, which are skipped
+    size_t size_read = sizeof(*p_frame) + sizeof(delta) + traj_padded(n, sizeof(uint32_t)) + traj_padded(3 * n, sizeof(int32_t));
+    if (p_frame->size_frame < size_read)
+        return -1;
+    return fseek(p_file, (long)(p_frame->size_frame - size_read), SEEK_CUR);
+}
+
+long trajectory_export_xyz(const char *filename_in, const char *filename_out)
+{
+    FILE *p_in = fopen(filename_in, "rb");
+    if (p_in == NULL)
+    {
+        fprintf(stderr, "Error: cannot open %s\n", filename_in);
+        return -1;
+    }
+    struct TrajFileHeader header;
+    if (fread(&header, sizeof(header), 1, p_in) != 1 || memcmp(header.magic, TRAJ_MAGIC, sizeof(header.magic)) != 0 ||
+        header.endian_tag != TRAJ_ENDIAN_TAG || header.size_header != sizeof(header))
+    {
+        fprintf(stderr, "Error: %s is not a binary trajectory of this version and byte order\n", filename_in);
+        fclose(p_in);
+        return -1;
+    }
+    FILE *p_out = fopen(filename_out, "w");
+    if (p_out == NULL)
+    {
+        fprintf(stderr, "Error: cannot open %s for writing\n", filename_out);
+        fclose(p_in);
+        return -1;
+    }
+
+    size_t num_part = header.num_part, size_real = header.size_real;
+    double *data[TRAJ_NUM_FIELDS];
+    for (size_t ifield = 0; ifield < TRAJ_NUM_FIELDS; ++ifield)
+        data[ifield] = (double *)calloc(num_part * traj_field_ncomp[ifield], sizeof(double));
+    uint32_t *moved = (uint32_t *)malloc(num_part * sizeof(uint32_t));
+    double *buffer = (double *)malloc(3 * num_part * sizeof(double));
+
+    // every frame gets the same columns: delta frames hold no velocities and repeat the speed of the last keyframe
+    bool speed = (header.fields & TRAJ_FIELD_VELOCITY) != 0;
+    long num_frames = 0;
+    struct TrajFrameHeader frame;
+    while (fread(&frame, sizeof(frame), 1, p_in) == 1)
+    {
+        int error = 0;
+        bool keyframe = memcmp(frame.magic, TRAJ_FRAME_MAGIC, sizeof(frame.magic)) == 0;
+        if (keyframe)
+        {
+            for (size_t ifield = 0; ifield < TRAJ_NUM_FIELDS && !error; ++ifield)
+                if (frame.fields & traj_field_order[ifield])
+                    error = traj_read_block(p_in, data[ifield], num_part * traj_field_ncomp[ifield], size_real,
+                                            traj_block_size(num_part, traj_field_ncomp[ifield], size_real));
+        }
+        else if (memcmp(frame.magic, TRAJ_DELTA_MAGIC, sizeof(frame.magic)) == 0 && num_frames > 0)
+            error = traj_read_delta(p_in, &frame, data[0], num_part, moved, buffer);
+        else
+            break; // frame index of a closed file
+        if (error)
+            break; // truncated last frame of an interrupted run
+
+        // same layout as record_trajectories_xyz: position, radius and speed
+        const struct Vec3D *r = (const struct Vec3D *)data[0];
+        const struct Vec3D *v = (const struct Vec3D *)data[2];
+        fprintf(p_out, "%lu\n", (long unsigned)num_part);
+        fprintf(p_out, "time = %f\n", frame.time);
+        for (size_t i = 0; i < num_part; i++)
+        {
+            fprintf(p_out, "  C        %10.5f %10.5f %10.5f %10.5f", r[i].x, r[i].y, r[i].z, data[1][i]);
+            if (speed)
+                fprintf(p_out, " %10.5f", sqrt(v[i].x * v[i].x + v[i].y * v[i].y + v[i].z * v[i].z));
+            fprintf(p_out, "\n");
+        }
+        num_frames++;
+    }
+
+    for (size_t ifield = 0; ifield < TRAJ_NUM_FIELDS; ++ifield)
+        free(data[ifield]);
+    free(moved);
+    free(buffer);
+    fclose(p_in);
+    fclose(p_out);
+    return num_frames;
+}
@@ -0,0 +1,51 @@
+#ifndef TRAJECTORY_H_
+#define TRAJECTORY_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Open the trajectory file filename_xyz + ".pbt" and write its file header.
+ * Nothing is opened if traj_format is TRAJ_FORMAT_XYZ; frames are then written by @ref record_trajectories_xyz.
+ * 
+ * @param[in] p_parameters used members: filename_xyz, traj_format, traj_fields, traj_single_precision, num_part,
+ * traj_delta, traj_num_frames_key, traj_delta_tol, L
+ * @param[out] p_traj state of the open trajectory
+ * @return bool false if the file cannot be opened; p_traj is then closed
+ */
+bool trajectory_open(struct Parameters *p_parameters, struct Trajectory *p_traj);
+
+/**
+ * @brief Append a frame to the binary trajectory. Keyframes hold the selected fields of all particles. With traj_delta
+ * every traj_num_frames_key-th frame is a keyframe and the frames in between are delta frames with only the positions
+ * of the particles that moved more than traj_delta_tol since their last record (see @ref TrajDeltaHeader); a reader
+ * that applies the delta frames to the last keyframe gets every position to within traj_delta_tol. Velocity, omega
+ * and force are keyframe-only. The size drops by more than 10x only while few particles move, i.e. for a pile at
+ * rest; frames of the collapse, when most particles move, are about as large as keyframes.
+ * 
+ * @param[in] p_parameters used members: num_part
+ * @param[in,out] p_traj 
+ * @param[in] p_vectors used members: time, r, radius, v, omega, f
+ * @param[in] step time step of the frame
+ */
+void trajectory_write_frame(struct Parameters *p_parameters, struct Trajectory *p_traj, struct Vectors *p_vectors, size_t step);
+
+/**
+ * @brief Write the frame index and trailer, close the file and free the trajectory state
+ * 
+ * @param[in,out] p_traj 
+ */
+void trajectory_close(struct Trajectory *p_traj);
+
+/**
+ * @brief Convert a binary trajectory to the xyz format written by @ref record_trajectories_xyz. The speed column is
+ * written for every frame if the keyframes store velocities; delta frames repeat the speeds of the last keyframe.
+ * Frames are read one after the other, so files of interrupted runs (without index) can be converted as well.
+ * 
+ * @param[in] filename_in binary trajectory file
+ * @param[in] filename_out xyz file
+ * @return long number of frames converted, -1 on error
+ */
+long trajectory_export_xyz(const char *filename_in, const char *filename_out);
+
+#endif /* TRAJECTORY_H_ */
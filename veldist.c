@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "analysis.h"
+#include "histogram.h"
+#include "veldist.h"
+
+static size_t vd_group(const struct VelDistState *p_state, struct Parameters *p_parameters, const struct Snapshot *p_snap, size_t i)
+{
+    switch (p_state->split)
+    {
+    case VELDIST_SPLIT_REGION:
+    {
+        double dx = p_snap->r[i].x - 0.5 * p_parameters->L.x;
+        double dy = p_snap->r[i].y - 0.5 * p_parameters->L.y;
+        size_t g = (size_t)(sqrt(dx * dx + dy * dy) / p_state->r_max * (double)p_state->num_groups);
+        return g < p_state->num_groups ? g : p_state->num_groups - 1;
+    }
+    case VELDIST_SPLIT_PHASE:
+        return p_snap->phase < p_state->num_groups ? p_snap->phase : p_state->num_groups - 1;
+    default:
+        return 0;
+    }
+}
+
+static void vd_sample(struct Analysis *p_analysis, struct Parameters *p_parameters, const struct Snapshot *p_snap)
+{
+    struct VelDistState *p_state = (struct VelDistState *)p_analysis->state;
+    for (size_t i = 0; i < p_snap->num_part; ++i)
+    {
+        struct VelDistGroup *p_group = &p_state->groups[vd_group(p_state, p_parameters, p_snap, i)];
+        struct Vec3D v = p_snap->v[i];
+        double v_sq = v.x * v.x + v.y * v.y + v.z * v.z;
+        double R = p_snap->radius[i];
+        double m = p_parameters->density * (4.0 / 3.0) * PI * R * R * R;
+        histogram_add(&p_group->component[0], v.x);
+        histogram_add(&p_group->component[1], v.y);
+        histogram_add(&p_group->component[2], v.z);
+        histogram_add(&p_group->speed, sqrt(v_sq));
+        p_group->num += 1.0;
+        p_group->mass += m;
+        p_group->momentum.x += m * v.x;
+        p_group->momentum.y += m * v.y;
+        p_group->momentum.z += m * v.z;
+        p_group->m_v_sq += m * v_sq;
+    }
+}
+
+static void vd_merge(struct Analysis *p_analysis, const struct Analysis *p_other)
+{
+    struct VelDistState *p_state = (struct VelDistState *)p_analysis->state;
+    const struct VelDistState *p_state_other = (const struct VelDistState *)p_other->state;
+    for (size_t g = 0; g < p_state->num_groups; ++g)
+    {
+        struct VelDistGroup *p_group = &p_state->groups[g];
+        const struct VelDistGroup *p_group_other = &p_state_other->groups[g];
+        for (int c = 0; c < 3; ++c)
+            histogram_merge(&p_group->component[c], &p_group_other->component[c]);
+        histogram_merge(&p_group->speed, &p_group_other->speed);
+        p_group->num += p_group_other->num;
+        p_group->mass += p_group_other->mass;
+        p_group->momentum.x += p_group_other->momentum.x;
+        p_group->momentum.y += p_group_other->momentum.y;
+        p_group->momentum.z += p_group_other->momentum.z;
+        p_group->m_v_sq += p_group_other->m_v_sq;
+    }
+}
+
+// Mean velocity, granular temperature and its velocity variance (per unit mass) of a group
+static void vd_moments(const struct VelDistGroup *p_group, struct Vec3D *p_mean, double *p_Tg, double *p_theta)
+{
+    *p_mean = (struct Vec3D){0.0, 0.0, 0.0};
+    *p_Tg = *p_theta = 0.0;
+    if (p_group->num == 0.0 || p_group->mass == 0.0)
+        return;
+    struct Vec3D P = p_group->momentum;
+    *p_mean = (struct Vec3D){P.x / p_group->mass, P.y / p_group->mass, P.z / p_group->mass};
+    double fluct = p_group->m_v_sq - (P.x * P.x + P.y * P.y + P.z * P.z) / p_group->mass;
+    *p_Tg = fluct / (3.0 * p_group->num);
+    *p_theta = fluct / (3.0 * p_group->mass);
+}
+
+static double vd_gauss(double v, double mean, double theta)
+{
+    if (theta <= 0.0)
+        return 0.0;
+    return exp(-0.5 * (v - mean) * (v - mean) / theta) / sqrt(2.0 * PI * theta);
+}
+
+static double vd_maxwell(double s, double theta)
+{
+    if (theta <= 0.0)
+        return 0.0;
+    return 4.0 * PI * s * s * exp(-0.5 * s * s / theta) / pow(2.0 * PI * theta, 1.5);
+}
+
+static void vd_finish(struct Analysis *p_analysis, struct Parameters *p_parameters)
+{
+    struct VelDistState *p_state = (struct VelDistState *)p_analysis->state;
+    FILE *fv = fopen("data/velocity_pdf.csv", "w");
+    FILE *fs = fopen("data/speed_pdf.csv", "w");
+    FILE *fg = fopen("data/velocity_groups.csv", "w");
+    if (fv == NULL || fs == NULL || fg == NULL)
+    {
+        fprintf(stderr, "Error: cannot open data/velocity_pdf.csv, data/speed_pdf.csv or data/velocity_groups.csv for writing\n");
+        if (fv) fclose(fv);
+        if (fs) fclose(fs);
+        if (fg) fclose(fg);
+        return;
+    }
+    fprintf(fv, "group,v,vx,vy,vz,maxwell_vx,maxwell_vy,maxwell_vz\n");
+    fprintf(fs, "group,speed,pdf,maxwell\n");
+    fprintf(fg, "group,lo,hi,num,mean_vx,mean_vy,mean_vz,Tg\n");
+    for (size_t g = 0; g < p_state->num_groups; ++g)
+    {
+        const struct VelDistGroup *p_group = &p_state->groups[g];
+        struct Vec3D mean;
+        double Tg, theta;
+        vd_moments(p_group, &mean, &Tg, &theta);
+        const struct Histogram *c = p_group->component;
+        for (size_t b = 0; b < c[0].nbins; ++b)
+        {
+            double v = c[0].bin_centers[b];
+            fprintf(fv, "%lu,%g,%g,%g,%g,%g,%g,%g\n", (long unsigned)g, v, histogram_pdf(&c[0], b), histogram_pdf(&c[1], b),
+                    histogram_pdf(&c[2], b), vd_gauss(v, mean.x, theta), vd_gauss(v, mean.y, theta), vd_gauss(v, mean.z, theta));
+        }
+        for (size_t b = 0; b < p_group->speed.nbins; ++b)
+        {
+            double s = p_group->speed.bin_centers[b];
+            fprintf(fs, "%lu,%g,%g,%g\n", (long unsigned)g, s, histogram_pdf(&p_group->speed, b), vd_maxwell(s, theta));
+        }
+        double lo = 0.0, hi = 0.0;
+        if (p_state->split == VELDIST_SPLIT_REGION)
+        {
+            lo = g * p_state->r_max / (double)p_state->num_groups;
+            hi = (g + 1 < p_state->num_groups) ? (g + 1) * p_state->r_max / (double)p_state->num_groups : INFINITY;
+        }
+        else if (p_state->split == VELDIST_SPLIT_PHASE)
+            lo = hi = (double)g;
+        fprintf(fg, "%lu,%g,%g,%g,%g,%g,%g,%g\n", (long unsigned)g, lo, hi, p_group->num, mean.x, mean.y, mean.z, Tg);
+    }
+    fclose(fv);
+    fclose(fs);
+    fclose(fg);
+}
+
+static void vd_free(void *state)
+{
+    struct VelDistState *p_state = (struct VelDistState *)state;
+    if (p_state == NULL)
+        return;
+    if (p_state->groups)
+        for (size_t g = 0; g < p_state->num_groups; ++g)
+        {
+            for (int c = 0; c < 3; ++c)
+                histogram_free(&p_state->groups[g].component[c]);
+            histogram_free(&p_state->groups[g].speed);
+        }
+    free(p_state->groups);
+    free(p_state);
+}
+
+void veldist_register(struct Parameters *p_parameters, struct AnalysisSet *p_set)
+{
+    if (p_parameters->num_dt_veldist == 0 || p_parameters->veldist_num_bins == 0)
+        return;
+    struct VelDistState *p_state = (struct VelDistState *)calloc(1, sizeof(struct VelDistState));
+    if (p_state == NULL)
+        return;
+    p_state->split = p_parameters->veldist_split;
+    p_state->r_max = p_parameters->veldist_r_max;
+    p_state->num_groups = 1;
+    if (p_state->split == VELDIST_SPLIT_REGION && p_parameters->veldist_num_regions > 0)
+        p_state->num_groups = p_parameters->veldist_num_regions;
+    else if (p_state->split == VELDIST_SPLIT_PHASE && p_parameters->num_phases > 0)
+        p_state->num_groups = p_parameters->num_phases;
+    else
+        p_state->split = VELDIST_SPLIT_NONE;
+
+    double v_max = p_parameters->veldist_v_max;
+    size_t num_bins = p_parameters->veldist_num_bins;
+    p_state->groups = (struct VelDistGroup *)calloc(p_state->num_groups, sizeof(struct VelDistGroup));
+    bool ok = p_state->groups != NULL;
+    for (size_t g = 0; ok && g < p_state->num_groups; ++g)
+    {
+        for (int c = 0; c < 3; ++c)
+            ok = ok && histogram_alloc(&p_state->groups[g].component[c], num_bins, -v_max, v_max);
+        ok = ok && histogram_alloc(&p_state->groups[g].speed, num_bins, 0.0, v_max);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Error: failed to allocate the velocity distributions\n");
+        vd_free(p_state);
+        return;
+    }
+
+    struct Analysis analysis = {.name = "velocity distributions", .num_dt = p_parameters->num_dt_veldist, .final = false,
+                                .fields = 0u, .contacts = false, .state = p_state,
+                                .sample = vd_sample, .finish = vd_finish, .free = vd_free, .merge = vd_merge};
+    analysis_add(p_set, &analysis);
+}
@@ -0,0 +1,22 @@
+#ifndef VELDIST_H_
+#define VELDIST_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Register the velocity distributions as an analysis (if num_dt_veldist > 0). Every num_dt_veldist steps the
+ * velocity components and speeds of all particles are counted in preallocated histograms, per group of particles:
+ * all of them, annuli of width veldist_r_max / veldist_num_regions around the axis (the last one includes everything
+ * beyond) or the phase of the sample, see veldist_split. At the end of the run the distributions are written to
+ * data/velocity_pdf.csv (components) and data/speed_pdf.csv with Maxwellian reference curves for the measured
+ * granular temperature Tg of the group (3/2 Tg is the mean kinetic energy of the velocity fluctuations per particle);
+ * the speed reference ignores the mean velocity. data/velocity_groups.csv lists the groups with their mean velocity and Tg.
+ * 
+ * @param[in] p_parameters used members: num_dt_veldist, veldist_num_bins, veldist_v_max, veldist_split,
+ * veldist_num_regions, veldist_r_max, num_phases, density, L
+ * @param[in,out] p_set 
+ */
+void veldist_register(struct Parameters *p_parameters, struct AnalysisSet *p_set);
+
+#endif /* VELDIST_H_ */
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "constants.h"
+#include "structs.h"
+#include "vtk.h"
+
+#define VTK_PVD_TAIL "</Collection>\n</VTKFile>\n"
+#define VTK_VERTEX 1
+#define VTK_LINE 3
+
+// Scratch memory of at least size bytes
+static void *vtk_buffer(struct VtkSeries *p_vtk, size_t size)
+{
+    if (size > p_vtk->capacity)
+    {
+        p_vtk->capacity = size;
+        p_vtk->buffer = realloc(p_vtk->buffer, size);
+    }
+    return p_vtk->buffer;
+}
+
+static const char *vtk_byte_order(void)
+{
+    uint16_t one = 1;
+    return (*(uint8_t *)&one == 1 ? "LittleEndian" : "BigEndian");
+}
+
+// Binary mode: the tail is rewritten at an offset counted in bytes, which text mode breaks on Windows (\n to \r\n)
+static FILE *vtk_open_pvd(const char *filename)
+{
+    FILE *p_file = fopen(filename, "wb");
+    if (p_file == NULL)
+    {
+        fprintf(stderr, "Error: cannot open %s for writing, series not written\n", filename);
+        return NULL;
+    }
+    fprintf(p_file, "<?xml version=\"1.0\"?>\n<VTKFile type=\"Collection\" version=\"0.1\" byte_order=\"%s\">\n<Collection>\n",
+            vtk_byte_order());
+    fputs(VTK_PVD_TAIL, p_file);
+    fflush(p_file);
+    return p_file;
+}
+
+// Insert a data set before the closing tags, so the series is complete after every frame
+static void vtk_add_to_pvd(FILE *p_pvd, double time, const char *filename)
+{
+    const char *basename = strrchr(filename, '/');
+    basename = (basename != NULL ? basename + 1 : filename);
+    fseek(p_pvd, -(long)strlen(VTK_PVD_TAIL), SEEK_END);
+    fprintf(p_pvd, "<DataSet timestep=\"%.9g\" group=\"\" part=\"0\" file=\"%s\"/>\n", time, basename);
+    fputs(VTK_PVD_TAIL, p_pvd);
+    fflush(p_pvd);
+}
+
+void vtk_open(struct Parameters *p_parameters, struct VtkSeries *p_vtk)
+{
+    memset(p_vtk, 0, sizeof(*p_vtk));
+    if (p_parameters->traj_format != TRAJ_FORMAT_VTU)
+        return;
+    char filename[1100];
+    snprintf(filename, sizeof(filename), "%s.pvd", p_parameters->filename_xyz);
+    p_vtk->p_pvd = vtk_open_pvd(filename);
+    if (p_parameters->vtk_contacts)
+    {
+        snprintf(filename, sizeof(filename), "%s_contacts.pvd", p_parameters->filename_xyz);
+        p_vtk->p_pvd_contacts = vtk_open_pvd(filename);
+    }
+}
+
+static void vtk_write_header(FILE *p_file, size_t num_points, size_t num_cells)
+{
+    fprintf(p_file, "<?xml version=\"1.0\"?>\n<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"%s\" "
+                    "header_type=\"UInt64\">\n<UnstructuredGrid>\n<Piece NumberOfPoints=\"%lu\" NumberOfCells=\"%lu\">\n",
+            vtk_byte_order(), (long unsigned)num_points, (long unsigned)num_cells);
+}
+
+// Declare an appended data array and advance the offset past its size prefix and data
+static void vtk_declare(FILE *p_file, const struct VtkArray *p_array, uint64_t *p_offset)
+{
+    fprintf(p_file, "<DataArray type=\"%s\" Name=\"%s\" NumberOfComponents=\"%lu\" format=\"appended\" offset=\"%llu\"/>\n",
+            p_array->type, p_array->name, (long unsigned)p_array->ncomp, (unsigned long long)*p_offset);
+    *p_offset += sizeof(uint64_t) + p_array->size;
+}
+
+static void vtk_append(FILE *p_file, const void *data, uint64_t size)
+{
+    fwrite(&size, sizeof(size), 1, p_file);
+    if (size > 0 && fwrite(data, 1, size, p_file) != size)
+        fprintf(stderr, "Error: writing VTU file failed\n");
+}
+
+// Append n doubles as Float32
+static void vtk_append_float(struct VtkSeries *p_vtk, FILE *p_file, const double *data, size_t n)
+{
+    float *out = (float *)vtk_buffer(p_vtk, n * sizeof(float));
+    for (size_t k = 0; k < n; ++k)
+        out[k] = (float)data[k];
+    vtk_append(p_file, out, n * sizeof(float));
+}
+
+// Append cells of num_nodes nodes: connectivity, offsets and types
+static void vtk_append_cells(struct VtkSeries *p_vtk, FILE *p_file, const int64_t *connectivity, size_t num_cells,
+                             size_t num_nodes, uint8_t type)
+{
+    vtk_append(p_file, connectivity, num_cells * num_nodes * sizeof(int64_t));
+    int64_t *offsets = (int64_t *)vtk_buffer(p_vtk, num_cells * sizeof(int64_t));
+    for (size_t k = 0; k < num_cells; ++k)
+        offsets[k] = (int64_t)((k + 1) * num_nodes);
+    vtk_append(p_file, offsets, num_cells * sizeof(int64_t));
+    uint8_t *types = (uint8_t *)vtk_buffer(p_vtk, num_cells);
+    memset(types, type, num_cells);
+    vtk_append(p_file, types, num_cells);
+}
+
+static FILE *vtk_open_vtu(const char *filename)
+{
+    FILE *p_file = fopen(filename, "wb");
+    if (p_file == NULL)
+        fprintf(stderr, "Error: cannot open %s for writing\n", filename);
+    return p_file;
+}
+
+static void vtk_write_particles(struct VtkSeries *p_vtk, const char *filename, struct Snapshot *p_snap)
+{
+    FILE *p_file = vtk_open_vtu(filename);
+    if (p_file == NULL)
+        return;
+    size_t n = p_snap->num_part;
+    struct VtkArray radius = {"Float32", "radius", 1, n * sizeof(float)};
+    struct VtkArray velocity = {"Float32", "velocity", 3, 3 * n * sizeof(float)};
+    struct VtkArray omega = {"Float32", "omega", 3, 3 * n * sizeof(float)};
+    struct VtkArray force = {"Float32", "force", 3, 3 * n * sizeof(float)};
+    struct VtkArray type = {"Int32", "type", 1, n * sizeof(int32_t)};
+    struct VtkArray points = {"Float32", "position", 3, 3 * n * sizeof(float)};
+    struct VtkArray connectivity = {"Int64", "connectivity", 1, n * sizeof(int64_t)};
+    struct VtkArray offsets = {"Int64", "offsets", 1, n * sizeof(int64_t)};
+    struct VtkArray types = {"UInt8", "types", 1, n};
+
+    uint64_t offset = 0;
+    vtk_write_header(p_file, n, n);
+    fprintf(p_file, "<PointData Scalars=\"radius\" Vectors=\"velocity\">\n");
+    vtk_declare(p_file, &radius, &offset);
+    vtk_declare(p_file, &velocity, &offset);
+    if (p_snap->omega != NULL)
+        vtk_declare(p_file, &omega, &offset);
+    if (p_snap->f != NULL)
+        vtk_declare(p_file, &force, &offset);
+    vtk_declare(p_file, &type, &offset);
+    fprintf(p_file, "</PointData>\n<Points>\n");
+    vtk_declare(p_file, &points, &offset);
+    fprintf(p_file, "</Points>\n<Cells>\n");
+    vtk_declare(p_file, &connectivity, &offset);
+    vtk_declare(p_file, &offsets, &offset);
+    vtk_declare(p_file, &types, &offset);
+    fprintf(p_file, "</Cells>\n</Piece>\n</UnstructuredGrid>\n<AppendedData encoding=\"raw\">\n_");
+
+    // arrays in the order of their declaration
+    vtk_append_float(p_vtk, p_file, p_snap->radius, n);
+    vtk_append_float(p_vtk, p_file, (const double *)p_snap->v, 3 * n);
+    if (p_snap->omega != NULL)
+        vtk_append_float(p_vtk, p_file, (const double *)p_snap->omega, 3 * n);
+    if (p_snap->f != NULL)
+        vtk_append_float(p_vtk, p_file, (const double *)p_snap->f, 3 * n);
+    int32_t *types32 = (int32_t *)vtk_buffer(p_vtk, n * sizeof(int32_t));
+    for (size_t i = 0; i < n; ++i)
+        types32[i] = (int32_t)p_snap->type[i];
+    vtk_append(p_file, types32, n * sizeof(int32_t));
+    vtk_append_float(p_vtk, p_file, (const double *)p_snap->r, 3 * n);
+    int64_t *vertices = (int64_t *)malloc(n * sizeof(int64_t));
+    for (size_t i = 0; i < n; ++i)
+        vertices[i] = (int64_t)i;
+    vtk_append_cells(p_vtk, p_file, vertices, n, 1, VTK_VERTEX);
+    free(vertices);
+    fprintf(p_file, "\n</AppendedData>\n</VTKFile>\n");
+    if (fclose(p_file) != 0)
+        fprintf(stderr, "Error: closing %s failed\n", filename);
+}
+
+static void vtk_write_contacts(struct VtkSeries *p_vtk, const char *filename, struct Snapshot *p_snap)
+{
+    FILE *p_file = vtk_open_vtu(filename);
+    if (p_file == NULL)
+        return;
+    size_t n = p_snap->num_part, m = p_snap->num_contacts;
+    struct VtkArray fn = {"Float32", "fn", 1, m * sizeof(float)};
+    struct VtkArray ft = {"Float32", "ft", 1, m * sizeof(float)};
+    struct VtkArray points = {"Float32", "position", 3, 3 * n * sizeof(float)};
+    struct VtkArray connectivity = {"Int64", "connectivity", 1, 2 * m * sizeof(int64_t)};
+    struct VtkArray offsets = {"Int64", "offsets", 1, m * sizeof(int64_t)};
+    struct VtkArray types = {"UInt8", "types", 1, m};
+
+    uint64_t offset = 0;
+    vtk_write_header(p_file, n, m);
+    fprintf(p_file, "<CellData Scalars=\"fn\">\n");
+    vtk_declare(p_file, &fn, &offset);
+    vtk_declare(p_file, &ft, &offset);
+    fprintf(p_file, "</CellData>\n<Points>\n");
+    vtk_declare(p_file, &points, &offset);
+    fprintf(p_file, "</Points>\n<Cells>\n");
+    vtk_declare(p_file, &connectivity, &offset);
+    vtk_declare(p_file, &offsets, &offset);
+    vtk_declare(p_file, &types, &offset);
+    fprintf(p_file, "</Cells>\n</Piece>\n</UnstructuredGrid>\n<AppendedData encoding=\"raw\">\n_");
+
+    float *magnitude = (float *)vtk_buffer(p_vtk, m * sizeof(float));
+    for (size_t k = 0; k < m; ++k)
+        magnitude[k] = (float)sqrt(p_snap->fn_sq[k]);
+    vtk_append(p_file, magnitude, m * sizeof(float));
+    for (size_t k = 0; k < m; ++k)
+        magnitude[k] = (float)sqrt(p_snap->ft_sq[k]);
+    vtk_append(p_file, magnitude, m * sizeof(float));
+    vtk_append_float(p_vtk, p_file, (const double *)p_snap->r, 3 * n);
+    int64_t *lines = (int64_t *)malloc((2 * m + 1) * sizeof(int64_t));
+    for (size_t k = 0; k < m; ++k)
+    {
+        lines[2 * k] = (int64_t)p_snap->contacts[k].i;
+        lines[2 * k + 1] = (int64_t)p_snap->contacts[k].j;
+    }
+    vtk_append_cells(p_vtk, p_file, lines, m, 2, VTK_LINE);
+    free(lines);
+    fprintf(p_file, "\n</AppendedData>\n</VTKFile>\n");
+    if (fclose(p_file) != 0)
+        fprintf(stderr, "Error: closing %s failed\n", filename);
+}
+
+void vtk_write_frame(struct Parameters *p_parameters, struct VtkSeries *p_vtk, struct Snapshot *p_snap)
+{
+    if (p_vtk->p_pvd == NULL)
+        return;
+    char filename[1100];
+    snprintf(filename, sizeof(filename), "%s_%06lu.vtu", p_parameters->filename_xyz, (long unsigned)p_vtk->num_frames);
+    vtk_write_particles(p_vtk, filename, p_snap);
+    vtk_add_to_pvd(p_vtk->p_pvd, p_snap->time, filename);
+    if (p_vtk->p_pvd_contacts != NULL && p_snap->contacts != NULL)
+    {
+        snprintf(filename, sizeof(filename), "%s_contacts_%06lu.vtu", p_parameters->filename_xyz, (long unsigned)p_vtk->num_frames);
+        vtk_write_contacts(p_vtk, filename, p_snap);
+        vtk_add_to_pvd(p_vtk->p_pvd_contacts, p_snap->time, filename);
+    }
+    p_vtk->num_frames++;
+}
+
+void vtk_close(struct VtkSeries *p_vtk)
+{
+    if (p_vtk->p_pvd != NULL)
+        fclose(p_vtk->p_pvd);
+    if (p_vtk->p_pvd_contacts != NULL)
+        fclose(p_vtk->p_pvd_contacts);
+    free(p_vtk->buffer);
+    memset(p_vtk, 0, sizeof(*p_vtk));
+}
@@ -0,0 +1,35 @@
+#ifndef VTK_H_
+#define VTK_H_
+
+#include <stddef.h>
+
+/**
+ * @brief Open the series files filename_xyz + ".pvd" (and filename_xyz + "_contacts.pvd" if vtk_contacts).
+ * Nothing is opened if traj_format is not TRAJ_FORMAT_VTU. A series that cannot be opened is reported and not written.
+ * 
+ * @param[in] p_parameters used members: filename_xyz, traj_format, vtk_contacts
+ * @param[out] p_vtk state of the open series
+ */
+void vtk_open(struct Parameters *p_parameters, struct VtkSeries *p_vtk);
+
+/**
+ * @brief Write a frame as VTU file filename_xyz + "_<frame>.vtu" with appended raw binary data: the particles as
+ * vertices with radius, velocity, angular velocity, force and type. With vtk_contacts the contact network is written
+ * to filename_xyz + "_contacts_<frame>.vtu" as lines between the particle centers carrying the normal and tangential
+ * force magnitudes. Both frames are added to their .pvd series, which stays valid after every frame.
+ * 
+ * @param[in] p_parameters used members: filename_xyz, num_part
+ * @param[in,out] p_vtk 
+ * @param[in] p_snap used members: step, time, radius, r, v, omega, f, type, and contacts, num_contacts, fn_sq, ft_sq
+ * for the contact network
+ */
+void vtk_write_frame(struct Parameters *p_parameters, struct VtkSeries *p_vtk, struct Snapshot *p_snap);
+
+/**
+ * @brief Close the series files and free the series state
+ * 
+ * @param[in,out] p_vtk 
+ */
+void vtk_close(struct VtkSeries *p_vtk);
+
+#endif /* VTK_H_ */